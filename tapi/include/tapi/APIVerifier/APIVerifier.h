@@ -14,6 +14,7 @@
 #ifndef TAPI_APIVERIFIER_APIVERIFIER_H
 #define TAPI_APIVERIFIER_APIVERIFIER_H
 
+#include "tapi/APIVerifier/APIVerifierCache.h"
 #include "tapi/Core/APIVisitor.h"
 #include "tapi/Core/LLVM.h"
 #include "tapi/Defines.h"
@@ -53,9 +54,14 @@ public:
   APIVerifierConfiguration &getConfiguration() { return config; }
   bool hasErrorOccurred() const { return hasError; }
 
+  /// Skip the pairs of declarations the cache knows to be equivalent, and
+  /// record the ones proven equivalent by verify.
+  void setCache(APIVerifierCache *cache) { this->cache = cache; }
+
 private:
   DiagnosticsEngine &diag;
   APIVerifierConfiguration config;
+  APIVerifierCache *cache = nullptr;
   bool hasError = false;
 };
 
@@ -0,0 +1,73 @@
+//===- tapi/APIVerifier/APIVerifierCache.h - API Verifier Cache -*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Records the declarations the API verifier proved equivalent, so
+///        later runs can skip them while they don't change.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef TAPI_APIVERIFIER_APIVERIFIERCACHE_H
+#define TAPI_APIVERIFIER_APIVERIFIERCACHE_H
+
+#include "tapi/Defines.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+#include <cstdint>
+#include <mutex>
+
+TAPI_NAMESPACE_INTERNAL_BEGIN
+
+/// \brief Maps the USR of a declaration to the key of the last pair of
+/// definitions that was proven equivalent for it. The key combines the
+/// fingerprints of both definitions and the verifier options, so an entry
+/// goes stale as soon as either side changes.
+///
+/// Several verifiers running concurrently can share one cache.
+class APIVerifierCache {
+public:
+  /// \brief Load the entries of the cache at \p path. Nothing is loaded if
+  /// the cache doesn't exist or was written by a different version.
+  llvm::Error read(llvm::StringRef path);
+
+  /// \brief Write the cache to \p path.
+  llvm::Error write(llvm::StringRef path) const;
+
+  /// \brief Whether the pair identified by \p key was proven equivalent.
+  bool isKnownEquivalent(llvm::StringRef usr, uint64_t key) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(usr);
+    return it != entries.end() && it->second == key;
+  }
+
+  /// \brief Record that the pair identified by \p key is equivalent.
+  void addEquivalent(llvm::StringRef usr, uint64_t key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries[usr] = key;
+  }
+
+  /// \brief Forget the pair recorded for \p usr.
+  void remove(llvm::StringRef usr) {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.erase(usr);
+  }
+
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+  }
+
+private:
+  mutable std::mutex mutex;
+  llvm::StringMap<uint64_t> entries;
+};
+
+TAPI_NAMESPACE_INTERNAL_END
+
+#endif // TAPI_APIVERIFIER_APIVERIFIERCACHE_H
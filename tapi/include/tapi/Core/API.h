@@ -209,6 +209,10 @@ struct ObjCInstanceVariableRecord : APIRecord {
   static std::string createName(StringRef superClass, StringRef ivarName) {
     return (superClass + "." + ivarName).str();
   }
+  static StringRef createName(StringRef superClass, StringRef ivarName,
+                              SmallVectorImpl<char> &buffer) {
+    return (superClass + "." + ivarName).toStringRef(buffer);
+  }
 };
 
 struct ObjCMethodRecord : APIRecord {
@@ -507,6 +511,9 @@ public:
   }
 
   bool operator<(const API &other) const;
+  /// Describe the first record that differs from \p other, for example
+  /// "global '_foo'", or return None if both APIs are equal.
+  llvm::Optional<std::string> findFirstDifference(const API &other) const;
   // Expensive equality operator.
   bool operator==(const API &other) const;
   bool operator!=(const API &other) const { return !(*this == other); }
@@ -13,7 +13,12 @@
 
 #include "tapi/Core/APIVisitor.h"
 #include "tapi/Defines.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/StringSaver.h"
 #include "llvm/TextAPI/InterfaceFile.h"
+#include "llvm/TextAPI/SymbolSet.h"
+#include <vector>
 
 #ifndef TAPI_DRIVER_API2SYMBOLCONVERTER_H
 #define TAPI_DRIVER_API2SYMBOLCONVERTER_H
@@ -25,14 +30,48 @@ public:
   API2SymbolConverter(SymbolSet *symbolSet, const Target &triple,
                       const bool recordUndefs = false)
       : symbolSet(symbolSet), target(triple), recordUndefs(recordUndefs) {}
+
+  /// Convert the APIs of several targets. Call setTarget before visiting the
+  /// API of each target, and finish after the last one. Every symbol is then
+  /// added to \p symbolSet once, with all the targets it was found in. The
+  /// APIs don't need to outlive the converter.
+  explicit API2SymbolConverter(SymbolSet *symbolSet)
+      : symbolSet(symbolSet), mergeTargets(true) {}
+
+  void setTarget(const Target &triple, bool recordUndefs = false) {
+    target = triple;
+    this->recordUndefs = recordUndefs;
+  }
+  void finish();
+
   void visitGlobal(GlobalRecord &) override;
   void visitObjCInterface(ObjCInterfaceRecord &) override;
   void visitObjCCategory(ObjCCategoryRecord &) override;
 
 private:
+  struct PendingSymbol {
+    SymbolKind kind;
+    StringRef name;
+    SymbolFlags flags;
+    TargetList targets;
+  };
+
+  void addSymbol(SymbolKind kind, StringRef name, SymbolFlags flags);
+  void addIvars(StringRef className,
+                ArrayRef<ObjCInstanceVariableRecord *> ivars);
+
   SymbolSet *symbolSet;
-  const Target target;
-  const bool recordUndefs;
+  Target target;
+  bool recordUndefs = false;
+  const bool mergeTargets = false;
+
+  /// The symbols found so far when merging targets, in the order they were
+  /// first found.
+  std::vector<PendingSymbol> pendingSymbols;
+  llvm::DenseMap<llvm::SymbolsMapKey, unsigned> pendingIndex;
+  /// The names of the pending symbols.
+  llvm::BumpPtrAllocator allocator;
+  llvm::StringSaver names{allocator};
 };
 
 TAPI_NAMESPACE_INTERNAL_END
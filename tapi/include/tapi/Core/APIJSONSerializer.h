@@ -36,12 +36,20 @@ public:
       : api(api), options(options) {}
   ~APIJSONSerializer() {}
 
-  llvm::json::Object getJSONObject() const;
+  /// Write the API as a JSON object, e.g. as one element of an SDKDB.
+  void serialize(llvm::json::OStream &os) const;
 
+  /// Write the API as a JSON document with its format version.
   void serialize(raw_ostream &os) const;
 
   // static method to parse JSON into API.
   static llvm::Expected<API> parse(StringRef json);
+
+  /// Parse one API object written by serialize(json::OStream &), without a
+  /// format version. Only one record is held as a JSON value at a time.
+  static llvm::Expected<API> parseObject(StringRef json,
+                                         bool publicOnly = false,
+                                         llvm::Triple *triple = nullptr);
   static llvm::Expected<API> parse(llvm::json::Object *root,
                                    bool publicOnly = false,
                                    llvm::Triple *triple = nullptr);
@@ -0,0 +1,54 @@
+//===- FileIdentity.h - File Identity ---------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Identifies files on disk across runs of the tool.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef TAPI_CORE_FILE_IDENTITY_H
+#define TAPI_CORE_FILE_IDENTITY_H
+
+#include "tapi/Defines.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/VirtualFileSystem.h"
+#include <cstdint>
+
+TAPI_NAMESPACE_INTERNAL_BEGIN
+
+/// \brief Identity of a file on disk, used to detect changes between runs.
+struct FileIdentity {
+  uint64_t size = 0;
+  int64_t modificationTime = 0;
+  uint64_t inode = 0;
+
+  /// \brief Get the identity of the file at \p path, or None if it can't be
+  /// accessed.
+  static llvm::Optional<FileIdentity> get(llvm::StringRef path);
+
+  /// \brief Get the identity of the file at \p path in the virtual file system
+  /// \p fs, or None if it can't be accessed.
+  static llvm::Optional<FileIdentity> get(llvm::vfs::FileSystem &fs,
+                                          llvm::StringRef path);
+
+  bool operator==(const FileIdentity &other) const {
+    return size == other.size && modificationTime == other.modificationTime &&
+           inode == other.inode;
+  }
+  bool operator!=(const FileIdentity &other) const { return !(*this == other); }
+};
+
+llvm::json::Value toJSON(const FileIdentity &identity);
+bool fromJSON(const llvm::json::Value &value, FileIdentity &identity,
+              llvm::json::Path path);
+
+TAPI_NAMESPACE_INTERNAL_END
+
+#endif // TAPI_CORE_FILE_IDENTITY_H
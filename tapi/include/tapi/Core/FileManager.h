@@ -17,6 +17,8 @@
 #include "tapi/Core/LLVM.h"
 #include "tapi/Defines.h"
 #include "clang/Basic/FileManager.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
 
 TAPI_NAMESPACE_INTERNAL_BEGIN
 
@@ -38,8 +40,28 @@ public:
   /// \brief Check if a particular path is a symlink using directory_iterator.
   bool isSymlink(StringRef path);
 
+  /// \brief Check if a particular path may exist, based on a cached listing of
+  ///        its parent directory. A false result means the path doesn't exist,
+  ///        a true result still needs to be confirmed with exists().
+  bool mayExist(StringRef path);
+
+  /// \brief Drop the cached listings of all directories containing \p path.
+  ///        Must be called after creating files that mayExist() could be
+  ///        asked about.
+  void invalidateDirectoryListings(StringRef path);
+
 private:
+  struct DirectoryListing {
+    /// False if the directory couldn't be read.
+    bool isComplete = false;
+    /// Lower case entry names, to match the case insensitive file systems.
+    llvm::StringSet<> names;
+  };
+
+  const DirectoryListing &getDirectoryListing(StringRef directory);
+
   bool initWithVFS = false;
+  llvm::StringMap<DirectoryListing> directoryListings;
 };
 
 TAPI_NAMESPACE_INTERNAL_END
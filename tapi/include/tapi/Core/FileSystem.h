@@ -16,6 +16,7 @@
 
 #include "tapi/Core/LLVM.h"
 #include "tapi/Defines.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Twine.h"
 #include "llvm/Support/VirtualFileSystem.h"
@@ -56,6 +57,27 @@ protected:
 };
 
 
+// Set of directories that also contains everything below them. Lookups walk
+// a trie of path components, so they don't depend on the number of
+// directories in the set.
+class DirectoryPrefixSet {
+public:
+  void insert(StringRef directory);
+
+  // Check if the path or one of its parent directories is in the set.
+  bool contains(StringRef path) const;
+
+  bool empty() const { return root.children.empty() && !root.isInSet; }
+
+private:
+  struct Node {
+    llvm::StringMap<Node> children;
+    bool isInSet = false;
+  };
+
+  Node root;
+};
+
 // Path Masking Overlay File System.
 // Mask specific path from tapi and clang.
 class PathMaskingOverlayFileSystem : public MaskingOverlayFileSystem {
@@ -63,13 +85,13 @@ public:
   PathMaskingOverlayFileSystem(IntrusiveRefCntPtr<FileSystem> base);
 
   void addExtraMaskingDirectory(StringRef path) {
-    extraMaskingPath.emplace_back(path.str());
+    extraMaskingPaths.insert(path);
   }
 
 private:
   bool pathMasked(const Twine &path) const override;
 
-  std::vector<std::string> extraMaskingPath;
+  DirectoryPrefixSet extraMaskingPaths;
 };
 
 // PublicSDK Overlay File system.
@@ -14,8 +14,10 @@
 #ifndef TAPI_CORE_INTERFACE_FILE_MANAGER_H
 #define TAPI_CORE_INTERFACE_FILE_MANAGER_H
 
+#include "tapi/Core/FileIdentity.h"
 #include "tapi/Core/Registry.h"
 #include "tapi/Defines.h"
+#include "llvm/ADT/Optional.h"
 #include "llvm/TextAPI/InterfaceFile.h"
 #include <map>
 
@@ -26,14 +28,28 @@ class FileManager;
 class InterfaceFileManager {
 public:
   InterfaceFileManager(FileManager &fm, bool isVolatile);
+
+  /// \brief Use \p fm for the following reads and writes. The files read so
+  ///        far are kept and are only read again once they change on disk,
+  ///        which lets one manager serve several commands.
+  void setFileManager(FileManager &fm, bool isVolatile);
+
   Expected<APIs &> readFile(const std::string &path);
   Error writeFile(const std::string &path, const InterfaceFile *file,
                   FileType fileType) const;
 
 private:
-  FileManager &_fm;
+  struct Library {
+    APIs apis;
+    /// The identity of the file when it was read.
+    llvm::Optional<FileIdentity> identity;
+  };
+
+  FileManager *_fm;
   Registry _registry;
-  std::map<std::string, APIs> _libraries;
+  /// Keyed by absolute path, the working directory can change between the
+  /// commands that share this manager.
+  std::map<std::string, Library> _libraries;
   bool isVolatile;
 
   enum class WriteAction {
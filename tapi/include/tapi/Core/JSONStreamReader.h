@@ -0,0 +1,90 @@
+//===- tapi/Core/JSONStreamReader.h - JSON Stream Reader --------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines a pull reader that walks a JSON document token by token.
+///
+/// Unlike llvm::json::parse, the reader doesn't build the document in memory.
+/// Callers can still parse a part of the document, for example one element of
+/// a large array, with parseValue.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef TAPI_CORE_JSON_STREAM_READER_H
+#define TAPI_CORE_JSON_STREAM_READER_H
+
+#include "tapi/Core/LLVM.h"
+#include "tapi/Defines.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/JSON.h"
+#include <string>
+
+TAPI_NAMESPACE_INTERNAL_BEGIN
+
+class JSONStreamReader {
+public:
+  enum class Token {
+    ObjectBegin,
+    ObjectEnd,
+    ArrayBegin,
+    ArrayEnd,
+    Key,
+    String,
+    Number,
+    Boolean,
+    Null,
+    EndOfInput,
+  };
+
+  /// \brief Read the JSON document \p input, which must outlive the reader.
+  explicit JSONStreamReader(StringRef input) : input(input) {}
+
+  /// \brief Read the next token.
+  llvm::Expected<Token> next();
+
+  /// \brief The text of the last token: the unescaped text of a key or a
+  /// string, a number as written, and "true" or "false" for a boolean.
+  StringRef getValue() const { return value; }
+
+  /// \brief Skip the rest of the value whose first token was just returned
+  /// by next.
+  llvm::Error skipValue();
+
+  /// \brief Skip the rest of the value whose first token was just returned
+  /// by next, and return the text of the whole value.
+  llvm::Expected<StringRef> readRawValue();
+
+  /// \brief Parse the value whose first token was just returned by next.
+  llvm::Expected<llvm::json::Value> parseValue();
+
+private:
+  enum class Container { Object, Array };
+  enum class State { ExpectFirst, ExpectValue, AfterValue };
+
+  llvm::Expected<Token> readKey();
+  llvm::Expected<Token> readValue();
+  llvm::Error readString();
+  llvm::Error readUnicodeEscape(std::string &out);
+  Token closeContainer(Container kind);
+  void skipWhitespace();
+  llvm::Error makeError(const char *msg) const;
+
+  StringRef input;
+  size_t pos = 0;
+  size_t tokenStart = 0;
+  StringRef value;
+  std::string unescaped;
+  SmallVector<Container, 16> containers;
+  State state = State::ExpectValue;
+};
+
+TAPI_NAMESPACE_INTERNAL_END
+
+#endif // TAPI_CORE_JSON_STREAM_READER_H
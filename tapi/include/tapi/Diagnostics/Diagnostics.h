@@ -18,6 +18,8 @@
 #include "clang/Driver/DriverDiagnostic.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include <memory>
+#include <vector>
 
 namespace llvm {
 raw_fd_ostream &errs();
@@ -57,6 +59,7 @@ public:
   clang::DiagnosticBuilder report(unsigned diagID, const APILoc &loc);
   clang::DiagnosticBuilder report(clang::SourceLocation loc, unsigned diagID);
   void setWarningsAsErrors(bool value) { warningsAsErrors = value; }
+  bool getWarningsAsErrors() const { return warningsAsErrors; }
   void setErrorLimit(unsigned value) { diag->setErrorLimit(value); }
   bool hasErrorOccurred() const { return diag->hasErrorOccurred(); }
 
@@ -97,12 +100,25 @@ public:
 
   clang::DiagnosticIDs::Level getDiagnosticLevel(unsigned diagID);
 
+  /// Collect the diagnostics reported until stopBuffering() in \p buffer
+  /// instead of emitting them.
+  void startBuffering(std::vector<clang::StoredDiagnostic> &buffer);
+  void stopBuffering();
+
+  /// Emit a diagnostic that was collected while buffering.
+  void emit(const clang::StoredDiagnostic &storedDiag) {
+    diag->Report(storedDiag);
+  }
+
 private:
   IntrusiveRefCntPtr<clang::DiagnosticOptions> diagOpts;
   IntrusiveRefCntPtr<clang::DiagnosticsEngine> diag;
   clang::LangOptions langOpts;
   bool warningsAsErrors = false;
   llvm::DenseMap<unsigned, clang::DiagnosticIDs::Level> diagLevelMap;
+  std::unique_ptr<clang::DiagnosticConsumer> bufferingClient;
+  clang::DiagnosticConsumer *savedClient = nullptr;
+  bool savedOwnsClient = false;
 
   void setupSerializedDiagnostics(StringRef output,
                                   std::unique_ptr<raw_ostream> streamOwner);
@@ -17,8 +17,11 @@
 #include "tapi/Core/Path.h"
 #include "tapi/Defines.h"
 #include "tapi/Driver/ConfigurationFile.h"
+#include "tapi/Driver/Glob.h"
 #include "clang/Frontend/FrontendOptions.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/TextAPI/ArchitectureSet.h"
 #include "llvm/TextAPI/PackedVersion.h"
@@ -104,12 +107,17 @@ private:
   bool isiOSMac = false;
   bool isDriverKit = false;
   ConfigurationFile file;
-  std::map<std::string, const configuration::v1::FrameworkConfiguration *>
+  llvm::StringMap<const configuration::v1::FrameworkConfiguration *>
       pathToConfig;
+  /// The public-dylibs entries, split into exact install names and globs.
+  llvm::StringSet<> publicDylibNames;
+  GlobSet publicDylibGlobs;
   std::unique_ptr<configuration::v1::ProjectConfiguration> projectConfig;
   std::string rootPath;
   std::string projectName;
 
+  const configuration::v1::FrameworkConfiguration *
+  findFrameworkConfig(StringRef path) const;
   PathSeq updateDirectories(StringRef frameworkPath,
                             const PathSeq &paths) const;
   PathSeq updateSDKHeaderFiles(const PathSeq &paths) const;
@@ -28,6 +28,8 @@ TAPI_NAMESPACE_INTERNAL_BEGIN
 class DiagnosticsEngine;
 class FileManager;
 struct Framework;
+class ScanCache;
+struct ScanDirectoryEntry;
 enum class HeaderType;
 
 /// Directory Scanner mode.
@@ -64,6 +66,10 @@ public:
   // Access scanner internal.
   void setMode(ScannerMode scanMode) { mode = scanMode; }
   void setSplitHeaderDir(bool splitHeader) { useSplitHeaderDir = splitHeader; }
+  // Reuse the directory listings and binary types of unchanged directories
+  // and binaries. This covers every directory the scanner reads; tools that
+  // walk directories themselves, like stubify, don't use the cache.
+  void setCache(ScanCache *scanCache) { cache = scanCache; }
 
   // Get scanner output.
   std::vector<Framework> takeResult();
@@ -74,7 +80,14 @@ public:
 
 private:
   // Private helper functions.
-  Expected<bool> isDynamicLibrary(StringRef path) const;
+  bool readDirectory(StringRef directory,
+                     std::vector<ScanDirectoryEntry> &entries,
+                     bool skipMissing) const;
+  bool isSymlink(const ScanDirectoryEntry &entry) const;
+  bool isDirectory(const ScanDirectoryEntry &entry) const;
+  bool exists(const ScanDirectoryEntry &entry) const;
+  void addBinary(Framework &framework, StringRef path) const;
+  bool identifyBinaries();
 
   Framework &getOrCreateFramework(StringRef path,
                                   std::vector<Framework> &frameworks) const;
@@ -110,6 +123,11 @@ private:
   ScannerMode mode;
   std::vector<Framework> frameworks;
   bool useSplitHeaderDir = false;
+  ScanCache *cache = nullptr;
+
+  // Binaries found while walking the directories. They are added to their
+  // framework right away and identified in parallel once the walk is done.
+  mutable std::vector<std::string> binaries;
 };
 
 TAPI_NAMESPACE_INTERNAL_END
@@ -24,6 +24,7 @@ raw_fd_ostream &errs();
 
 TAPI_NAMESPACE_INTERNAL_BEGIN
 
+class InterfaceFileManager;
 class Options;
 
 class Driver {
@@ -36,7 +37,10 @@ private:
 
 public:
   /// \brief Parses the command line options and performs the requested action.
-  static bool run(llvm::ArrayRef<const char *> args);
+  ///        The commands read interface files through \p interfaceMgr if it
+  ///        is set, so the serve mode can keep them across commands.
+  static bool run(llvm::ArrayRef<const char *> args,
+                  InterfaceFileManager *interfaceMgr = nullptr);
 
   Driver() = delete;
 
@@ -87,6 +91,14 @@ public:
 
     APIVerify() = delete;
   };
+
+  class Serve {
+  public:
+    /// \brief Run the commands read from the standard input in this process.
+    static bool run(DiagnosticsEngine &diag, Options &opts);
+
+    Serve() = delete;
+  };
 };
 
 TAPI_NAMESPACE_INTERNAL_END
@@ -7,22 +7,78 @@
 //===----------------------------------------------------------------------===//
 ///
 /// \file
-/// \brief A simple glob to regex converter.
+/// \brief A simple glob to regex converter and a matcher for sets of globs.
 ///
 //===----------------------------------------------------------------------===//
 
 #ifndef TAPI_CORE_GLOB_H
 #define TAPI_CORE_GLOB_H
 
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/Regex.h"
 #include "tapi/Defines.h"
+#include <string>
+#include <vector>
 
 TAPI_NAMESPACE_INTERNAL_BEGIN
 
 llvm::Expected<llvm::Regex> createRegexFromGlob(llvm::StringRef glob);
 
+/// \brief Matches paths against many globs in a single pass.
+///
+/// All globs are compiled into one nondeterministic automaton, which is
+/// simulated over the path once. The globs have the same meaning as the ones
+/// accepted by createRegexFromGlob.
+class GlobSet {
+public:
+  /// \brief Add a glob to the set. Fails if \p glob has no wildcard.
+  llvm::Error add(llvm::StringRef glob);
+
+  /// \brief Return the number of globs in the set.
+  size_t size() const { return globs.size(); }
+
+  /// \brief Return the glob with the given index.
+  llvm::StringRef str(unsigned index) const { return globs[index]; }
+
+  /// \brief Collect the indices of all globs that match \p path, in the order
+  /// the globs were added.
+  void match(llvm::StringRef path,
+             llvm::SmallVectorImpl<unsigned> &matches) const;
+
+private:
+  enum class TokenKind : uint8_t {
+    /// A character that has to match exactly.
+    Literal,
+    /// '?' matches any character.
+    AnyChar,
+    /// '*' matches any sequence of characters within a path component.
+    Star,
+    /// '**' as a path component matches any number of path components.
+    GlobStar,
+    /// The end of a glob.
+    Accept,
+  };
+
+  struct Token {
+    TokenKind kind;
+    char c;
+    /// The glob index for Accept tokens.
+    unsigned glob;
+  };
+
+  /// The tokens of all globs, one glob after the other. Every token has two
+  /// automaton states: 2 * i before the token is matched and 2 * i + 1 while
+  /// a globstar is in the middle of a path component.
+  std::vector<Token> tokens;
+
+  /// The index of the first token of each glob.
+  std::vector<unsigned> starts;
+
+  std::vector<std::string> globs;
+};
+
 TAPI_NAMESPACE_INTERNAL_END
 
 #endif // TAPI_CORE_GLOB_H
@@ -21,6 +21,8 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/Regex.h"
+#include <map>
+#include <vector>
 
 TAPI_NAMESPACE_INTERNAL_BEGIN
 
@@ -41,6 +43,36 @@ private:
   bool foundMatch{false};
 };
 
+/// \brief The exclude globs for all header types, matched in a single pass
+/// over each header path.
+class HeaderGlobSet {
+public:
+  /// \brief Add a glob for headers of the given type. Fails if \p globString
+  /// is not a glob.
+  llvm::Error add(StringRef globString, HeaderType type);
+
+  /// \brief Check if any glob matches the header. Every matching glob is
+  /// recorded as used.
+  bool match(const HeaderFile &header);
+
+  /// \brief Return the globs that didn't match any header, in the order they
+  /// were added.
+  std::vector<StringRef> getUnmatchedGlobs() const;
+
+private:
+  struct GlobInfo {
+    HeaderType type;
+    unsigned index;
+    bool foundMatch;
+  };
+
+  /// One automaton per header type.
+  std::map<HeaderType, GlobSet> globSets;
+  /// The globs of each header type, indexed like the automaton.
+  std::map<HeaderType, std::vector<unsigned>> globIndices;
+  std::vector<GlobInfo> globs;
+};
+
 TAPI_NAMESPACE_INTERNAL_END
 
 #endif // TAPI_CORE_HEADERGLOB_H
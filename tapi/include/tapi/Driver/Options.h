@@ -29,6 +29,8 @@
 
 TAPI_NAMESPACE_INTERNAL_BEGIN
 
+class InterfaceFileManager;
+
 using Macro = std::pair<std::string, bool /*isUndef*/>;
 
 /// \brief A list of supported TAPI commands.
@@ -75,6 +77,9 @@ struct DriverOptions {
   /// \brief Print hidden options too.
   bool printHelpHidden = false;
 
+  /// \brief Run commands read from the standard input until it is closed.
+  bool serve = false;
+
   /// \brief List of input paths.
   PathSeq inputs;
 
@@ -287,6 +292,13 @@ struct TAPIOptions {
   /// \brief Delete private frameworks.
   bool deletePrivateFrameworks = false;
 
+  /// \brief Manifest used to skip unchanged inputs when stubifying a
+  /// directory.
+  std::string stubManifestPath;
+
+  /// \brief Cache of the directory scanner, reused by the next run.
+  std::string scanCachePath;
+
 
   /// \brief Specify the output file type.
   llvm::MachO::FileType fileType = llvm::MachO::FileType::TBD_V5;
@@ -402,6 +414,10 @@ public:
   TAPIOptions tapiOptions;
   SDKDBOptions sdkdbOptions;
 
+  /// \brief The interface file manager shared by the commands of the serve
+  ///        mode, or null.
+  InterfaceFileManager *interfaceMgr = nullptr;
+
   Options() = delete;
 
   /// \brief Constructor for options.
@@ -409,6 +425,9 @@ public:
 
   FileManager &getFileManager() const { return *fm; }
 
+  /// \brief The program name, without the directory.
+  StringRef getProgramName() const { return programName; }
+
   /// \brief Print the help depending on the recognized coomand.
   void printHelp() const;
 
@@ -56,6 +56,8 @@ struct FrontendJob {
   std::vector<std::string> clangExtraArgs;
   HeaderType type;
   llvm::Optional<std::string> clangExecutablePath;
+  /// Where clang prints its diagnostics, the standard error if not set.
+  llvm::raw_ostream *diagnosticStream = nullptr;
   std::unique_ptr<SymbolVerifier> verifier =
       std::make_unique<SymbolVerifier>(SymbolVerifier());
 };
@@ -22,6 +22,10 @@
 #include "llvm/Support/Error.h"
 #include "llvm/Support/MemoryBuffer.h"
 
+namespace llvm {
+class BitstreamCursor;
+} // end namespace llvm
+
 TAPI_NAMESPACE_INTERNAL_BEGIN
 
 struct SDKDBBitcodeMaterializeOption {
@@ -48,6 +52,10 @@ public:
   // Materialize all information from bitcode using SDKDBBuilder.
   llvm::Error materialize(SDKDBBuilder &builder) const;
 
+  // Materialize only the SDKDB for the target using SDKDBBuilder.
+  llvm::Error materialize(SDKDBBuilder &builder,
+                          const llvm::Triple &target) const;
+
   // Get the version of SDKDB.
   std::string getSDKDBVersion() const;
 
@@ -76,6 +84,7 @@ public:
   ~SDKDBBitcodeReader();
 
 private:
+  friend class SDKDBBitcodeView;
 
   SDKDBBitcodeReader(const SDKDBBitcodeReader &) = delete;
 
@@ -84,6 +93,99 @@ private:
   Implementation &impl;
 };
 
+/// Read-only view of an SDKDB bitcode file.
+///
+/// The view never builds an SDKDBBuilder. All the strings it returns point
+/// into the IDENTIFIER block of the input buffer, which must outlive the view.
+/// The API blocks are indexed once when the view is created and are only
+/// decoded, one at a time, when a client asks for them.
+class SDKDBBitcodeView {
+public:
+  /// Handle to one API block in the bitcode.
+  struct APIBlock {
+    // Bit offset of the content of the SDKDB block that holds the block.
+    uint64_t sdkdbOffset = 0;
+    // Bit offset of the block inside its SDKDB block.
+    uint64_t offset = 0;
+    StringRef installName;
+    StringRef projectName;
+    FileType fileType = FileType::Invalid;
+    bool hasBinaryInfo = false;
+    bool isTwoLevelNamespace = false;
+    // Number of top level records, used to order the blocks like SDKDB::api().
+    unsigned numGlobals = 0;
+    unsigned numInterfaces = 0;
+    unsigned numProtocols = 0;
+    unsigned numEnums = 0;
+  };
+
+  /// All API blocks for one target, in storage order. SDKDB blocks with
+  /// compatible triples are merged into one target, like SDKDBBuilder does.
+  struct TargetBlock {
+    llvm::Triple target;
+    std::vector<APIBlock> apis;
+  };
+
+  // Helper function to create SDKDBBitcodeView.
+  static llvm::Expected<std::unique_ptr<SDKDBBitcodeView>>
+  get(llvm::MemoryBufferRef input);
+
+  // Get the version of SDKDB.
+  std::string getSDKDBVersion() const;
+
+  // Get the build verison of the SDKDB.
+  std::string getBuildVersion() const;
+
+  // If the SDKDB is public only.
+  bool isPublicOnly() const;
+
+  // If the SDKDB has no objc metadata.
+  bool noObjCMetadata() const;
+
+  // Get a vector of all the projects that had error when producing this SDKDB.
+  const std::vector<std::string> &getProjectsWithError() const;
+
+  // Get the target blocks in storage order.
+  llvm::ArrayRef<TargetBlock> targets() const { return targetBlocks; }
+
+  // Decode a single API block into api. The API must be created for the
+  // target of the block.
+  llvm::Error loadAPI(const TargetBlock &target, const APIBlock &block,
+                      API &api) const;
+
+  // Decode the selected API blocks one at a time, in the same order as
+  // SDKDB::api() would return them after materialization.
+  llvm::Error
+  forEachAPI(const TargetBlock &target,
+             const SDKDBBitcodeMaterializeOption &option,
+             llvm::function_ref<llvm::Error(const API &)> callback) const;
+
+  // Write the same output as SDKDBBuilder::serialize() on the materialized
+  // SDKDB, without materializing it. The diagnostics reported while
+  // materializing are reported to diag.
+  llvm::Error serialize(raw_ostream &os, bool compact,
+                        const SDKDBBitcodeMaterializeOption &option,
+                        DiagnosticsEngine &diag) const;
+
+  SDKDBBitcodeView(llvm::MemoryBufferRef input, llvm::Error &err);
+  ~SDKDBBitcodeView();
+
+private:
+  SDKDBBitcodeView(const SDKDBBitcodeView &) = delete;
+
+  llvm::Error indexAPIBlocks();
+  llvm::Error indexSDKDBBlock(llvm::BitstreamCursor &cursor);
+  llvm::Expected<APIBlock> indexAPIBlock(llvm::BitstreamCursor &cursor) const;
+  TargetBlock &getTargetBlock(const llvm::Triple &triple);
+  void reportConflictingInstallNames(
+      const TargetBlock &target, const SDKDBBitcodeMaterializeOption &option,
+      DiagnosticsEngine &diag) const;
+
+  llvm::MemoryBufferRef input;
+  std::unique_ptr<SDKDBBitcodeReader> reader;
+  std::vector<TargetBlock> targetBlocks;
+};
+
 TAPI_NAMESPACE_INTERNAL_END
 
 #endif /* TAPI_SDKDB_BITCODE_READER_H */
@@ -26,6 +26,7 @@
 
 TAPI_NAMESPACE_INTERNAL_BEGIN
 
+class SDKDBBitcodeReader;
 class SDKDBBuilder;
 
 
@@ -356,6 +357,15 @@ public:
 
   void buildLookupTables();
   bool diagnoseDifferences(SDKDBBuilder &baseline);
+
+  /// Compare the bitcode SDKDB \p test against \p baseline one target at a
+  /// time. Only a single target from each side is materialized at once, but
+  /// the diagnostics are the same as materializing both and calling
+  /// diagnoseDifferences(). If an SDKDB can't be read, \p baselineFailed
+  /// tells which one.
+  llvm::Expected<bool> diagnoseDifferences(const SDKDBBitcodeReader &test,
+                                           const SDKDBBitcodeReader &baseline,
+                                           bool &baselineFailed);
   void setReportNewAPIasError(bool val);
   void setNoNewAPI(bool val);
   void setDiagnoseFrontendAPI(bool val) { shouldDiagnoseFrontendAPI = val; }
@@ -366,6 +376,9 @@ public:
   }
 
 private:
+  void diagnoseDifferences(const SDKDB &baseline,
+                           const CompareConfigFileReader *configReader);
+
   DiagnosticsEngine &diag;
   SDKDBBuilderOptions options;
   std::string buildVersion;
@@ -12,12 +12,19 @@
 //===----------------------------------------------------------------------===//
 
 #include "tapi/APIVerifier/APIVerifier.h"
+#include "DeclFingerprint.h"
 #include "TAPIStructuralEquivalence.h"
 #include "clang/AST/Decl.h"
 #include "clang/AST/Type.h"
+#include "clang/Index/USRGeneration.h"
 #include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/YAMLTraits.h"
+#include "llvm/Support/xxhash.h"
 
 using namespace llvm;
 using namespace clang;
@@ -62,6 +69,40 @@ void APIVerifierConfiguration::writeConfig(raw_ostream &os) {
   yout << *this;
 }
 
+/// The number of top-level decl pairs compared by one context.
+static constexpr size_t DeclPairsPerBatch = 256;
+
+/// Hash the options that change the result of comparing a pair of decls.
+static uint64_t hashOptions(const APIVerifierConfiguration &Config,
+                            unsigned Depth, bool DiagMissingAPI) {
+  std::vector<std::string> Ignored(Config.IgnoreObjCClasses);
+  std::vector<APIVerifierConfiguration::BridgeTypes> Bridged(
+      Config.BridgeObjCClasses);
+  llvm::sort(Ignored);
+  llvm::sort(Bridged);
+
+  std::string Options;
+  raw_string_ostream OS(Options);
+  OS << Depth << ' ' << DiagMissingAPI << '\0';
+  for (const auto &Name : Ignored)
+    OS << Name << '\0';
+  OS << '\0';
+  for (const auto &Bridge : Bridged)
+    OS << Bridge.first << '\0' << Bridge.second << '\0';
+  return xxHash64(OS.str());
+}
+
+/// Combine the fingerprints of a pair of decls with the options into the key
+/// of the pair in the cache.
+static uint64_t getCacheKey(uint64_t Fingerprint1, uint64_t Fingerprint2,
+                            uint64_t Options) {
+  uint8_t Buffer[24];
+  support::endian::write64le(Buffer, Fingerprint1);
+  support::endian::write64le(Buffer + 8, Fingerprint2);
+  support::endian::write64le(Buffer + 16, Options);
+  return xxHash64(makeArrayRef(Buffer));
+}
+
 void APIVerifier::verify(FrontendContext &api1, FrontendContext &api2,
                          unsigned depth, bool external,
                          APIVerifierDiagStyle style, bool diagMissingAPI,
@@ -142,13 +183,14 @@ void APIVerifier::verify(FrontendContext &api1, FrontendContext &api2,
     if (!record)
       continue; // allow missing enum.
     addAPIToCompare(record, it.second);
+    StringMap<const EnumConstantRecord *> constants;
+    for (const auto *c1 : record->constants)
+      constants.try_emplace(c1->name, c1);
     for (const auto *c2 : it.second->constants) {
-      const auto c1 = find_if(record->constants, [&](const auto *c) {
-        return c->name == c2->name;
-      });
-      if (c1 == record->constants.end())
+      const auto *c1 = constants.lookup(c2->name);
+      if (!c1)
         continue; // allow missing enum constant.
-      addAPIToCompare(*c1, c2);
+      addAPIToCompare(c1, c2);
     }
   }
 
@@ -184,8 +226,100 @@ void APIVerifier::verify(FrontendContext &api1, FrontendContext &api2,
                       R.first->getLocation().getRawEncoding();
              });
 
-  hasError |=
-      equivalence.diagnoseStructurallyEquivalent(std::move(DeclToCompare));
+  equivalence.setDeclsToCompare(DeclToCompare);
+  auto DeclPairs = equivalence.getDeclsToCompare();
+
+  // Fingerprint the decls up front, so the contexts only look up the
+  // fingerprints while comparing, possibly concurrently.
+  DeclFingerprints Fingerprints1, Fingerprints2;
+  for (const auto &Pair : DeclPairs) {
+    Fingerprints1.get(Pair.first);
+    Fingerprints2.get(Pair.second);
+  }
+  equivalence.setFingerprints(&Fingerprints1, &Fingerprints2);
+
+  // Skip the pairs a previous run proved equivalent. Only the pairs whose
+  // result depends on nothing but their definitions are cached: skipping
+  // external headers makes it depend on where the decls are declared, and
+  // avoiding cascading diagnostics on the other pairs that are compared.
+  std::vector<StructuralEquivalenceContext::DeclPair> UncachedPairs;
+  std::vector<std::pair<std::string, uint64_t>> CacheKeys;
+  if (cache && external && !avoidCascadingDiags) {
+    auto Options = hashOptions(config, depth, diagMissingAPI);
+    for (const auto &Pair : DeclPairs) {
+      SmallString<128> USR;
+      auto Fingerprint1 = Fingerprints1.lookup(Pair.first);
+      auto Fingerprint2 = Fingerprints2.lookup(Pair.second);
+      if (!Fingerprint1 || !Fingerprint2 ||
+          index::generateUSRForDecl(Pair.first, USR)) {
+        UncachedPairs.push_back(Pair);
+        CacheKeys.emplace_back();
+        continue;
+      }
+
+      auto Key = getCacheKey(*Fingerprint1, *Fingerprint2, Options);
+      if (cache->isKnownEquivalent(USR, Key))
+        continue;
+
+      UncachedPairs.push_back(Pair);
+      CacheKeys.emplace_back(std::string(USR), Key);
+    }
+    DeclPairs = UncachedPairs;
+  }
+
+  SmallVector<bool, 0> Equivalent(DeclPairs.size());
+  auto updateCache = [&]() {
+    for (size_t I = 0, E = CacheKeys.size(); I != E; ++I) {
+      const auto &Entry = CacheKeys[I];
+      if (Entry.first.empty())
+        continue;
+      if (Equivalent[I])
+        cache->addEquivalent(Entry.first, Entry.second);
+      else
+        cache->remove(Entry.first);
+    }
+  };
+
+  // Compare large sets of decls in fixed size batches, each with its own
+  // context, and emit the diagnostics batch by batch in source order. Lazily
+  // deserialized ASTs can't be read concurrently.
+  if (DeclPairs.size() <= DeclPairsPerBatch || api1.ast->getExternalSource() ||
+      api2.ast->getExternalSource()) {
+    equivalence.diagnoseStructurallyEquivalent(DeclPairs, Equivalent);
+    hasError |= equivalence.hasErrorOccurred();
+    updateCache();
+    return;
+  }
+
+  SharedEquivalenceState Shared;
+  std::vector<std::unique_ptr<StructuralEquivalenceContext>> Batches;
+  for (size_t I = 0; I < DeclPairs.size(); I += DeclPairsPerBatch) {
+    auto Batch = std::make_unique<StructuralEquivalenceContext>(
+        config, diag, &api1, &api2,
+        /*StrictTypeSpelling=*/false, /*DiagStyle=*/style,
+        /*CheckExternalHeaders=*/external, /*DiagMissingAPI*/ diagMissingAPI,
+        /*EmitCascadingDiags=*/!avoidCascadingDiags);
+    Batch->setDiagnosticDepth(depth);
+    Batch->setDeclsToCompare(equivalence.getDeclsToCompare());
+    Batch->setSharedState(&Shared);
+    Batch->setFingerprints(&Fingerprints1, &Fingerprints2);
+    Batches.emplace_back(std::move(Batch));
+  }
+
+  parallelFor(0, Batches.size(), [&](size_t I) {
+    Batches[I]->diagnoseStructurallyEquivalent(
+        DeclPairs.slice(I * DeclPairsPerBatch).take_front(DeclPairsPerBatch),
+        makeMutableArrayRef(Equivalent)
+            .slice(I * DeclPairsPerBatch)
+            .take_front(DeclPairsPerBatch));
+  });
+
+  hasError |= equivalence.hasErrorOccurred();
+  for (auto &Batch : Batches) {
+    Batch->emitDeferredDiagnostics();
+    hasError |= Batch->hasErrorOccurred();
+  }
+  updateCache();
 }
 
 TAPI_NAMESPACE_INTERNAL_END
@@ -0,0 +1,89 @@
+//===- lib/APIVerifier/APIVerifierCache.cpp - API Verifier Cache -*- C++ -*-==//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Implements the API verifier cache.
+///
+//===----------------------------------------------------------------------===//
+
+#include "tapi/APIVerifier/APIVerifierCache.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+
+TAPI_NAMESPACE_INTERNAL_BEGIN
+
+/// Bump the version whenever the fingerprints of declarations change.
+static constexpr int64_t cacheVersion = 1;
+
+Error APIVerifierCache::read(StringRef path) {
+  auto bufferOrErr = MemoryBuffer::getFile(path, /*IsText=*/true);
+  if (auto ec = bufferOrErr.getError()) {
+    // There is no cache before the first run.
+    if (ec == std::errc::no_such_file_or_directory)
+      return Error::success();
+    return errorCodeToError(ec);
+  }
+
+  auto value = json::parse(bufferOrErr.get()->getBuffer());
+  if (!value)
+    return value.takeError();
+
+  auto malformed = [&]() {
+    return make_error<StringError>("malformed API verifier cache",
+                                   inconvertibleErrorCode());
+  };
+
+  auto *root = value->getAsObject();
+  if (!root)
+    return malformed();
+
+  if (root->getInteger("version") != cacheVersion)
+    return Error::success();
+
+  auto *decls = root->getObject("decls");
+  if (!decls)
+    return malformed();
+
+  for (const auto &decl : *decls) {
+    auto str = decl.second.getAsString();
+    uint64_t key;
+    if (!str || str->getAsInteger(16, key))
+      return malformed();
+    addEquivalent(decl.first, key);
+  }
+
+  return Error::success();
+}
+
+Error APIVerifierCache::write(StringRef path) const {
+  json::Object decls;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto &entry : entries)
+      decls[entry.getKey()] = utohexstr(entry.getValue());
+  }
+
+  json::Object root{
+      {"version", cacheVersion},
+      {"decls", std::move(decls)},
+  };
+
+  std::error_code ec;
+  raw_fd_ostream os(path, ec, sys::fs::OF_Text);
+  if (ec)
+    return errorCodeToError(ec);
+  os << json::Value(std::move(root)) << "\n";
+  return Error::success();
+}
+
+TAPI_NAMESPACE_INTERNAL_END
@@ -0,0 +1,578 @@
+//===- DeclFingerprint.cpp - Structural Fingerprints of Decls ---*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Implements the fingerprints of declarations.
+///
+//===----------------------------------------------------------------------===//
+
+#include "DeclFingerprint.h"
+#include "TAPIStructuralEquivalence.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Decl.h"
+#include "clang/AST/DeclCXX.h"
+#include "clang/AST/DeclObjC.h"
+#include "clang/AST/Type.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/xxhash.h"
+
+using namespace llvm;
+using namespace clang;
+
+TAPI_NAMESPACE_INTERNAL_BEGIN
+
+namespace {
+
+/// Serializes the parts of a declaration that the API verifier compares.
+class FingerprintBuilder {
+public:
+  void add(uint64_t Value) {
+    for (unsigned I = 0; I != 8; ++I)
+      Buffer.push_back(static_cast<char>(Value >> (I * 8)));
+  }
+
+  void add(StringRef Str) {
+    add(Str.size());
+    Buffer.append(Str.begin(), Str.end());
+  }
+
+  void addName(const NamedDecl *D) {
+    if (const auto *Tag = dyn_cast<TagDecl>(D)) {
+      if (!Tag->getIdentifier())
+        if (const auto *Typedef = Tag->getTypedefNameForAnonDecl()) {
+          add(Typedef->getName());
+          return;
+        }
+    }
+    add(D->getDeclName().getAsString());
+  }
+
+  void addValue(const llvm::APSInt &Value) {
+    add(Value.isUnsigned());
+    add(Value.getBitWidth());
+    for (unsigned I = 0, E = Value.getNumWords(); I != E; ++I)
+      add(Value.getRawData()[I]);
+  }
+
+  /// Add a reference to another declaration, which becomes an edge of the
+  /// reference graph.
+  void addDeclRef(const Decl *D);
+
+  void addType(QualType T);
+  void addDecl(const Decl *D);
+
+  uint64_t finish() const { return xxHash64(Buffer.str()); }
+
+  /// Whether everything added so far could be fingerprinted.
+  bool Valid = true;
+
+  /// The declarations referred to, in order.
+  SmallVector<const Decl *, 4> Edges;
+
+private:
+  void addFunctionType(const FunctionType *T);
+  void addProtocols(const ObjCProtocolList &Protocols);
+  void addObjCContainer(const ObjCContainerDecl *D);
+  void addObjCMethod(const ObjCMethodDecl *D);
+  void addObjCProperty(const ObjCPropertyDecl *D);
+  void addField(const FieldDecl *D);
+
+  SmallString<256> Buffer;
+};
+
+} // end anonymous namespace.
+
+/// Pick the declaration that represents all redeclarations of \p D.
+static const Decl *getRepresentative(const Decl *D) {
+  if (const auto *Tag = dyn_cast<TagDecl>(D)) {
+    if (const auto *Def = Tag->getDefinition())
+      return Def;
+    return Tag->getCanonicalDecl();
+  }
+  if (const auto *Interface = dyn_cast<ObjCInterfaceDecl>(D)) {
+    if (const auto *Def = Interface->getDefinition())
+      return Def;
+    return Interface->getCanonicalDecl();
+  }
+  if (const auto *Protocol = dyn_cast<ObjCProtocolDecl>(D)) {
+    if (const auto *Def = Protocol->getDefinition())
+      return Def;
+    return Protocol->getCanonicalDecl();
+  }
+  return D;
+}
+
+void FingerprintBuilder::addDeclRef(const Decl *D) {
+  D = getRepresentative(D);
+  add(D->getKind());
+  if (const auto *ND = dyn_cast<NamedDecl>(D))
+    addName(ND);
+  Edges.push_back(D);
+}
+
+void FingerprintBuilder::addFunctionType(const FunctionType *T) {
+  addType(T->getReturnType());
+  auto Info = T->getExtInfo();
+  add(Info.getNoReturn());
+  add(Info.getProducesResult());
+  add(Info.getCmseNSCall());
+  add(Info.getNoCallerSavedRegs());
+  add(Info.getNoCfCheck());
+  add(Info.getRegParm());
+  add(Info.getCC());
+
+  const auto *Proto = dyn_cast<FunctionProtoType>(T);
+  if (!Proto)
+    return;
+
+  add(Proto->getNumParams());
+  for (auto Param : Proto->getParamTypes())
+    addType(Param);
+  add(Proto->isVariadic());
+  add(Proto->getMethodQuals().getAsOpaqueValue());
+  add(Proto->getExceptionSpecType());
+  if (Proto->getExceptionSpecType() == EST_Dynamic) {
+    add(Proto->getNumExceptions());
+    for (auto Exception : Proto->exceptions())
+      addType(Exception);
+  } else if (isComputedNoexcept(Proto->getExceptionSpecType())) {
+    add(Proto->getNoexceptExpr() != nullptr);
+  }
+}
+
+void FingerprintBuilder::addType(QualType T) {
+  if (T.isNull()) {
+    add(0u);
+    return;
+  }
+
+  T = T.getCanonicalType();
+  add(T.getQualifiers().getAsOpaqueValue());
+  const auto *Ty = T.getTypePtr();
+  add(Ty->getTypeClass());
+
+  switch (Ty->getTypeClass()) {
+  case Type::Builtin:
+    add(cast<BuiltinType>(Ty)->getKind());
+    break;
+
+  case Type::Complex:
+    addType(cast<ComplexType>(Ty)->getElementType());
+    break;
+
+  case Type::Pointer:
+    addType(cast<PointerType>(Ty)->getPointeeType());
+    break;
+
+  case Type::BlockPointer:
+    addType(cast<BlockPointerType>(Ty)->getPointeeType());
+    break;
+
+  case Type::LValueReference:
+  case Type::RValueReference: {
+    const auto *Ref = cast<ReferenceType>(Ty);
+    add(Ref->isSpelledAsLValue());
+    add(Ref->isInnerRef());
+    addType(Ref->getPointeeTypeAsWritten());
+    break;
+  }
+
+  case Type::ConstantArray: {
+    const auto *Array = cast<ConstantArrayType>(Ty);
+    addValue(APSInt(Array->getSize()));
+    add(Array->getSizeModifier());
+    add(Array->getIndexTypeCVRQualifiers());
+    addType(Array->getElementType());
+    break;
+  }
+
+  case Type::IncompleteArray: {
+    const auto *Array = cast<IncompleteArrayType>(Ty);
+    add(Array->getSizeModifier());
+    add(Array->getIndexTypeCVRQualifiers());
+    addType(Array->getElementType());
+    break;
+  }
+
+  case Type::Vector:
+  case Type::ExtVector: {
+    const auto *Vector = cast<VectorType>(Ty);
+    add(Vector->getNumElements());
+    add(Vector->getVectorKind());
+    addType(Vector->getElementType());
+    break;
+  }
+
+  case Type::ConstantMatrix: {
+    const auto *Matrix = cast<ConstantMatrixType>(Ty);
+    add(Matrix->getNumRows());
+    add(Matrix->getNumColumns());
+    addType(Matrix->getElementType());
+    break;
+  }
+
+  case Type::FunctionProto:
+  case Type::FunctionNoProto:
+    addFunctionType(cast<FunctionType>(Ty));
+    break;
+
+  case Type::Record:
+  case Type::Enum:
+    addDeclRef(cast<TagType>(Ty)->getDecl());
+    break;
+
+  case Type::BitInt: {
+    const auto *Int = cast<BitIntType>(Ty);
+    add(Int->isUnsigned());
+    add(Int->getNumBits());
+    break;
+  }
+
+  case Type::ObjCInterface:
+    addDeclRef(cast<ObjCInterfaceType>(Ty)->getDecl());
+    break;
+
+  case Type::ObjCTypeParam: {
+    const auto *Param = cast<ObjCTypeParamType>(Ty);
+    add(Param->getDecl()->getIndex());
+    add(Param->getDecl()->getName());
+    addType(Param->getDecl()->getUnderlyingType());
+    add(Param->getNumProtocols());
+    for (const auto *Protocol : Param->getProtocols())
+      addDeclRef(Protocol);
+    break;
+  }
+
+  case Type::ObjCObject: {
+    const auto *Object = cast<ObjCObjectType>(Ty);
+    addType(Object->getBaseType());
+    add(Object->isKindOfTypeAsWritten());
+    add(Object->getTypeArgsAsWritten().size());
+    for (auto Arg : Object->getTypeArgsAsWritten())
+      addType(Arg);
+    add(Object->getNumProtocols());
+    for (const auto *Protocol : Object->getProtocols())
+      addDeclRef(Protocol);
+    break;
+  }
+
+  case Type::ObjCObjectPointer:
+    addType(cast<ObjCObjectPointerType>(Ty)->getPointeeType());
+    break;
+
+  case Type::Atomic:
+    addType(cast<AtomicType>(Ty)->getValueType());
+    break;
+
+  default:
+    // Dependent types, C++ member pointers, variable length arrays and the
+    // like compare expressions or templates, which aren't fingerprinted.
+    Valid = false;
+    break;
+  }
+}
+
+void FingerprintBuilder::addField(const FieldDecl *D) {
+  add(D->getKind());
+  add(D->getName());
+  add(D->isAnonymousStructOrUnion());
+  addType(D->getType());
+  add(D->isBitField());
+  if (D->isBitField())
+    add(D->getBitWidthValue(D->getASTContext()));
+  if (const auto *Ivar = dyn_cast<ObjCIvarDecl>(D))
+    add(Ivar->getAccessControl());
+}
+
+void FingerprintBuilder::addProtocols(const ObjCProtocolList &Protocols) {
+  add(Protocols.size());
+  for (const auto *Protocol : Protocols)
+    addDeclRef(Protocol);
+}
+
+void FingerprintBuilder::addObjCMethod(const ObjCMethodDecl *D) {
+  add(D->getSelector().getAsString());
+  add(D->isInstanceMethod());
+  add(D->isPropertyAccessor());
+  add(D->isUnavailable());
+  add(D->isVariadic());
+  add(D->getImplementationControl());
+  add(D->getObjCDeclQualifier());
+  add(D->hasRelatedResultType());
+  addType(D->getReturnType());
+  add(D->param_size());
+  for (const auto *Param : D->parameters())
+    addType(Param->getType());
+}
+
+void FingerprintBuilder::addObjCProperty(const ObjCPropertyDecl *D) {
+  add(D->getName());
+  add(D->isClassProperty());
+  add(D->isUnavailable());
+  add(D->getPropertyAttributes());
+  add(D->getPropertyImplementation());
+  add(D->getGetterName().getAsString());
+  add(D->getSetterName().getAsString());
+  addType(D->getType());
+}
+
+void FingerprintBuilder::addObjCContainer(const ObjCContainerDecl *D) {
+  add(std::distance(D->meth_begin(), D->meth_end()));
+  for (const auto *Method : D->methods())
+    addObjCMethod(Method);
+  add(std::distance(D->prop_begin(), D->prop_end()));
+  for (const auto *Property : D->properties())
+    addObjCProperty(Property);
+}
+
+void FingerprintBuilder::addDecl(const Decl *D) {
+  add(D->getKind());
+  if (const auto *ND = dyn_cast<NamedDecl>(D))
+    addName(ND);
+
+  if (const auto *Record = dyn_cast<RecordDecl>(D)) {
+    const auto *CXXRecord = dyn_cast<CXXRecordDecl>(Record);
+    if (CXXRecord && !CXXRecord->isCLike()) {
+      Valid = false;
+      return;
+    }
+
+    add(Record->getTagKind());
+    if (Record->isAnonymousStructOrUnion()) {
+      auto Index =
+          StructuralEquivalenceContext::findUntaggedStructOrUnionIndex(Record);
+      add(Index ? *Index + 1 : 0);
+    }
+
+    add(Record->isCompleteDefinition());
+    if (!Record->isCompleteDefinition())
+      return;
+
+    for (const auto *Field : Record->fields())
+      addField(Field);
+    return;
+  }
+
+  if (const auto *Enum = dyn_cast<EnumDecl>(D)) {
+    add(Enum->isScoped());
+    add(Enum->isFixed());
+    addType(Enum->getIntegerType());
+    for (const auto *Constant : Enum->enumerators()) {
+      add(Constant->getName());
+      addValue(Constant->getInitVal());
+    }
+    return;
+  }
+
+  if (const auto *Constant = dyn_cast<EnumConstantDecl>(D)) {
+    addValue(Constant->getInitVal());
+    return;
+  }
+
+  if (const auto *Typedef = dyn_cast<TypedefNameDecl>(D)) {
+    addType(Typedef->getUnderlyingType());
+    return;
+  }
+
+  if (const auto *Function = dyn_cast<FunctionDecl>(D)) {
+    if (isa<CXXMethodDecl>(Function) ||
+        Function->getTemplatedKind() != FunctionDecl::TK_NonTemplate) {
+      Valid = false;
+      return;
+    }
+
+    addType(Function->getType());
+    add(Function->param_size());
+    for (const auto *Param : Function->parameters())
+      addType(Param->getType());
+    return;
+  }
+
+  if (const auto *Var = dyn_cast<VarDecl>(D)) {
+    addType(Var->getType());
+    return;
+  }
+
+  if (const auto *Interface = dyn_cast<ObjCInterfaceDecl>(D)) {
+    add(Interface->hasDefinition());
+    if (!Interface->hasDefinition())
+      return;
+
+    if (const auto *Super = Interface->getSuperClass())
+      addDeclRef(Super);
+    else
+      add(0u);
+
+    if (const auto *Params = Interface->getTypeParamList()) {
+      add(Params->size());
+      for (const auto *Param : *Params) {
+        add(Param->getName());
+        add(static_cast<unsigned>(Param->getVariance()));
+        addType(Param->getUnderlyingType());
+      }
+    }
+
+    addProtocols(Interface->getReferencedProtocols());
+    addObjCContainer(Interface);
+    for (const auto *Ivar : Interface->ivars())
+      addField(Ivar);
+    return;
+  }
+
+  if (const auto *Protocol = dyn_cast<ObjCProtocolDecl>(D)) {
+    add(Protocol->hasDefinition());
+    addObjCContainer(Protocol);
+    if (Protocol->hasDefinition())
+      addProtocols(Protocol->getReferencedProtocols());
+    return;
+  }
+
+  if (const auto *Category = dyn_cast<ObjCCategoryDecl>(D)) {
+    if (const auto *Interface = Category->getClassInterface())
+      add(Interface->getName());
+    addObjCContainer(Category);
+    addProtocols(Category->getReferencedProtocols());
+    for (const auto *Ivar : Category->ivars())
+      addField(Ivar);
+    return;
+  }
+
+  // Templates, namespaces and other C++ declarations.
+  Valid = false;
+}
+
+unsigned DeclFingerprints::getNodeID(const Decl *D) {
+  auto Result = NodeIDs.try_emplace(D, Nodes.size());
+  if (Result.second) {
+    Nodes.emplace_back();
+    NodeDecls.push_back(D);
+  }
+  return Result.first->second;
+}
+
+void DeclFingerprints::computeShallow(unsigned ID) {
+  FingerprintBuilder Builder;
+  Builder.addDecl(NodeDecls[ID]);
+
+  auto &N = Nodes[ID];
+  N.Shallow = Builder.finish();
+  N.Valid = Builder.Valid;
+  for (const auto *Edge : Builder.Edges) {
+    unsigned Target = getNodeID(Edge);
+    Nodes[ID].Edges.push_back(Target);
+  }
+}
+
+void DeclFingerprints::finishComponent(ArrayRef<unsigned> Members) {
+  unsigned Component = ++NextComponent;
+  bool Valid = true;
+  for (unsigned Member : Members) {
+    Nodes[Member].Component = Component;
+    Nodes[Member].OnStack = false;
+    Valid &= Nodes[Member].Valid;
+  }
+
+  // References inside the component are hashed by name only, the component
+  // hash then ties the members together independently of their order.
+  SmallVector<uint64_t, 4> Local;
+  for (unsigned Member : Members) {
+    FingerprintBuilder Builder;
+    Builder.add(Nodes[Member].Shallow);
+    for (unsigned Target : Nodes[Member].Edges) {
+      if (Nodes[Target].Component == Component) {
+        Builder.add(0u);
+        continue;
+      }
+      Valid &= Nodes[Target].Valid;
+      Builder.add(Nodes[Target].Deep);
+    }
+    Local.push_back(Builder.finish());
+  }
+
+  SmallVector<uint64_t, 4> Sorted(Local.begin(), Local.end());
+  llvm::sort(Sorted);
+  FingerprintBuilder ComponentBuilder;
+  for (auto Hash : Sorted)
+    ComponentBuilder.add(Hash);
+  auto ComponentHash = ComponentBuilder.finish();
+
+  for (unsigned I = 0, E = Members.size(); I != E; ++I) {
+    FingerprintBuilder Builder;
+    Builder.add(Local[I]);
+    Builder.add(ComponentHash);
+    Nodes[Members[I]].Deep = Builder.finish();
+    Nodes[Members[I]].Valid = Valid;
+  }
+}
+
+/// Tarjan's algorithm, with an explicit stack because chains of references in
+/// the SDK can be deep.
+void DeclFingerprints::visit(unsigned Root) {
+  SmallVector<std::pair<unsigned, unsigned>, 16> Worklist;
+  auto Enter = [&](unsigned ID) {
+    computeShallow(ID);
+    Nodes[ID].Index = Nodes[ID].LowLink = ++NextIndex;
+    Nodes[ID].OnStack = true;
+    Stack.push_back(ID);
+    Worklist.push_back({ID, 0});
+  };
+
+  Enter(Root);
+  while (!Worklist.empty()) {
+    unsigned ID = Worklist.back().first;
+    unsigned EdgeIndex = Worklist.back().second;
+    if (EdgeIndex < Nodes[ID].Edges.size()) {
+      ++Worklist.back().second;
+      unsigned Target = Nodes[ID].Edges[EdgeIndex];
+      if (!Nodes[Target].Index)
+        Enter(Target);
+      else if (Nodes[Target].OnStack)
+        Nodes[ID].LowLink = std::min(Nodes[ID].LowLink, Nodes[Target].Index);
+      continue;
+    }
+
+    Worklist.pop_back();
+    if (!Worklist.empty()) {
+      unsigned Parent = Worklist.back().first;
+      Nodes[Parent].LowLink =
+          std::min(Nodes[Parent].LowLink, Nodes[ID].LowLink);
+    }
+
+    if (Nodes[ID].LowLink != Nodes[ID].Index)
+      continue;
+
+    auto It = std::find(Stack.rbegin(), Stack.rend(), ID).base() - 1;
+    SmallVector<unsigned, 4> Members(It, Stack.end());
+    Stack.erase(It, Stack.end());
+    finishComponent(Members);
+  }
+}
+
+Optional<uint64_t> DeclFingerprints::get(const Decl *D) {
+  unsigned ID = getNodeID(getRepresentative(D));
+  if (!Nodes[ID].Index)
+    visit(ID);
+
+  if (!Nodes[ID].Valid)
+    return None;
+  return Nodes[ID].Deep;
+}
+
+Optional<uint64_t> DeclFingerprints::lookup(const Decl *D) const {
+  auto It = NodeIDs.find(getRepresentative(D));
+  if (It == NodeIDs.end())
+    return None;
+
+  const auto &N = Nodes[It->second];
+  if (!N.Index || !N.Valid)
+    return None;
+  return N.Deep;
+}
+
+TAPI_NAMESPACE_INTERNAL_END
@@ -0,0 +1,82 @@
+//===- DeclFingerprint.h - Structural Fingerprints of Decls -----*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Computes fingerprints of declarations that are stable across runs.
+///
+/// The fingerprint of a declaration covers everything the API verifier
+/// compares: the declaration itself and, transitively, every declaration it
+/// refers to. Source locations are not part of the fingerprint, so it doesn't
+/// change when unrelated lines of a header move.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef TAPI_APIVERIFIER_DECLFINGERPRINT_H
+#define TAPI_APIVERIFIER_DECLFINGERPRINT_H
+
+#include "tapi/Defines.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/SmallVector.h"
+#include <cstdint>
+#include <vector>
+
+namespace clang {
+class Decl;
+} // namespace clang
+
+TAPI_NAMESPACE_INTERNAL_BEGIN
+
+/// Computes and caches the fingerprints of the declarations of one AST.
+///
+/// Declarations that refer to each other (for example a struct with a pointer
+/// to itself) are fingerprinted together: the references are treated as a
+/// graph and every strongly connected component is hashed as a whole.
+class DeclFingerprints {
+public:
+  /// Get the fingerprint of \p D, or None if \p D or any declaration it
+  /// refers to can't be fingerprinted, e.g. C++ templates.
+  llvm::Optional<uint64_t> get(const clang::Decl *D);
+
+  /// Get the fingerprint of \p D if it was already computed by get, either
+  /// for \p D or for a declaration that refers to it. This doesn't modify
+  /// the cache, so it can be called concurrently.
+  llvm::Optional<uint64_t> lookup(const clang::Decl *D) const;
+
+private:
+  struct Node {
+    /// The hash of the declaration without the declarations it refers to.
+    uint64_t Shallow = 0;
+    /// The hash of the declaration and everything it refers to.
+    uint64_t Deep = 0;
+    /// The nodes of the declarations referred to, in order.
+    llvm::SmallVector<unsigned, 4> Edges;
+    unsigned Index = 0;
+    unsigned LowLink = 0;
+    unsigned Component = 0;
+    bool OnStack = false;
+    bool Valid = true;
+  };
+
+  unsigned getNodeID(const clang::Decl *D);
+  void visit(unsigned Root);
+  void computeShallow(unsigned ID);
+  void finishComponent(llvm::ArrayRef<unsigned> Members);
+
+  std::vector<Node> Nodes;
+  llvm::DenseMap<const clang::Decl *, unsigned> NodeIDs;
+  std::vector<const clang::Decl *> NodeDecls;
+  std::vector<unsigned> Stack;
+  unsigned NextIndex = 0;
+  unsigned NextComponent = 0;
+};
+
+TAPI_NAMESPACE_INTERNAL_END
+
+#endif // TAPI_APIVERIFIER_DECLFINGERPRINT_H
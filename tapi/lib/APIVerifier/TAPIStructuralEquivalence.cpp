@@ -312,6 +312,7 @@ static bool IsArrayStructurallyEquivalent(StructuralEquivalenceContext &Context,
 
 static bool isDeclAtSameLocation(StructuralEquivalenceContext &Context,
                                  NamedDecl *D1, NamedDecl *D2) {
+  auto Lock = Context.lockSourceManagers();
   auto Loc1 =
       Context.FromCtx.getSourceManager().getPresumedLoc(D1->getLocation());
   auto Loc2 =
@@ -1098,25 +1099,18 @@ static bool IsStructurallyEquivalent(StructuralEquivalenceContext &Context,
 static bool checkObjCPropertyListEquivalent(
     StructuralEquivalenceContext &Context, const ObjCContainerDecl *D1,
     DeclarationName N1, const ObjCContainerDecl *D2, DeclarationName N2,
-    ObjCContainerDecl::prop_range R1, ObjCContainerDecl::prop_range R2) {
-  // Create lookup map for properties and class properties
-  llvm::StringMap<const ObjCPropertyDecl *> D1P;
-  llvm::StringMap<const ObjCPropertyDecl *> D1CP;
-
-  // Add properties in base to lookup map.
-  for (const auto *I : R1) {
-    if (I->isClassProperty())
-      D1CP.insert({I->getNameAsString(), I});
-    else
-      D1P.insert({I->getNameAsString(), I});
-  }
+    ObjCContainerDecl::prop_range R2) {
+  // Lookup maps for properties and class properties in base.
+  auto &Index = Context.getChildIndex();
+  const auto &D1P = Index.getProperties(D1, /*IsClass=*/false);
+  const auto &D1CP = Index.getProperties(D1, /*IsClass=*/true);
 
   for (const auto *P2 : R2) {
     if (P2->isUnavailable())
       continue;
     // Lookup the property with the same name in base.
-    auto P1 = P2->isClassProperty() ? D1CP.find(P2->getNameAsString())
-                                    : D1P.find(P2->getNameAsString());
+    auto P1 = P2->isClassProperty() ? D1CP.find(P2->getName())
+                                    : D1P.find(P2->getName());
     auto D1End = P2->isClassProperty() ? D1CP.end() : D1P.end();
     if (P1 == D1End) {
       if (Context.shouldCheckMissingAPIs()) {
@@ -1142,15 +1136,9 @@ static bool checkObjCMethodListEquivalent(StructuralEquivalenceContext &Context,
                                           const ObjCContainerDecl *D1,
                                           DeclarationName N1,
                                           const ObjCContainerDecl *D2,
-                                          DeclarationName N2,
-                                          RangeType R1, RangeType R2) {
-  llvm::StringMap<const ObjCMethodDecl *> D1P;
-
-  for (const auto *I : R1) {
-    if (I->isPropertyAccessor())
-      continue;
-    D1P.insert({I->getNameAsString(), I});
-  }
+                                          DeclarationName N2, bool IsInstance,
+                                          RangeType R2) {
+  const auto &D1P = Context.getChildIndex().getMethods(D1, IsInstance);
 
   for (const auto *P2 : R2) {
     if (P2->isPropertyAccessor() || P2->isUnavailable())
@@ -1176,29 +1164,35 @@ static bool checkObjCMethodListEquivalent(StructuralEquivalenceContext &Context,
   return true;
 }
 
-static std::pair<const SourceLocation *, const ObjCProtocolDecl *>
-findProtocolWithName(StringRef name, const ObjCProtocolList &PL) {
+using ProtocolWithLoc =
+    std::pair<const SourceLocation *, const ObjCProtocolDecl *>;
+
+/// Index the protocols of the list by name, keeping the first occurrence.
+static llvm::StringMap<ProtocolWithLoc>
+indexProtocolsByName(const ObjCProtocolList &PL) {
+  llvm::StringMap<ProtocolWithLoc> Protocols;
   auto loc = PL.loc_begin();
   for (auto &protocol : PL) {
-    if (protocol->getName() == name)
-      return {loc, protocol};
+    Protocols.try_emplace(protocol->getName(), loc, protocol);
     ++loc;
   }
-  return {nullptr, nullptr};
+  return Protocols;
 }
 
 static bool checkObjCProtocolListEquivalent(
     StructuralEquivalenceContext &Context, const ObjCContainerDecl *D1,
     DeclarationName N1, const ObjCContainerDecl *D2, DeclarationName N2,
     const ObjCProtocolList &PL1, const ObjCProtocolList &PL2) {
+  auto Protocols1 = indexProtocolsByName(PL1);
+  auto Protocols2 = indexProtocolsByName(PL2);
   llvm::StringSet<> names;
   for (auto &I : PL1)
-    names.insert(I->getNameAsString());
+    names.insert(I->getName());
   for (const auto *I : PL2)
-    names.insert(I->getNameAsString());
+    names.insert(I->getName());
   for (auto &PN : names) {
-    auto P1 = findProtocolWithName(PN.first(), PL1);
-    auto P2 = findProtocolWithName(PN.first(), PL2);
+    auto P1 = Protocols1.lookup(PN.first());
+    auto P2 = Protocols2.lookup(PN.first());
     if (!P1.second) {
       Context.Diag2(*P2.first, TAPI_INTERNAL::diag::note_api_protocol)
           << N2 << P2.second->getDeclName();
@@ -1228,16 +1222,17 @@ static bool checkObjCContainerEquivalent(StructuralEquivalenceContext &Context,
                                          const ObjCContainerDecl *D2,
                                          DeclarationName N2) {
   if (!checkObjCMethodListEquivalent(Context, D1, N1, D2, N2,
-                                     D1->instance_methods(),
+                                     /*IsInstance=*/true,
                                      D2->instance_methods()))
     return false;
 
   if (!checkObjCMethodListEquivalent(Context, D1, N1, D2, N2,
-                                     D1->class_methods(), D2->class_methods()))
+                                     /*IsInstance=*/false,
+                                     D2->class_methods()))
     return false;
 
   if (!checkObjCPropertyListEquivalent(Context, D1, N1, D2, N2,
-                                       D1->properties(), D2->properties()))
+                                       D2->properties()))
     return false;
 
   return true;
@@ -1647,17 +1642,14 @@ static bool IsStructurallyEquivalent(StructuralEquivalenceContext &Context,
     return false;
   }
 
-  std::map<StringRef, EnumConstantDecl *> D2EnumConstantDecls;
-  for (auto *EC2 : D2->enumerators())
-    D2EnumConstantDecls.emplace(EC2->getName(), EC2);
-
+  const auto &D2EnumConstantDecls =
+      Context.getChildIndex().getEnumConstants(D2);
   for (auto *EC1 : D1->enumerators()) {
-    auto it = D2EnumConstantDecls.find(EC1->getName());
+    const auto *EC2 = D2EnumConstantDecls.lookup(EC1->getName());
     // Ignore missing enumerators.
-    if (it == D2EnumConstantDecls.end())
+    if (!EC2)
       continue;
 
-    auto *EC2 = it->second;
     if (!Context.checkStructurallyEquivalent(EC1, EC2))
       return false;
   }
@@ -1854,27 +1846,39 @@ TAPIDiagBuilder StructuralEquivalenceContext::Diag2(SourceLocation Loc,
   return TAPIDiagBuilder(&ToDiag, Loc, DiagID, StoredDiagnostics.D2);
 }
 
-void StructuralEquivalenceContext::resetContext() {
+static void emitDiagnostics(DiagTrace &Diagnostics) {
   DiagnosticsEngine *Current =
-      StoredDiagnostics.D1.empty()
-          ? nullptr
-          : StoredDiagnostics.D1.back().getDiagEngine();
-  while (!StoredDiagnostics.D1.empty()) {
-    StoredDiagnostics.D1.back().emitDiag();
-    StoredDiagnostics.D1.pop_back();
-  }
-  if (Current && !StoredDiagnostics.D2.empty())
-    StoredDiagnostics.D2.back().getDiagEngine()->notePriorDiagnosticFrom(
-        *Current);
-  while (!StoredDiagnostics.D2.empty()) {
-    StoredDiagnostics.D2.back().emitDiag();
-    StoredDiagnostics.D2.pop_back();
+      Diagnostics.D1.empty() ? nullptr
+                             : Diagnostics.D1.back().getDiagEngine();
+  while (!Diagnostics.D1.empty()) {
+    Diagnostics.D1.back().emitDiag();
+    Diagnostics.D1.pop_back();
+  }
+  if (Current && !Diagnostics.D2.empty())
+    Diagnostics.D2.back().getDiagEngine()->notePriorDiagnosticFrom(*Current);
+  while (!Diagnostics.D2.empty()) {
+    Diagnostics.D2.back().emitDiag();
+    Diagnostics.D2.pop_back();
   }
+}
+
+void StructuralEquivalenceContext::resetContext() {
+  if (Shared) {
+    if (!StoredDiagnostics.D1.empty() || !StoredDiagnostics.D2.empty())
+      DeferredDiagnostics.push_back(std::move(StoredDiagnostics));
+  } else
+    emitDiagnostics(StoredDiagnostics);
 
   StoredDiagnostics.clear();
   ComparsionStacks.clear();
 }
 
+void StructuralEquivalenceContext::emitDeferredDiagnostics() {
+  for (auto &Diagnostics : DeferredDiagnostics)
+    emitDiagnostics(Diagnostics);
+  DeferredDiagnostics.clear();
+}
+
 void StructuralEquivalenceContext::pushContext() {
   ComparsionStacks.emplace_back();
   TentativeComparsions = &ComparsionStacks.back();
@@ -1893,6 +1897,7 @@ bool StructuralEquivalenceContext::shouldCheckDecls(const Decl *D1,
   if (CheckExternalHeaders)
     return true;
 
+  auto Lock = lockSourceManagers();
   auto shouldCheckDecl = [](const Decl *D, DiagnosticsEngine &DE,
                             FrontendContext *ctx) {
     // Locate the decl. If the location is invalid or the search failed,
@@ -1918,12 +1923,61 @@ bool StructuralEquivalenceContext::shouldCheckDecls(const Decl *D1,
 
 void StructuralEquivalenceContext::addEqualDecl(const Decl *D1,
                                                 const Decl *D2) {
-  EqualDecls.insert({D1, D2});
+  if (!Shared) {
+    EqualDecls.insert({D1, D2});
+    return;
+  }
+
+  std::lock_guard<std::mutex> Lock(Shared->EqualDeclsLock);
+  Shared->EqualDecls.insert({D1, D2});
 }
 
 bool StructuralEquivalenceContext::isKnowEqual(const Decl *D1,
                                                const Decl *D2) const {
-  return EqualDecls.count({D1, D2});
+  if (!Shared)
+    return EqualDecls.count({D1, D2});
+
+  std::lock_guard<std::mutex> Lock(Shared->EqualDeclsLock);
+  return Shared->EqualDecls.count({D1, D2});
+}
+
+const DeclChildIndex::EnumConstantMap &
+DeclChildIndex::getEnumConstants(const EnumDecl *D) {
+  auto Result = EnumConstants.try_emplace(D);
+  if (Result.second) {
+    Result.first->second = std::make_unique<EnumConstantMap>();
+    for (const auto *EC : D->enumerators())
+      Result.first->second->try_emplace(EC->getName(), EC);
+  }
+  return *Result.first->second;
+}
+
+const DeclChildIndex::MethodMap &
+DeclChildIndex::getMethods(const ObjCContainerDecl *D, bool IsInstance) {
+  auto Result = Methods[IsInstance].try_emplace(D);
+  if (Result.second) {
+    Result.first->second = std::make_unique<MethodMap>();
+    for (const auto *M : D->methods()) {
+      if (M->isInstanceMethod() != IsInstance || M->isPropertyAccessor())
+        continue;
+      Result.first->second->try_emplace(M->getNameAsString(), M);
+    }
+  }
+  return *Result.first->second;
+}
+
+const DeclChildIndex::PropertyMap &
+DeclChildIndex::getProperties(const ObjCContainerDecl *D, bool IsClass) {
+  auto Result = Properties[IsClass].try_emplace(D);
+  if (Result.second) {
+    Result.first->second = std::make_unique<PropertyMap>();
+    for (const auto *P : D->properties()) {
+      if (P->isClassProperty() != IsClass)
+        continue;
+      Result.first->second->try_emplace(P->getName(), P);
+    }
+  }
+  return *Result.first->second;
 }
 
 Optional<unsigned> StructuralEquivalenceContext::findUntaggedStructOrUnionIndex(
@@ -1967,7 +2021,8 @@ Optional<unsigned> StructuralEquivalenceContext::findUntaggedStructOrUnionIndex(
 
 bool StructuralEquivalenceContext::diagnoseStructurallyEquivalent(
     const Decl *D1, const Decl *D2) {
-  if (!checkStructurallyEquivalent(D1, D2)) {
+  bool Equivalent = checkStructurallyEquivalent(D1, D2);
+  if (!Equivalent) {
     // Push the hints for target.
     Diag1(clang::SourceLocation(), TAPI_INTERNAL::diag::note_api_target_note)
         << FromFrontendCtx->target.getTriple();
@@ -1991,7 +2046,7 @@ bool StructuralEquivalenceContext::diagnoseStructurallyEquivalent(
   }
 
   resetContext();
-  return true;
+  return Equivalent;
 }
 
 bool StructuralEquivalenceContext::checkStructurallyEquivalent(const Decl *D1,
@@ -2002,6 +2057,11 @@ bool StructuralEquivalenceContext::checkStructurallyEquivalent(const Decl *D1,
       DeclsToCompare.count({D1, D2}))
     return true;
 
+  // Identical definitions are equivalent, only compare the decls node by node
+  // to find the differences.
+  if (haveSameFingerprint(D1, D2))
+    return true;
+
   // Only allow finite number of stack frame, otherwise, it will infinite
   // loop.
   bool finalize = true;
@@ -2039,6 +2099,19 @@ bool StructuralEquivalenceContext::checkStructurallyEquivalent(const Decl *D1,
   return Equivalent;
 }
 
+bool StructuralEquivalenceContext::haveSameFingerprint(const Decl *D1,
+                                                       const Decl *D2) const {
+  if (!FromFingerprints || !ToFingerprints)
+    return false;
+
+  auto Fingerprint1 = FromFingerprints->lookup(D1);
+  if (!Fingerprint1)
+    return false;
+
+  auto Fingerprint2 = ToFingerprints->lookup(D2);
+  return Fingerprint2 && *Fingerprint1 == *Fingerprint2;
+}
+
 bool StructuralEquivalenceContext::checkStructurallyEquivalent(QualType T1,
                                                                QualType T2) {
   return IsStructurallyEquivalent(*this, T1, T2);
@@ -14,20 +14,30 @@
 #ifndef TAPI_APIVERIFIER_TAPISTRUCTURALEQUIVALENCE_H
 #define TAPI_APIVERIFIER_TAPISTRUCTURALEQUIVALENCE_H
 
+#include "DeclFingerprint.h"
 #include "tapi/Defines.h"
 #include "tapi/APIVerifier/APIVerifier.h"
 #include "tapi/Diagnostics/Diagnostics.h"
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringSet.h"
+#include <memory>
+#include <mutex>
 
 namespace clang {
 
 class ASTContext;
 class Decl;
 class DiagnosticBuilder;
+class EnumConstantDecl;
+class EnumDecl;
+class ObjCContainerDecl;
+class ObjCMethodDecl;
+class ObjCPropertyDecl;
 class QualType;
 class RecordDecl;
 class SourceLocation;
@@ -220,6 +230,54 @@ inline const TAPIDiagBuilder &operator<<(const TAPIDiagBuilder &DB,
   return DB;
 }
 
+/// State shared by the contexts that compare batches of decl pairs
+/// concurrently.
+struct SharedEquivalenceState {
+  /// Guards the source managers and the frontend contexts, which cache the
+  /// result of lookups.
+  std::mutex SourceLock;
+
+  /// Guards EqualDecls.
+  std::mutex EqualDeclsLock;
+
+  /// All the decl pairs known to be equal by any of the contexts.
+  llvm::DenseSet<std::pair<const Decl *, const Decl *>> EqualDecls;
+};
+
+/// Name-indexed views of the children of decls, built once per decl and
+/// reused by every comparison that involves it.
+class DeclChildIndex {
+public:
+  using EnumConstantMap = llvm::StringMap<const clang::EnumConstantDecl *>;
+  using MethodMap = llvm::StringMap<const clang::ObjCMethodDecl *>;
+  using PropertyMap = llvm::StringMap<const clang::ObjCPropertyDecl *>;
+
+  /// The enumerators of \p D by name.
+  const EnumConstantMap &getEnumConstants(const clang::EnumDecl *D);
+
+  /// The instance or class methods of \p D by selector, without the
+  /// property accessors.
+  const MethodMap &getMethods(const clang::ObjCContainerDecl *D,
+                              bool IsInstance);
+
+  /// The instance or class properties of \p D by name.
+  const PropertyMap &getProperties(const clang::ObjCContainerDecl *D,
+                                   bool IsClass);
+
+private:
+  // The maps are allocated separately so references stay valid when a nested
+  // comparison indexes another decl and the DenseMaps grow.
+  llvm::DenseMap<const clang::EnumDecl *, std::unique_ptr<EnumConstantMap>>
+      EnumConstants;
+  /// Indexed by IsInstance.
+  llvm::DenseMap<const clang::ObjCContainerDecl *, std::unique_ptr<MethodMap>>
+      Methods[2];
+  /// Indexed by IsClass.
+  llvm::DenseMap<const clang::ObjCContainerDecl *,
+                 std::unique_ptr<PropertyMap>>
+      Properties[2];
+};
+
 class StructuralEquivalenceContext {
 public:
   StructuralEquivalenceContext(
@@ -234,11 +292,33 @@ public:
 
   /// Determine whether all the DeclPairs are the same.
   bool diagnoseStructurallyEquivalent(std::vector<DeclPair> &&DeclPairs) {
+    setDeclsToCompare(DeclPairs);
+    diagnoseStructurallyEquivalent(getDeclsToCompare());
+    return hasErrorOccurred();
+  }
+
+  /// Set all the decl pairs the verifier compares, without duplicates.
+  void setDeclsToCompare(llvm::ArrayRef<DeclPair> DeclPairs) {
+    DeclsToCompare.clear();
     DeclsToCompare.insert(DeclPairs.begin(), DeclPairs.end());
-    for (auto &it : DeclsToCompare)
-      diagnoseStructurallyEquivalent(it.first, it.second);
+  }
 
-    return hasErrorOccurred();
+  llvm::ArrayRef<DeclPair> getDeclsToCompare() const {
+    return DeclsToCompare.getArrayRef();
+  }
+
+  /// Determine whether the DeclPairs, a subset of the pairs to compare, are
+  /// the same. If Equivalent isn't empty, it receives the result for each
+  /// pair.
+  void diagnoseStructurallyEquivalent(
+      llvm::ArrayRef<DeclPair> DeclPairs,
+      llvm::MutableArrayRef<bool> Equivalent = llvm::None) {
+    for (unsigned I = 0, E = DeclPairs.size(); I != E; ++I) {
+      bool Result = diagnoseStructurallyEquivalent(DeclPairs[I].first,
+                                                   DeclPairs[I].second);
+      if (!Equivalent.empty())
+        Equivalent[I] = Result;
+    }
   }
 
   /// Determine whether the two declarations are structurally
@@ -281,6 +361,30 @@ public:
 
   bool shouldCheckMissingAPIs() const { return CheckMissingAPIs; }
 
+  DeclChildIndex &getChildIndex() { return ChildIndex; }
+
+  /// Share the known equal decls with other contexts running concurrently.
+  /// The diagnostics are kept until emitDeferredDiagnostics is called, so the
+  /// caller can emit them in a deterministic order.
+  void setSharedState(SharedEquivalenceState *State) { Shared = State; }
+
+  /// Emit the diagnostics kept while sharing state with other contexts.
+  void emitDeferredDiagnostics();
+
+  /// Accept the decl pairs with the same fingerprint without comparing them.
+  void setFingerprints(const DeclFingerprints *From,
+                       const DeclFingerprints *To) {
+    FromFingerprints = From;
+    ToFingerprints = To;
+  }
+
+  /// Lock the source managers if other contexts run concurrently.
+  std::unique_lock<std::mutex> lockSourceManagers() {
+    if (!Shared)
+      return {};
+    return std::unique_lock<std::mutex>(Shared->SourceLock);
+  }
+
   bool hasErrorOccurred() const {
     return FromDiag.hasErrorOccurred() || ToDiag.hasErrorOccurred();
   }
@@ -297,6 +401,9 @@ private:
   /// Compare and not cached.
   bool isDeclEquivalent(const Decl *D1, const Decl *D2);
 
+  /// Check whether both decls have the same known fingerprint.
+  bool haveSameFingerprint(const Decl *D1, const Decl *D2) const;
+
 public:
   /// AST contexts for which we are checking structural equivalence.
   ASTContext &FromCtx, &ToCtx;
@@ -335,6 +442,19 @@ private:
 
   DiagTrace StoredDiagnostics;
 
+  /// The state shared with the other contexts, if any.
+  SharedEquivalenceState *Shared = nullptr;
+
+  /// Diagnostics of each comparison, kept while sharing state.
+  std::vector<DiagTrace> DeferredDiagnostics;
+
+  /// The children of the decls compared by this context.
+  DeclChildIndex ChildIndex;
+
+  /// The fingerprints of the decls of each AST, if any.
+  const DeclFingerprints *FromFingerprints = nullptr;
+  const DeclFingerprints *ToFingerprints = nullptr;
+
   unsigned DiagnosticDepth = 4; // maximum ComparsionStack depth.
 
   /// Whether warn or error on external header content
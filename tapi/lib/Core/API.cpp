@@ -657,47 +657,62 @@ bool API::operator<(const API &other) const {
   return false;
 }
 
-template <typename InputT> static bool hasEqualRecords(InputT lhs, InputT rhs) {
-  if (lhs.size() != rhs.size())
-    return false;
+static std::string describeRecordKey(StringRef key) { return key.str(); }
+
+static std::string
+describeRecordKey(const std::pair<StringRef, StringRef> &key) {
+  return (key.first + "(" + key.second + ")").str();
+}
 
+template <typename InputT>
+static Optional<std::string> findDifferentRecord(StringRef kind,
+                                                 const InputT &lhs,
+                                                 const InputT &rhs) {
   for (const auto &[key, val] : lhs) {
     auto rhsIt = rhs.find(key);
-    if (rhsIt == rhs.end())
-      return false;
-    if (!(*(rhsIt->second) == *val))
-      return false;
+    if (rhsIt == rhs.end() || !(*(rhsIt->second) == *val))
+      return (kind + " '" + describeRecordKey(key) + "'").str();
   }
 
-  return true;
+  if (lhs.size() != rhs.size()) {
+    for (const auto &entry : rhs)
+      if (!lhs.count(entry.first))
+        return (kind + " '" + describeRecordKey(entry.first) + "'").str();
+  }
+
+  return None;
 }
 
-bool API::operator==(const API &other) const {
+Optional<std::string> API::findFirstDifference(const API &other) const {
   if (triple != other.triple)
-    return false;
+    return std::string("target triple");
   if (projectName != other.projectName)
-    return false;
-
-  if (!hasEqualRecords<GlobalRecordMap>(globals, other.globals))
-    return false;
-  if (!hasEqualRecords<EnumRecordMap>(enums, other.enums))
-    return false;
-  if (!hasEqualRecords<TypedefMap>(typeDefs, other.typeDefs))
-    return false;
-  if (!hasEqualRecords<ObjCInterfaceRecordMap>(interfaces, other.interfaces))
-    return false;
-  if (!hasEqualRecords<ObjCCategoryRecordMap>(categories, other.categories))
-    return false;
-  if (!hasEqualRecords<ObjCProtocolRecordMap>(protocols, other.protocols))
-    return false;
+    return std::string("project name");
+
+  if (auto diff = findDifferentRecord("global", globals, other.globals))
+    return diff;
+  if (auto diff = findDifferentRecord("enum", enums, other.enums))
+    return diff;
+  if (auto diff = findDifferentRecord("typedef", typeDefs, other.typeDefs))
+    return diff;
+  if (auto diff = findDifferentRecord("objective-c class", interfaces,
+                                      other.interfaces))
+    return diff;
+  if (auto diff = findDifferentRecord("objective-c category", categories,
+                                      other.categories))
+    return diff;
+  if (auto diff = findDifferentRecord("objective-c protocol", protocols,
+                                      other.protocols))
+    return diff;
+
+  if (hasBinaryInfo() != other.hasBinaryInfo() ||
+      (hasBinaryInfo() && *binaryInfo != other.getBinaryInfo()))
+    return std::string("binary info");
+  return None;
+}
 
-  if (hasBinaryInfo() && !other.hasBinaryInfo())
-    return false;
-  if (!hasBinaryInfo() && other.hasBinaryInfo())
-    return false;
-  if (hasBinaryInfo() && *binaryInfo != other.getBinaryInfo())
-    return false;
-  return true;
+bool API::operator==(const API &other) const {
+  return !findFirstDifference(other);
 }
 
 TAPI_NAMESPACE_INTERNAL_END
@@ -14,6 +14,7 @@
 
 #include "tapi/Core/API2SymbolConverter.h"
 
+#include "llvm/ADT/SmallString.h"
 #include "clang/AST/DeclObjC.h"
 
 using namespace llvm;
@@ -45,14 +46,44 @@ SymbolFlags getFlagsFromRecord(const APIRecord &record) {
 }
 } // namespace
 
+void API2SymbolConverter::addSymbol(SymbolKind kind, StringRef name,
+                                    SymbolFlags flags) {
+  if (!mergeTargets) {
+    symbolSet->addGlobal(kind, name, flags, target);
+    return;
+  }
+
+  // Like SymbolSet::addGlobal, keep the flags of the first target.
+  auto it = pendingIndex.find({kind, name});
+  if (it == pendingIndex.end()) {
+    // The APIs can be gone by the time finish() is called, keep the name.
+    name = names.save(name);
+    it = pendingIndex.try_emplace({kind, name}, pendingSymbols.size()).first;
+    pendingSymbols.push_back({kind, name, flags, {}});
+  }
+  auto &targets = pendingSymbols[it->second].targets;
+  if (targets.empty() || targets.back() != target)
+    targets.push_back(target);
+}
+
+void API2SymbolConverter::finish() {
+  for (auto &symbol : pendingSymbols) {
+    auto *global = symbolSet->addGlobal(symbol.kind, symbol.name, symbol.flags,
+                                        symbol.targets.front());
+    for (const auto &target : makeArrayRef(symbol.targets).drop_front())
+      global->addTarget(target);
+  }
+  pendingSymbols.clear();
+  pendingIndex.clear();
+}
+
 void API2SymbolConverter::visitGlobal(GlobalRecord &record) {
 
   // Skip non exported symbols unless for flat namespace symbols.
   if (!record.isExported()) {
     if (recordUndefs && record.isExternal()) {
       record.flags = getFlagsFromRecord(record);
-      symbolSet->addGlobal(SymbolKind::GlobalSymbol, record.name, record.flags,
-                           target);
+      addSymbol(SymbolKind::GlobalSymbol, record.name, record.flags);
     }
     return;
   }
@@ -60,62 +91,45 @@ void API2SymbolConverter::visitGlobal(GlobalRecord &record) {
   auto sym = parseSymbol(record.name);
   record.name = sym.name;
   record.flags = getFlagsFromRecord(record);
-  symbolSet->addGlobal(sym.kind, record.name, record.flags, target);
+  addSymbol(sym.kind, record.name, record.flags);
+}
+
+void API2SymbolConverter::addIvars(
+    StringRef className, ArrayRef<ObjCInstanceVariableRecord *> ivars) {
+  for (auto *ivar : ivars) {
+    if (!ivar->isExported())
+      continue;
+    // ObjC has an additional mechanism to specify if an ivar is exported or
+    // not.
+    if (ivar->accessControl == ObjCIvarDecl::Private ||
+        ivar->accessControl == ObjCIvarDecl::Package)
+      continue;
+    SmallString<128> buffer;
+    auto name = ObjCInstanceVariableRecord::createName(className, ivar->name,
+                                                       buffer);
+    ivar->flags = getFlagsFromRecord(*ivar);
+    addSymbol(SymbolKind::ObjectiveCInstanceVariable, name, ivar->flags);
+  }
 }
 
 void API2SymbolConverter::visitObjCInterface(ObjCInterfaceRecord &record) {
   if (record.isExported()) {
     record.flags = getFlagsFromRecord(record);
     record.linkage = APILinkage::Exported;
-    symbolSet->addGlobal(SymbolKind::ObjectiveCClass, record.name, record.flags,
-                         target);
+    addSymbol(SymbolKind::ObjectiveCClass, record.name, record.flags);
     if (record.hasExceptionAttribute)
-      symbolSet->addGlobal(SymbolKind::ObjectiveCClassEHType, record.name,
-                           record.flags, target);
+      addSymbol(SymbolKind::ObjectiveCClassEHType, record.name, record.flags);
   }
 
-  auto addIvars = [&](ArrayRef<ObjCInstanceVariableRecord *> ivars) {
-    for (auto *ivar : ivars) {
-      if (!ivar->isExported())
-        continue;
-      // ObjC has an additional mechanism to specify if an ivar is exported or
-      // not.
-      if (ivar->accessControl == ObjCIvarDecl::Private ||
-          ivar->accessControl == ObjCIvarDecl::Package)
-        continue;
-      std::string name =
-          ObjCInstanceVariableRecord::createName(record.name, ivar->name);
-      ivar->flags = getFlagsFromRecord(*ivar);
-      symbolSet->addGlobal(SymbolKind::ObjectiveCInstanceVariable, name,
-                           ivar->flags, target);
-    }
-  };
-  addIvars(record.ivars);
+  addIvars(record.name, record.ivars);
 
   for (auto *category : record.categories) {
-    addIvars(category->ivars);
+    addIvars(record.name, category->ivars);
   }
 }
 
 void API2SymbolConverter::visitObjCCategory(ObjCCategoryRecord &record) {
-  auto addIvars = [&](ArrayRef<ObjCInstanceVariableRecord *> ivars) {
-    for (auto *ivar : ivars) {
-      if (!ivar->isExported())
-        continue;
-      // ObjC has an additional mechanism to specify if an ivar is exported or
-      // not.
-      if (ivar->accessControl == ObjCIvarDecl::Private ||
-          ivar->accessControl == ObjCIvarDecl::Package)
-        continue;
-      std::string name =
-          ObjCInstanceVariableRecord::createName(record.name, ivar->name);
-      ivar->flags = getFlagsFromRecord(*ivar);
-      symbolSet->addGlobal(SymbolKind::ObjectiveCInstanceVariable, name,
-                           ivar->flags, target);
-    }
-  };
-
-  addIvars(record.ivars);
+  addIvars(record.name, record.ivars);
 }
 
 TAPI_NAMESPACE_INTERNAL_END
@@ -7,6 +7,8 @@
 //===----------------------------------------------------------------------===//
 
 #include "tapi/Core/APIJSONSerializer.h"
+#include "tapi/Core/JSONStreamReader.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Support/JSON.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/TextAPI/PackedVersion.h"
@@ -17,46 +19,32 @@ using namespace clang;
 
 TAPI_NAMESPACE_INTERNAL_BEGIN
 
-class APIJSONVisitor : public APIVisitor {
-public:
-  APIJSONVisitor(const APIJSONOption &options) : options(options) {}
-  ~APIJSONVisitor() override {}
-
-  friend APIJSONSerializer;
-
-  void visitGlobal(const GlobalRecord &) override;
-  void visitEnum(const EnumRecord &) override;
-  void visitObjCInterface(const ObjCInterfaceRecord &) override;
-  void visitObjCCategory(const ObjCCategoryRecord &) override;
-  void visitObjCProtocol(const ObjCProtocolRecord &) override;
-  void visitTypeDef(const TypedefRecord &) override;
-
-private:
-  const APIJSONOption &options;
-  Array globals;
-  Array interfaces;
-  Array categories;
-  Array protocols;
-  Array enums;
-  Array typedefs;
-};
-
 class APIJSONParser {
 public:
   APIJSONParser(API &api, bool publicOnly = false)
       : result(api), publicOnly(publicOnly) {}
   Error parse(Object *root);
+  Error parse(const StringMap<StringRef> &members);
 
 private:
-  // top level parsers.
-  Error parseGlobals(Array &globals);
-  Error parseInterfaces(Array &interfaces);
-  Error parseCategories(Array &categories);
-  Error parseProtocols(Array &protocols);
-  Error parseEnums(Array &enums);
-  Error parseTypedefs(Array &types);
-  Error parseBinaryInfo(Object &binaryInfo);
-  Error parsePotentiallyDefinedSelectors(Array &selectors);
+  // top level parsers, one element at a time.
+  Error parseGlobal(const Value &global);
+  Error parseInterface(const Value &interface);
+  Error parseCategory(const Value &category);
+  Error parseProtocol(const Value &protocol);
+  Error parseEnum(const Value &value);
+  Error parseTypedef(const Value &type);
+  Error parseBinaryInfo(const Object &binaryInfo);
+  Error parsePotentiallyDefinedSelector(const Value &selector);
+
+  using ElementParser = Error (APIJSONParser::*)(const Value &);
+  struct Section {
+    StringRef key;
+    ElementParser parseElement;
+  };
+  /// The arrays of an API object, in the order they are parsed. Categories
+  /// are parsed after interfaces so they are added to their interface.
+  static const Section sections[];
 
   // helper functions.
   Expected<StringRef> parseString(StringRef key, const Object *obj,
@@ -82,6 +70,7 @@ private:
   parseAccessControl(const Object *obj);
 
   // parse sub objects.
+  Error parseObjCContainer(ObjCContainerRecord *container, const Object *obj);
   Error parseConformedProtocols(ObjCContainerRecord *container,
                                 const Object *obj);
   Error parseMethods(ObjCContainerRecord *container, const Object *object,
@@ -96,454 +85,467 @@ private:
   bool publicOnly;
 };
 
-// Helper to write boolean value. Default is to skip false boolean value.
-static void serializeBoolean(Object &obj, StringRef key, bool value) {
-  if (!value)
-    return;
-  obj[key] = true;
-}
+namespace {
 
-// Helper to write array. Default is to skip empty array.
-static void serializeArray(Object &obj, StringRef key,
-                           const std::vector<StringRef> array) {
-  if (array.empty())
-    return;
-  Array values;
-  for (const auto &e : array)
-    values.emplace_back(e);
-  obj[key] = std::move(values);
-}
+/// Collects the records of an API that are serialized, by kind.
+class APIRecordCollector : public APIVisitor {
+public:
+  APIRecordCollector(const APIJSONOption &options) : options(options) {}
 
-static void serializeLocation(Object &obj, const APILoc &loc,
-                              const APIJSONOption &options) {
-  // skip invalid location.
-  if (loc.isInvalid())
-    return;
+  void visitGlobal(const GlobalRecord &record) override {
+    if (options.externalOnly && !record.isExported())
+      return;
+    if (isSerialized(record, options))
+      globals.push_back(&record);
+  }
 
-  obj["file"] = loc.getFilename().str();
-  if (options.ignoreLineCol)
-    return;
+  void visitEnum(const EnumRecord &record) override {
+    if (isSerialized(record, options))
+      enums.push_back(&record);
+  }
 
-  obj["line"] = loc.getLine();
-  obj["col"] = loc.getColumn();
-}
+  void visitObjCInterface(const ObjCInterfaceRecord &record) override {
+    if (options.externalOnly && !record.isExported())
+      return;
+    if (isSerialized(record, options))
+      interfaces.push_back(&record);
+  }
 
-static std::string getStringForPackedVersion(const PackedVersion &version) {
-  std::string str;
-  raw_string_ostream rss(str);
-  rss << version;
-  return rss.str();
-}
+  void visitObjCCategory(const ObjCCategoryRecord &record) override {
+    if (isSerialized(record, options))
+      categories.push_back(&record);
+  }
 
-static void serializeAvailability(Object &obj, const AvailabilityInfo &avail,
-                                  const APIJSONOption &option) {
-  if (avail.isDefault())
-    return;
+  void visitObjCProtocol(const ObjCProtocolRecord &record) override {
+    if (isSerialized(record, options))
+      protocols.push_back(&record);
+  }
 
-  if (avail._introduced != PackedVersion())
-    obj["introduced"] = getStringForPackedVersion(avail._introduced);
-  if (avail._obsoleted != PackedVersion())
-    obj["obsoleted"] = getStringForPackedVersion(avail._obsoleted);
-  if (avail.isUnavailable())
-    obj["unavailable"] = true;
-  if (avail.isSPIAvailable())
-    obj["SPIAvailable"] = true;
-}
+  void visitTypeDef(const TypedefRecord &record) override {
+    if (isSerialized(record, options))
+      typedefs.push_back(&record);
+  }
 
-static void serializeLinkage(Object &obj, APILinkage linkage) {
-  switch (linkage) {
-  case APILinkage::Exported:
-    obj["linkage"] = "exported";
-    break;
-  case APILinkage::Reexported:
-    obj["linkage"] = "re-exported";
-    break;
-  case APILinkage::Internal:
-    obj["linkage"] = "internal";
-    break;
-  case APILinkage::External:
-    obj["linkage"] = "external";
-    break;
-  case APILinkage::Unknown:
-    // do nothing;
-    break;
+  static bool isSerialized(const APIRecord &record,
+                           const APIJSONOption &options) {
+    return !options.publicOnly || record.access == APIAccess::Public;
   }
-}
 
-static void serializeFlags(Object &obj, SymbolFlags flags) {
-  serializeBoolean(obj, "weakDefined",
-                   (flags & SymbolFlags::WeakDefined) ==
-                       SymbolFlags::WeakDefined);
-  serializeBoolean(obj, "weakReferenced",
-                   (flags & SymbolFlags::WeakReferenced) ==
-                       SymbolFlags::WeakReferenced);
-  serializeBoolean(obj, "threadLocalValue",
-                   (flags & SymbolFlags::ThreadLocalValue) ==
-                       SymbolFlags::ThreadLocalValue);
-}
+  const APIJSONOption &options;
+  std::vector<const GlobalRecord *> globals;
+  std::vector<const ObjCInterfaceRecord *> interfaces;
+  std::vector<const ObjCCategoryRecord *> categories;
+  std::vector<const ObjCProtocolRecord *> protocols;
+  std::vector<const EnumRecord *> enums;
+  std::vector<const TypedefRecord *> typedefs;
+};
 
-static Optional<Object> serializeAPIRecord(const APIRecord &var,
-                                           const APIJSONOption &options) {
-  if (options.publicOnly && var.access != APIAccess::Public)
-    return llvm::None;
+/// The members that only some kinds of records have.
+struct RecordExtras {
+  const GlobalRecord *global = nullptr;
+  const EnumRecord *enumRecord = nullptr;
+  const ObjCContainerRecord *container = nullptr;
+  const ObjCInterfaceRecord *interface = nullptr;
+  const ObjCCategoryRecord *category = nullptr;
+  const ObjCMethodRecord *method = nullptr;
+  const ObjCPropertyRecord *property = nullptr;
+  const ObjCInstanceVariableRecord *ivar = nullptr;
+};
 
-  Object obj;
-  obj["name"] = var.name;
+/// Writes an API as a JSON object.
+///
+/// The output is the same as printing the equivalent json::Object, which
+/// orders the members of every object by key, so every object is written in
+/// that order.
+class APIJSONWriter {
+public:
+  APIJSONWriter(json::OStream &out, const APIJSONOption &options)
+      : out(out), options(options) {}
 
-  serializeLocation(obj, var.loc, options);
-  serializeAvailability(obj, var.availability, options);
-  serializeLinkage(obj, var.linkage);
-  serializeFlags(obj, var.flags);
+  void write(const API &api, bool withVersion);
 
-  // When only public, all APIs in the output are public so there is no need to
-  // encode access.
-  if (options.publicOnly)
-    return obj;
+private:
+  void writeRecord(const APIRecord &record, const RecordExtras &extras);
+  void writeMethods(const ObjCContainerRecord &container,
+                    bool isInstanceMethod);
+  void writeBinaryInfo(const BinaryInfo &binaryInfo);
+  void writeBoolean(StringRef key, bool value);
+  void writeStrings(StringRef key, ArrayRef<StringRef> values);
+
+  template <typename RecordT>
+  void writeRecords(StringRef key, const std::vector<const RecordT *> &records,
+                    RecordExtras (*getExtras)(const RecordT &)) {
+    if (records.empty())
+      return;
+    out.attributeArray(key, [&] {
+      for (const auto *record : records)
+        out.object([&] { writeRecord(*record, getExtras(*record)); });
+    });
+  }
+
+  json::OStream &out;
+  const APIJSONOption &options;
+};
+
+} // end anonymous namespace.
+
+static std::string getPackedVersionString(const PackedVersion &version) {
+  std::string str;
+  raw_string_ostream rss(str);
+  rss << version;
+  return rss.str();
+}
 
-  switch (var.access) {
+static StringRef getAccessString(APIAccess access) {
+  switch (access) {
   case APIAccess::Public:
-    obj["access"] = "public";
-    break;
+    return "public";
   case APIAccess::Private:
-    obj["access"] = "private";
-    break;
+    return "private";
   case APIAccess::Project:
-    obj["access"] = "project";
-    break;
+    return "project";
   case APIAccess::Unknown:
-    // do nothing;
-    break;
+    return {};
   }
-
-  return obj;
+  llvm_unreachable("unknown access");
 }
 
-static Optional<Object> serializeGlobalRecord(const GlobalRecord &var,
-                                              const APIJSONOption &options) {
-  auto obj = serializeAPIRecord(var, options);
-  if (!obj)
-    return llvm::None;
-
-  switch (var.kind) {
-  case GVKind::Function:
-    obj.value()["kind"] = "function";
-    break;
-  case GVKind::Variable:
-    obj.value()["kind"] = "variable";
-    break;
-  case GVKind::Unknown:
-    // do nothing;
-    break;
+static StringRef getLinkageString(APILinkage linkage) {
+  switch (linkage) {
+  case APILinkage::Exported:
+    return "exported";
+  case APILinkage::Reexported:
+    return "re-exported";
+  case APILinkage::Internal:
+    return "internal";
+  case APILinkage::External:
+    return "external";
+  case APILinkage::Unknown:
+    return {};
   }
-
-  return std::move(*obj);
+  llvm_unreachable("unknown linkage");
 }
 
-static void serializeMethod(Array &container, const ObjCMethodRecord *method,
-                            const APIJSONOption &options) {
-
-  auto obj = serializeAPIRecord(*method, options);
-  if (!obj)
-    return;
-
-  serializeBoolean(*obj, "optional", method->isOptional);
-  serializeBoolean(*obj, "dynamic", method->isDynamic);
-  container.emplace_back(std::move(*obj));
-}
-
-static void serializeProperty(Array &container,
-                              const ObjCPropertyRecord *property,
-                              const APIJSONOption &options) {
-  auto obj = serializeAPIRecord(*property, options);
-  if (!obj)
-    return;
-
-  Array attributes;
-  if (property->isReadOnly())
-    attributes.emplace_back("readonly");
-  if (property->isDynamic())
-    attributes.emplace_back("dynamic");
-  if (property->isClassProperty())
-    attributes.emplace_back("class");
-  if (!attributes.empty())
-    obj.value()["attr"] = std::move(attributes);
-
-  serializeBoolean(*obj, "optional", property->isOptional);
-  obj.value()["getter"] = property->getterName;
-
-  if (!property->isReadOnly())
-    obj.value()["setter"] = property->setterName;
-
-  container.emplace_back(std::move(*obj));
-}
-
-static void serializeInstanceVariable(Array &container,
-                                      const ObjCInstanceVariableRecord *ivar,
-                                      const APIJSONOption &options) {
-  auto obj = serializeAPIRecord(*ivar, options);
-  if (!obj)
-    return;
-
-  switch (ivar->accessControl) {
+static StringRef
+getAccessControlString(ObjCInstanceVariableRecord::AccessControl control) {
+  switch (control) {
   case ObjCInstanceVariableRecord::AccessControl::Private:
-    obj.value()["accessControl"] = "private";
-    break;
+    return "private";
   case ObjCInstanceVariableRecord::AccessControl::Protected:
-    obj.value()["accessControl"] = "protected";
-    break;
+    return "protected";
   case ObjCInstanceVariableRecord::AccessControl::Public:
-    obj.value()["accessControl"] = "public";
-    break;
+    return "public";
   case ObjCInstanceVariableRecord::AccessControl::Package:
-    obj.value()["accessControl"] = "package";
-    break;
+    return "package";
   case ObjCInstanceVariableRecord::AccessControl::None:
-    break; // ignore;
+    return {};
   }
+  llvm_unreachable("unknown access control");
+}
 
-  container.emplace_back(std::move(*obj));
+// Helper to write boolean value. Default is to skip false boolean value.
+void APIJSONWriter::writeBoolean(StringRef key, bool value) {
+  if (value)
+    out.attribute(key, true);
 }
 
-void APIJSONVisitor::visitGlobal(const GlobalRecord &record) {
-  if (options.externalOnly && !record.isExported())
+// Helper to write array. Default is to skip empty array.
+void APIJSONWriter::writeStrings(StringRef key, ArrayRef<StringRef> values) {
+  if (values.empty())
     return;
+  out.attributeArray(key, [&] {
+    for (auto value : values)
+      out.value(value);
+  });
+}
 
-  auto root = serializeGlobalRecord(record, options);
-  if (!root)
+void APIJSONWriter::writeMethods(const ObjCContainerRecord &container,
+                                 bool isInstanceMethod) {
+  auto isWritten = [&](const ObjCMethodRecord *method) {
+    return method->isInstanceMethod == isInstanceMethod &&
+           APIRecordCollector::isSerialized(*method, options);
+  };
+  if (none_of(container.methods, isWritten))
     return;
 
-  globals.emplace_back(std::move(*root));
+  out.attributeArray(isInstanceMethod ? "instanceMethods" : "classMethods",
+                     [&] {
+                       for (const auto *method : container.methods) {
+                         if (!isWritten(method))
+                           continue;
+                         RecordExtras extras;
+                         extras.method = method;
+                         out.object([&] { writeRecord(*method, extras); });
+                       }
+                     });
 }
 
-static Optional<Object>
-serializeObjCContainer(const ObjCContainerRecord &record,
-                       const APIJSONOption &options) {
-  auto root = serializeAPIRecord(record, options);
-  if (!root)
-    return llvm::None;
-
-  if (!record.protocols.empty()) {
-    Array protocols;
-    for (const auto &protocol : record.protocols)
-      protocols.emplace_back(protocol.str());
-    root.value()["protocols"] = std::move(protocols);
-  }
+/// Write the members of \p record in the order of their keys.
+void APIJSONWriter::writeRecord(const APIRecord &record,
+                                const RecordExtras &extras) {
+  const auto &avail = record.availability;
+  bool hasAvailability = !avail.isDefault();
+  bool hasLocation = !record.loc.isInvalid();
+  bool hasLineCol = hasLocation && !options.ignoreLineCol;
+  const auto *container = extras.container;
 
-  if (!record.methods.empty()) {
-    Array instanceMethodRoot, classMethodRoot;
-    for (const auto *method : record.methods) {
-      if (method->isInstanceMethod)
-        serializeMethod(instanceMethodRoot, method, options);
-      else
-        serializeMethod(classMethodRoot, method, options);
-    }
-    if (!instanceMethodRoot.empty())
-      root.value()["instanceMethods"] = std::move(instanceMethodRoot);
-    if (!classMethodRoot.empty())
-      root.value()["classMethods"] = std::move(classMethodRoot);
-  }
+  writeBoolean("SPIAvailable", hasAvailability && avail.isSPIAvailable());
 
-  if (!record.properties.empty()) {
-    Array propertyRoot;
-    for (const auto *property : record.properties)
-      serializeProperty(propertyRoot, property, options);
-    root.value()["properties"] = std::move(propertyRoot);
+  // When only public, all APIs in the output are public so there is no need to
+  // encode access.
+  if (!options.publicOnly) {
+    auto access = getAccessString(record.access);
+    if (!access.empty())
+      out.attribute("access", access);
   }
 
-  if (!record.ivars.empty()) {
-    Array ivarRoot;
-    for (const auto *ivar : record.ivars)
-      serializeInstanceVariable(ivarRoot, ivar, options);
-    root.value()["ivars"] = std::move(ivarRoot);
+  if (extras.ivar) {
+    auto control = getAccessControlString(extras.ivar->accessControl);
+    if (!control.empty())
+      out.attribute("accessControl", control);
   }
 
-  return root;
-}
+  if (const auto *property = extras.property) {
+    if (property->isReadOnly() || property->isDynamic() ||
+        property->isClassProperty())
+      out.attributeArray("attr", [&] {
+        if (property->isReadOnly())
+          out.value("readonly");
+        if (property->isDynamic())
+          out.value("dynamic");
+        if (property->isClassProperty())
+          out.value("class");
+      });
+  }
 
-void APIJSONVisitor::visitObjCInterface(const ObjCInterfaceRecord &interface) {
-  if (options.externalOnly && !interface.isExported())
-    return;
+  if (const auto *interface = extras.interface) {
+    auto isNamed = [](const ObjCCategoryRecord *category) {
+      return !category->name.empty();
+    };
+    if (any_of(interface->categories, isNamed))
+      out.attributeArray("categories", [&] {
+        for (const auto *category : interface->categories)
+          if (isNamed(category))
+            out.value(category->name);
+      });
+  }
 
-  auto root = serializeObjCContainer(interface, options);
-  if (!root)
-    return;
+  if (container)
+    writeMethods(*container, /*isInstanceMethod=*/false);
 
-  root.value()["super"] = interface.superClass.str();
+  if (hasLineCol)
+    out.attribute("col", record.loc.getColumn());
 
-  serializeLinkage(*root, interface.linkage);
-  serializeBoolean(*root, "hasException", interface.hasExceptionAttribute);
+  if (const auto *enumRecord = extras.enumRecord) {
+    if (!enumRecord->constants.empty())
+      out.attributeArray("constants", [&] {
+        for (const auto *constant : enumRecord->constants)
+          if (APIRecordCollector::isSerialized(*constant, options))
+            out.object([&] { writeRecord(*constant, RecordExtras()); });
+      });
+  }
 
-  if (!interface.categories.empty()) {
-    Array categories;
-    for (const auto *category : interface.categories) {
-      if (!category->name.empty())
-        categories.emplace_back(category->name);
+  if (extras.method)
+    writeBoolean("dynamic", extras.method->isDynamic);
+
+  if (hasLocation)
+    out.attribute("file", record.loc.getFilename());
+
+  if (extras.property)
+    out.attribute("getter", extras.property->getterName);
+
+  if (extras.interface)
+    writeBoolean("hasException", extras.interface->hasExceptionAttribute);
+
+  if (container)
+    writeMethods(*container, /*isInstanceMethod=*/true);
+
+  if (extras.category)
+    out.attribute("interface", extras.category->interface);
+
+  if (hasAvailability && avail._introduced != PackedVersion())
+    out.attribute("introduced", getPackedVersionString(avail._introduced));
+
+  if (container && !container->ivars.empty())
+    out.attributeArray("ivars", [&] {
+      for (const auto *ivar : container->ivars) {
+        if (!APIRecordCollector::isSerialized(*ivar, options))
+          continue;
+        RecordExtras ivarExtras;
+        ivarExtras.ivar = ivar;
+        out.object([&] { writeRecord(*ivar, ivarExtras); });
+      }
+    });
+
+  if (extras.global) {
+    switch (extras.global->kind) {
+    case GVKind::Function:
+      out.attribute("kind", "function");
+      break;
+    case GVKind::Variable:
+      out.attribute("kind", "variable");
+      break;
+    case GVKind::Unknown:
+      // do nothing;
+      break;
     }
-    if (!categories.empty())
-      root.value()["categories"] = std::move(categories);
   }
 
-  interfaces.emplace_back(std::move(*root));
-}
+  if (hasLineCol)
+    out.attribute("line", record.loc.getLine());
 
-void APIJSONVisitor::visitObjCCategory(const ObjCCategoryRecord &category) {
-  auto root = serializeObjCContainer(category, options);
-  if (!root)
-    return;
+  auto linkage = getLinkageString(record.linkage);
+  if (!linkage.empty())
+    out.attribute("linkage", linkage);
 
-  root.value()["interface"] = category.interface.str();
+  out.attribute("name", record.name);
 
-  categories.emplace_back(std::move(*root));
-}
+  if (hasAvailability && avail._obsoleted != PackedVersion())
+    out.attribute("obsoleted", getPackedVersionString(avail._obsoleted));
 
-void APIJSONVisitor::visitObjCProtocol(const ObjCProtocolRecord &protocol) {
-  auto root = serializeObjCContainer(protocol, options);
-  if (root)
-    protocols.emplace_back(std::move(*root));
-}
+  if (extras.method)
+    writeBoolean("optional", extras.method->isOptional);
+  if (extras.property)
+    writeBoolean("optional", extras.property->isOptional);
 
-static Optional<Object> serializeEnumRecord(const EnumRecord &record,
-                                            const APIJSONOption &options) {
-  auto root = serializeAPIRecord(record, options);
-  if (!root)
-    return llvm::None;
-
-  if (!record.constants.empty()) {
-    Array constants;
-    for (const auto *constant : record.constants) {
-      auto constantObj = serializeAPIRecord(*constant, options);
-      if (!constantObj)
-        continue;
-      constants.emplace_back(std::move(*constantObj));
-    }
-    root.value()["constants"] = std::move(constants);
-  }
+  if (container && !container->properties.empty())
+    out.attributeArray("properties", [&] {
+      for (const auto *property : container->properties) {
+        if (!APIRecordCollector::isSerialized(*property, options))
+          continue;
+        RecordExtras propertyExtras;
+        propertyExtras.property = property;
+        out.object([&] { writeRecord(*property, propertyExtras); });
+      }
+    });
 
-  return std::move(*root);
-}
+  if (container && !container->protocols.empty())
+    writeStrings("protocols", container->protocols);
 
-void APIJSONVisitor::visitEnum(const EnumRecord &record) {
-  auto root = serializeEnumRecord(record, options);
-  if (!root)
-    return;
-
-  enums.emplace_back(std::move(*root));
-}
+  if (extras.property && !extras.property->isReadOnly())
+    out.attribute("setter", extras.property->setterName);
 
-static Optional<Object> serializeTypedefRecord(const TypedefRecord &record,
-                                               const APIJSONOption &options) {
-  auto root = serializeAPIRecord(record, options);
-  if (!root)
-    return llvm::None;
-
-  return std::move(*root);
-}
+  if (extras.interface)
+    out.attribute("super", extras.interface->superClass);
 
-void APIJSONVisitor::visitTypeDef(const TypedefRecord &record) {
-  auto root = serializeTypedefRecord(record, options);
-  if (root)
-    typedefs.emplace_back(std::move(*root));
+  writeBoolean("threadLocalValue", record.isThreadLocalValue());
+  writeBoolean("unavailable", hasAvailability && avail.isUnavailable());
+  writeBoolean("weakDefined", record.isWeakDefined());
+  writeBoolean("weakReferenced", record.isWeakReferenced());
 }
 
-static std::string
-getPackedVersionString(const llvm::MachO::PackedVersion version) {
-  std::string str;
-  raw_string_ostream vers(str);
-  vers << version;
-  return vers.str();
-}
-
-static void serializeBinaryInfo(Object &root, const BinaryInfo &binaryInfo,
-                                bool noUUID) {
-  Object info;
-  switch (binaryInfo.fileType) {
-  case FileType::MachO_DynamicLibrary:
-    info["type"] = "dylib";
-    break;
-  case FileType::MachO_DynamicLibrary_Stub:
-    info["type"] = "stub";
-    break;
-  case FileType::MachO_Bundle:
-    info["type"] = "bundle";
-    break;
-  default:
-    // All other file types are invalid.
-    info["type"] = "invalid";
-    break;
-  }
-  info["currentVersion"] = getPackedVersionString(binaryInfo.currentVersion);
-  info["compatibilityVersion"] =
-      getPackedVersionString(binaryInfo.compatibilityVersion);
-  info["installName"] = binaryInfo.installName;
-  if (!noUUID)
-    info["uuid"] = binaryInfo.uuid;
-  // Optional fields below.
-  if (!binaryInfo.parentUmbrella.empty())
-    info["parentUmbrella"] = binaryInfo.parentUmbrella;
-  if (binaryInfo.swiftABIVersion)
-    info["swiftABI"] = binaryInfo.swiftABIVersion;
-  serializeBoolean(info, "twoLevelNamespace", binaryInfo.isTwoLevelNamespace);
-  serializeBoolean(info, "appExtensionSafe", binaryInfo.isAppExtensionSafe);
-  serializeArray(info, "allowableClients", binaryInfo.allowableClients);
-  serializeArray(info, "reexportedLibraries", binaryInfo.reexportedLibraries);
-  root["binaryInfo"] = std::move(info);
+void APIJSONWriter::writeBinaryInfo(const BinaryInfo &binaryInfo) {
+  out.attributeObject("binaryInfo", [&] {
+    writeStrings("allowableClients", binaryInfo.allowableClients);
+    writeBoolean("appExtensionSafe", binaryInfo.isAppExtensionSafe);
+    out.attribute("compatibilityVersion",
+                  getPackedVersionString(binaryInfo.compatibilityVersion));
+    out.attribute("currentVersion",
+                  getPackedVersionString(binaryInfo.currentVersion));
+    out.attribute("installName", binaryInfo.installName);
+    // Optional fields below.
+    if (!binaryInfo.parentUmbrella.empty())
+      out.attribute("parentUmbrella", binaryInfo.parentUmbrella);
+    writeStrings("reexportedLibraries", binaryInfo.reexportedLibraries);
+    if (binaryInfo.swiftABIVersion)
+      out.attribute("swiftABI", binaryInfo.swiftABIVersion);
+    writeBoolean("twoLevelNamespace", binaryInfo.isTwoLevelNamespace);
+    switch (binaryInfo.fileType) {
+    case FileType::MachO_DynamicLibrary:
+      out.attribute("type", "dylib");
+      break;
+    case FileType::MachO_DynamicLibrary_Stub:
+      out.attribute("type", "stub");
+      break;
+    case FileType::MachO_Bundle:
+      out.attribute("type", "bundle");
+      break;
+    default:
+      // All other file types are invalid.
+      out.attribute("type", "invalid");
+      break;
+    }
+    if (!options.noUUID)
+      out.attribute("uuid", binaryInfo.uuid);
+  });
 }
 
-static void serializePotentiallyDefinedSelectors(
-    Object &root, const StringSet<> &potentiallyDefinedSelectors) {
-  if (potentiallyDefinedSelectors.empty())
-    return;
+void APIJSONWriter::write(const API &api, bool withVersion) {
+  APIRecordCollector records(options);
+  api.visit(records);
+
+  out.object([&] {
+    if (withVersion)
+      out.attribute("api_json_version", 1);
+
+    if (api.hasBinaryInfo())
+      writeBinaryInfo(api.getBinaryInfo());
+
+    writeRecords<ObjCCategoryRecord>(
+        "categories", records.categories, [](const ObjCCategoryRecord &r) {
+          RecordExtras extras;
+          extras.container = &r;
+          extras.category = &r;
+          return extras;
+        });
+    writeRecords<EnumRecord>("enums", records.enums, [](const EnumRecord &r) {
+      RecordExtras extras;
+      extras.enumRecord = &r;
+      return extras;
+    });
+    writeRecords<GlobalRecord>("globals", records.globals,
+                               [](const GlobalRecord &r) {
+                                 RecordExtras extras;
+                                 extras.global = &r;
+                                 return extras;
+                               });
+    writeRecords<ObjCInterfaceRecord>(
+        "interfaces", records.interfaces, [](const ObjCInterfaceRecord &r) {
+          RecordExtras extras;
+          extras.container = &r;
+          extras.interface = &r;
+          return extras;
+        });
+
+    // sort the selectors for reproducibility.
+    const auto &potentiallyDefinedSelectors =
+        api.getPotentiallyDefinedSelectors();
+    if (!potentiallyDefinedSelectors.empty()) {
+      std::vector<StringRef> selectors;
+      for (const auto &s : potentiallyDefinedSelectors)
+        selectors.emplace_back(s.first());
+      llvm::sort(selectors);
+      writeStrings("potentiallyDefinedSelectors", selectors);
+    }
 
-  std::vector<StringRef> selectors;
-  for (const auto &s : potentiallyDefinedSelectors)
-    selectors.emplace_back(s.first());
+    if (!api.getProjectName().empty())
+      out.attribute("project", api.getProjectName());
 
-  // sort the selectors for reproducibility.
-  llvm::sort(selectors);
+    writeRecords<ObjCProtocolRecord>(
+        "protocols", records.protocols, [](const ObjCProtocolRecord &r) {
+          RecordExtras extras;
+          extras.container = &r;
+          return extras;
+        });
 
-  Array output;
-  for (auto s : selectors)
-    output.emplace_back(s);
+    if (!options.noTarget)
+      out.attribute("target", api.getTriple().str());
 
-  root["potentiallyDefinedSelectors"] = std::move(output);
+    writeRecords<TypedefRecord>("typedefs", records.typedefs,
+                                [](const TypedefRecord &) {
+                                  return RecordExtras();
+                                });
+  });
 }
 
-Object APIJSONSerializer::getJSONObject() const {
-  json::Object root;
-  if (!options.noTarget)
-    root["target"] = std::move(api.getTriple().str());
-
-  if (!api.getProjectName().empty())
-    root["project"] = api.getProjectName().str();
-
-  APIJSONVisitor visitor(options);
-  api.visit(visitor);
-
-  auto insertNonEmptyArray = [&](StringRef key, Array array) {
-    if (array.empty())
-      return;
-    root[key] = std::move(array);
-  };
-  insertNonEmptyArray("globals", visitor.globals);
-  insertNonEmptyArray("interfaces", visitor.interfaces);
-  insertNonEmptyArray("categories", visitor.categories);
-  insertNonEmptyArray("protocols", visitor.protocols);
-  insertNonEmptyArray("enums", visitor.enums);
-  insertNonEmptyArray("typedefs", visitor.typedefs);
-  serializePotentiallyDefinedSelectors(root,
-                                       api.getPotentiallyDefinedSelectors());
-  if (api.hasBinaryInfo())
-    serializeBinaryInfo(root, api.getBinaryInfo(), options.noUUID);
-  return root;
+void APIJSONSerializer::serialize(json::OStream &os) const {
+  APIJSONWriter(os, options).write(api, /*withVersion=*/false);
 }
 
 void APIJSONSerializer::serialize(raw_ostream &os) const {
-  auto root = getJSONObject();
-  root["api_json_version"] = 1;
-  if (options.compact)
-    os << formatv("{0}", Value(std::move(root))) << "\n";
-  else
-    os << formatv("{0:2}", Value(std::move(root))) << "\n";
+  json::OStream out(os, options.compact ? 0 : 2);
+  APIJSONWriter(out, options).write(api, /*withVersion=*/true);
+  os << "\n";
 }
 
 bool APIJSONParser::parseBinaryField(StringRef key, const Object *obj) {
@@ -714,36 +716,33 @@ StringRef APIJSONParser::parseUSR(const Object *obj) {
   return obj->getString("USR").value_or("");
 }
 
-Error APIJSONParser::parseGlobals(Array &globals) {
-  for (const auto &g : globals) {
-    auto *object = g.getAsObject();
-    if (!object)
-      return make_error<APIJSONError>("Expect to be JSON Object");
-
-    auto name = parseName(object);
-    if (!name)
-      return name.takeError();
-    auto access = parseAccess(object);
-    if (!access)
-      return access.takeError();
-    auto kind = parseGlobalKind(object);
-    if (!kind)
-      return kind.takeError();
-    auto linkage = parseLinkage(object);
-    if (!linkage)
-      return linkage.takeError();
-    auto loc = parseLocation(object);
-    if (!loc)
-      return loc.takeError();
-    auto avail = parseAvailability(object);
-    if (!avail)
-      return avail.takeError();
-    auto flags = parseFlags(object);
-
-    result.addGlobal(*name, flags, *loc, *avail, *access,
-                     /*Decl*/ nullptr, *kind, *linkage);
-  }
+Error APIJSONParser::parseGlobal(const Value &global) {
+  const auto *object = global.getAsObject();
+  if (!object)
+    return make_error<APIJSONError>("Expect to be JSON Object");
 
+  auto name = parseName(object);
+  if (!name)
+    return name.takeError();
+  auto access = parseAccess(object);
+  if (!access)
+    return access.takeError();
+  auto kind = parseGlobalKind(object);
+  if (!kind)
+    return kind.takeError();
+  auto linkage = parseLinkage(object);
+  if (!linkage)
+    return linkage.takeError();
+  auto loc = parseLocation(object);
+  if (!loc)
+    return loc.takeError();
+  auto avail = parseAvailability(object);
+  if (!avail)
+    return avail.takeError();
+  auto flags = parseFlags(object);
+
+  result.addGlobal(*name, flags, *loc, *avail, *access,
+                   /*Decl*/ nullptr, *kind, *linkage);
   return Error::success();
 }
 
@@ -882,150 +881,104 @@ Error APIJSONParser::parseIvars(ObjCContainerRecord *container,
   return Error::success();
 }
 
-Error APIJSONParser::parseInterfaces(Array &interfaces) {
-  for (const auto &interface : interfaces) {
-    auto *object = interface.getAsObject();
-    if (!object)
-      return make_error<APIJSONError>("Expect to be JSON Object");
-
-    auto name = parseName(object);
-    if (!name)
-      return name.takeError();
-    auto access = parseAccess(object);
-    if (!access)
-      return access.takeError();
-    auto loc = parseLocation(object);
-    if (!loc)
-      return loc.takeError();
-    auto avail = parseAvailability(object);
-    if (!avail)
-      return avail.takeError();
-    auto linkage = parseLinkage(object);
-    if (!linkage)
-      return linkage.takeError();
-    auto super = object->getString("super").value_or("");
-
-    auto *objcClass =
-        result.addObjCInterface(*name, *loc, *avail, *access, *linkage, super,
-                                /*Decl*/ nullptr);
-    auto exception = parseBinaryField("hasException", object);
-    objcClass->hasExceptionAttribute = exception;
-
-    // Don't need to handle categories here.
-    auto err = parseConformedProtocols(objcClass, object);
-    if (err)
-      return err;
+Error APIJSONParser::parseObjCContainer(ObjCContainerRecord *container,
+                                        const Object *object) {
+  auto err = parseConformedProtocols(container, object);
+  if (err)
+    return err;
 
-    err = parseMethods(objcClass, object, true);
-    if (err)
-      return err;
+  err = parseMethods(container, object, true);
+  if (err)
+    return err;
 
-    err = parseMethods(objcClass, object, false);
-    if (err)
-      return err;
+  err = parseMethods(container, object, false);
+  if (err)
+    return err;
 
-    err = parseProperties(objcClass, object);
-    if (err)
-      return err;
+  err = parseProperties(container, object);
+  if (err)
+    return err;
 
-    err = parseIvars(objcClass, object);
-    if (err)
-      return err;
-  }
-  return Error::success();
+  return parseIvars(container, object);
 }
 
-Error APIJSONParser::parseCategories(Array &categories) {
-  for (const auto &category : categories) {
-    auto *object = category.getAsObject();
-    if (!object)
-      return make_error<APIJSONError>("Expect to be JSON Object");
-
-    auto name = parseName(object);
-    if (!name)
-      return name.takeError();
-    auto access = parseAccess(object);
-    if (!access)
-      return access.takeError();
-    auto loc = parseLocation(object);
-    if (!loc)
-      return loc.takeError();
-    auto avail = parseAvailability(object);
-    if (!avail)
-      return avail.takeError();
-    auto interface = parseCategoryInterface(object);
-
-    auto *objcCategory = result.addObjCCategory(interface, *name, *loc, *avail,
-                                                *access, /*Decl*/ nullptr);
+Error APIJSONParser::parseInterface(const Value &interface) {
+  const auto *object = interface.getAsObject();
+  if (!object)
+    return make_error<APIJSONError>("Expect to be JSON Object");
 
-    // Don't need to handle categories here.
-    auto err = parseConformedProtocols(objcCategory, object);
-    if (err)
-      return err;
-
-    err = parseMethods(objcCategory, object, true);
-    if (err)
-      return err;
-
-    err = parseMethods(objcCategory, object, false);
-    if (err)
-      return err;
+  auto name = parseName(object);
+  if (!name)
+    return name.takeError();
+  auto access = parseAccess(object);
+  if (!access)
+    return access.takeError();
+  auto loc = parseLocation(object);
+  if (!loc)
+    return loc.takeError();
+  auto avail = parseAvailability(object);
+  if (!avail)
+    return avail.takeError();
+  auto linkage = parseLinkage(object);
+  if (!linkage)
+    return linkage.takeError();
+  auto super = object->getString("super").value_or("");
 
-    err = parseProperties(objcCategory, object);
-    if (err)
-      return err;
+  auto *objcClass =
+      result.addObjCInterface(*name, *loc, *avail, *access, *linkage, super,
+                              /*Decl*/ nullptr);
+  auto exception = parseBinaryField("hasException", object);
+  objcClass->hasExceptionAttribute = exception;
 
-    err = parseIvars(objcCategory, object);
-    if (err)
-      return err;
-  }
-  return Error::success();
+  // Don't need to handle categories here.
+  return parseObjCContainer(objcClass, object);
 }
 
-Error APIJSONParser::parseProtocols(Array &protocols) {
-  for (const auto &protocol : protocols) {
-    auto *object = protocol.getAsObject();
-    if (!object)
-      return make_error<APIJSONError>("Expect to be JSON Object");
-
-    auto name = parseName(object);
-    if (!name)
-      return name.takeError();
-    auto access = parseAccess(object);
-    if (!access)
-      return access.takeError();
-    auto loc = parseLocation(object);
-    if (!loc)
-      return loc.takeError();
-    auto avail = parseAvailability(object);
-    if (!avail)
-      return avail.takeError();
-
-    auto *objcProtocol =
-        result.addObjCProtocol(*name, *loc, *avail, *access, /*Decl*/ nullptr);
-
-    // Don't need to handle categories here.
-    auto err = parseConformedProtocols(objcProtocol, object);
-    if (err)
-      return err;
-
-    err = parseMethods(objcProtocol, object, true);
-    if (err)
-      return err;
+Error APIJSONParser::parseCategory(const Value &category) {
+  const auto *object = category.getAsObject();
+  if (!object)
+    return make_error<APIJSONError>("Expect to be JSON Object");
 
-    err = parseMethods(objcProtocol, object, false);
-    if (err)
-      return err;
+  auto name = parseName(object);
+  if (!name)
+    return name.takeError();
+  auto access = parseAccess(object);
+  if (!access)
+    return access.takeError();
+  auto loc = parseLocation(object);
+  if (!loc)
+    return loc.takeError();
+  auto avail = parseAvailability(object);
+  if (!avail)
+    return avail.takeError();
+  auto interface = parseCategoryInterface(object);
+
+  auto *objcCategory = result.addObjCCategory(interface, *name, *loc, *avail,
+                                              *access, /*Decl*/ nullptr);
+  return parseObjCContainer(objcCategory, object);
+}
 
-    err = parseProperties(objcProtocol, object);
-    if (err)
-      return err;
+Error APIJSONParser::parseProtocol(const Value &protocol) {
+  const auto *object = protocol.getAsObject();
+  if (!object)
+    return make_error<APIJSONError>("Expect to be JSON Object");
 
-    err = parseIvars(objcProtocol, object);
-    if (err)
-      return err;
-  }
-  return Error::success();
+  auto name = parseName(object);
+  if (!name)
+    return name.takeError();
+  auto access = parseAccess(object);
+  if (!access)
+    return access.takeError();
+  auto loc = parseLocation(object);
+  if (!loc)
+    return loc.takeError();
+  auto avail = parseAvailability(object);
+  if (!avail)
+    return avail.takeError();
+
+  auto *objcProtocol =
+      result.addObjCProtocol(*name, *loc, *avail, *access, /*Decl*/ nullptr);
+  return parseObjCContainer(objcProtocol, object);
 }
 
 Error APIJSONParser::parseEnumConstants(EnumRecord *record,
@@ -1058,60 +1011,53 @@ Error APIJSONParser::parseEnumConstants(EnumRecord *record,
   return Error::success();
 }
 
-Error APIJSONParser::parseEnums(Array &enums) {
-  for (const auto &e : enums) {
-    auto *object = e.getAsObject();
-    if (!object)
-      return make_error<APIJSONError>("Expect to be JSON Object");
-
-    auto name = parseName(object);
-    if (!name)
-      return name.takeError();
-    auto access = parseAccess(object);
-    if (!access)
-      return access.takeError();
-    auto loc = parseLocation(object);
-    if (!loc)
-      return loc.takeError();
-    auto avail = parseAvailability(object);
-    if (!avail)
-      return avail.takeError();
-    auto usr = parseUSR(object);
+Error APIJSONParser::parseEnum(const Value &value) {
+  const auto *object = value.getAsObject();
+  if (!object)
+    return make_error<APIJSONError>("Expect to be JSON Object");
 
-    auto *record =
-        result.addEnum(*name, usr, *loc, *avail, *access, /*Decl*/ nullptr);
-    auto err = parseEnumConstants(record, object);
-    if (err)
-      return err;
-  }
-  return Error::success();
+  auto name = parseName(object);
+  if (!name)
+    return name.takeError();
+  auto access = parseAccess(object);
+  if (!access)
+    return access.takeError();
+  auto loc = parseLocation(object);
+  if (!loc)
+    return loc.takeError();
+  auto avail = parseAvailability(object);
+  if (!avail)
+    return avail.takeError();
+  auto usr = parseUSR(object);
+
+  auto *record =
+      result.addEnum(*name, usr, *loc, *avail, *access, /*Decl*/ nullptr);
+  return parseEnumConstants(record, object);
 }
 
-Error APIJSONParser::parseTypedefs(Array &typedefs) {
-  for (const auto &type : typedefs) {
-    auto *object = type.getAsObject();
-    if (!object)
-      return make_error<APIJSONError>("Expect to be JSON Object");
+Error APIJSONParser::parseTypedef(const Value &type) {
+  const auto *object = type.getAsObject();
+  if (!object)
+    return make_error<APIJSONError>("Expect to be JSON Object");
 
-    auto name = parseName(object);
-    if (!name)
-      return name.takeError();
-    auto access = parseAccess(object);
-    if (!access)
-      return access.takeError();
-    auto loc = parseLocation(object);
-    if (!loc)
-      return loc.takeError();
-    auto avail = parseAvailability(object);
-    if (!avail)
-      return avail.takeError();
-
-    result.addTypeDef(*name, *loc, *avail, *access, /*Decl*/ nullptr);
-  }
+  auto name = parseName(object);
+  if (!name)
+    return name.takeError();
+  auto access = parseAccess(object);
+  if (!access)
+    return access.takeError();
+  auto loc = parseLocation(object);
+  if (!loc)
+    return loc.takeError();
+  auto avail = parseAvailability(object);
+  if (!avail)
+    return avail.takeError();
+
+  result.addTypeDef(*name, *loc, *avail, *access, /*Decl*/ nullptr);
   return Error::success();
 }
 
-Error APIJSONParser::parseBinaryInfo(Object &binaryInfo) {
+Error APIJSONParser::parseBinaryInfo(const Object &binaryInfo) {
   auto &info = result.getBinaryInfo();
   auto fileType = binaryInfo.getString("type");
   if (!fileType)
@@ -1168,96 +1114,145 @@ Error APIJSONParser::parseBinaryInfo(Object &binaryInfo) {
   return Error::success();
 }
 
-Error APIJSONParser::parsePotentiallyDefinedSelectors(Array &selectors) {
-  for (auto &s : selectors) {
-    auto name = s.getAsString();
-    if (!name)
-      return make_error<APIJSONError>(
-          "potentially defined selector is not string");
-    result.getPotentiallyDefinedSelectors().insert(*name);
-  }
+Error APIJSONParser::parsePotentiallyDefinedSelector(const Value &selector) {
+  auto name = selector.getAsString();
+  if (!name)
+    return make_error<APIJSONError>(
+        "potentially defined selector is not string");
+  result.getPotentiallyDefinedSelectors().insert(*name);
   return Error::success();
 }
 
+const APIJSONParser::Section APIJSONParser::sections[] = {
+    {"globals", &APIJSONParser::parseGlobal},
+    {"protocols", &APIJSONParser::parseProtocol},
+    {"interfaces", &APIJSONParser::parseInterface},
+    {"categories", &APIJSONParser::parseCategory},
+    {"enums", &APIJSONParser::parseEnum},
+    {"typedefs", &APIJSONParser::parseTypedef},
+    {"potentiallyDefinedSelectors",
+     &APIJSONParser::parsePotentiallyDefinedSelector},
+};
+
 Error APIJSONParser::parse(Object *root) {
-  auto *globals = root->getArray("globals");
-  if (globals) {
-    auto err = parseGlobals(*globals);
-    if (err)
-      return err;
+  for (const auto &section : sections) {
+    auto *elements = root->getArray(section.key);
+    if (!elements)
+      continue;
+    for (const auto &element : *elements) {
+      auto err = (this->*section.parseElement)(element);
+      if (err)
+        return err;
+    }
   }
 
-  auto *protocols = root->getArray("protocols");
-  if (protocols) {
-    auto err = parseProtocols(*protocols);
-    if (err)
-      return err;
-  }
+  auto *binaryInfo = root->getObject("binaryInfo");
+  if (binaryInfo)
+    return parseBinaryInfo(*binaryInfo);
 
-  auto *interfaces = root->getArray("interfaces");
-  if (interfaces) {
-    auto err = parseInterfaces(*interfaces);
-    if (err)
-      return err;
-  }
+  return Error::success();
+}
 
-  auto *categories = root->getArray("categories");
-  if (categories) {
-    auto err = parseCategories(*categories);
-    if (err)
-      return err;
-  }
+/// Parse the JSON text of the member \p key of \p members, or null if there
+/// is no such member.
+static Expected<Value> parseMember(const StringMap<StringRef> &members,
+                                   StringRef key) {
+  auto member = members.find(key);
+  if (member == members.end())
+    return Value(nullptr);
+  return json::parse(member->second);
+}
 
-  auto *enums = root->getArray("enums");
-  if (enums) {
-    auto err = parseEnums(*enums);
-    if (err)
-      return err;
-  }
+/// Parse the elements of the JSON array \p json one by one. Like
+/// json::Object::getArray, a value that isn't an array is ignored.
+static Error forEachElement(StringRef json,
+                            function_ref<Error(const Value &)> callback) {
+  JSONStreamReader reader(json);
+  auto token = reader.next();
+  if (!token)
+    return token.takeError();
+  if (*token != JSONStreamReader::Token::ArrayBegin)
+    return Error::success();
 
-  auto *typedefs = root->getArray("typedefs");
-  if (typedefs) {
-    auto err = parseTypedefs(*typedefs);
-    if (err)
+  while (true) {
+    token = reader.next();
+    if (!token)
+      return token.takeError();
+    if (*token == JSONStreamReader::Token::ArrayEnd)
+      return Error::success();
+
+    auto element = reader.parseValue();
+    if (!element)
+      return element.takeError();
+    if (auto err = callback(*element))
       return err;
   }
+}
 
-  auto *selectors = root->getArray("potentiallyDefinedSelectors");
-  if (selectors) {
-    auto err = parsePotentiallyDefinedSelectors(*selectors);
+Error APIJSONParser::parse(const StringMap<StringRef> &members) {
+  for (const auto &section : sections) {
+    auto member = members.find(section.key);
+    if (member == members.end())
+      continue;
+    auto err = forEachElement(member->second, [&](const Value &element) {
+      return (this->*section.parseElement)(element);
+    });
     if (err)
       return err;
   }
 
-  auto *binaryInfo = root->getObject("binaryInfo");
-  if (binaryInfo) {
-    auto err = parseBinaryInfo(*binaryInfo);
-    if (err)
-      return err;
-  }
+  auto binaryInfo = parseMember(members, "binaryInfo");
+  if (!binaryInfo)
+    return binaryInfo.takeError();
+  if (const auto *object = binaryInfo->getAsObject())
+    return parseBinaryInfo(*object);
 
   return Error::success();
 }
 
-Expected<API> APIJSONSerializer::parse(StringRef json) {
-  auto inputValue = json::parse(json);
-  if (!inputValue)
-    return inputValue.takeError();
-
-  auto *root = inputValue->getAsObject();
-  if (!root)
+/// Collect the text of the members of the JSON object \p json without parsing
+/// them. Like json::Object, the last member with the same key wins.
+static Expected<StringMap<StringRef>> readMembers(StringRef json) {
+  JSONStreamReader reader(json);
+  auto token = reader.next();
+  if (!token)
+    return token.takeError();
+  if (*token != JSONStreamReader::Token::ObjectBegin) {
+    // Report malformed input before the unexpected type, like json::parse.
+    if (auto err = reader.skipValue())
+      return std::move(err);
+    token = reader.next();
+    if (!token)
+      return token.takeError();
     return make_error<APIJSONError>("API is not a JSON Object");
+  }
 
-  auto version = root->getInteger("api_json_version");
-  if (!version || *version != 1)
-    return make_error<APIJSONError>("Input JSON has unsupported version");
+  StringMap<StringRef> members;
+  while (true) {
+    token = reader.next();
+    if (!token)
+      return token.takeError();
+    if (*token == JSONStreamReader::Token::ObjectEnd)
+      break;
+
+    auto &member = members[reader.getValue()];
+    token = reader.next();
+    if (!token)
+      return token.takeError();
+    auto text = reader.readRawValue();
+    if (!text)
+      return text.takeError();
+    member = *text;
+  }
 
-  return parse(root);
+  token = reader.next();
+  if (!token)
+    return token.takeError();
+  return std::move(members);
 }
 
-Expected<API> APIJSONSerializer::parse(Object *root, bool publicOnly,
-                                       Triple *triple) {
-  auto target = root->getString("target");
+static Expected<API> createAPI(Optional<StringRef> target,
+                               Optional<StringRef> project, Triple *triple) {
   std::string targetStr;
   if (target)
     targetStr = target->str();
@@ -1269,11 +1264,66 @@ Expected<API> APIJSONSerializer::parse(Object *root, bool publicOnly,
   Triple targetTriples(targetStr);
   API result(targetTriples);
 
-  auto project = root->getString("project");
   if (project)
     result.setProjectName(*project);
 
-  APIJSONParser parser(result, publicOnly);
+  return result;
+}
+
+static Expected<API> parseMembers(const StringMap<StringRef> &members,
+                                  bool publicOnly, Triple *triple) {
+  auto target = parseMember(members, "target");
+  if (!target)
+    return target.takeError();
+  auto project = parseMember(members, "project");
+  if (!project)
+    return project.takeError();
+
+  auto result =
+      createAPI(target->getAsString(), project->getAsString(), triple);
+  if (!result)
+    return result.takeError();
+
+  APIJSONParser parser(*result, publicOnly);
+  auto err = parser.parse(members);
+  if (err)
+    return std::move(err);
+
+  return result;
+}
+
+Expected<API> APIJSONSerializer::parse(StringRef json) {
+  auto members = readMembers(json);
+  if (!members)
+    return members.takeError();
+
+  auto version = parseMember(*members, "api_json_version");
+  if (!version)
+    return version.takeError();
+  auto versionNumber = version->getAsInteger();
+  if (!versionNumber || *versionNumber != 1)
+    return make_error<APIJSONError>("Input JSON has unsupported version");
+
+  return parseMembers(*members, /*publicOnly=*/false, /*triple=*/nullptr);
+}
+
+Expected<API> APIJSONSerializer::parseObject(StringRef json, bool publicOnly,
+                                             Triple *triple) {
+  auto members = readMembers(json);
+  if (!members)
+    return members.takeError();
+
+  return parseMembers(*members, publicOnly, triple);
+}
+
+Expected<API> APIJSONSerializer::parse(Object *root, bool publicOnly,
+                                       Triple *triple) {
+  auto result =
+      createAPI(root->getString("target"), root->getString("project"), triple);
+  if (!result)
+    return result.takeError();
+
+  APIJSONParser parser(*result, publicOnly);
   auto err = parser.parse(root);
   if (err)
     return std::move(err);
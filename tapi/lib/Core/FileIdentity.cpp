@@ -0,0 +1,73 @@
+//===- FileIdentity.cpp - File Identity -------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Implements the file identity.
+///
+//===----------------------------------------------------------------------===//
+
+#include "tapi/Core/FileIdentity.h"
+#include "llvm/Support/FileSystem.h"
+
+using namespace llvm;
+
+TAPI_NAMESPACE_INTERNAL_BEGIN
+
+Optional<FileIdentity> FileIdentity::get(StringRef path) {
+  sys::fs::file_status status;
+  if (sys::fs::status(path, status))
+    return None;
+
+  FileIdentity identity;
+  identity.size = status.getSize();
+  identity.modificationTime =
+      status.getLastModificationTime().time_since_epoch().count();
+  identity.inode = status.getUniqueID().getFile();
+  return identity;
+}
+
+Optional<FileIdentity> FileIdentity::get(vfs::FileSystem &fs, StringRef path) {
+  auto status = fs.status(path);
+  if (!status)
+    return None;
+
+  FileIdentity identity;
+  identity.size = status->getSize();
+  identity.modificationTime =
+      status->getLastModificationTime().time_since_epoch().count();
+  identity.inode = status->getUniqueID().getFile();
+  return identity;
+}
+
+json::Value toJSON(const FileIdentity &identity) {
+  return json::Array{identity.size, identity.modificationTime, identity.inode};
+}
+
+bool fromJSON(const json::Value &value, FileIdentity &identity,
+              json::Path path) {
+  const auto *array = value.getAsArray();
+  if (!array || array->size() != 3) {
+    path.report("expected file identity");
+    return false;
+  }
+
+  auto size = (*array)[0].getAsUINT64();
+  auto modificationTime = (*array)[1].getAsInteger();
+  auto inode = (*array)[2].getAsUINT64();
+  if (!size || !modificationTime || !inode) {
+    path.report("expected file identity");
+    return false;
+  }
+
+  identity.size = *size;
+  identity.modificationTime = *modificationTime;
+  identity.inode = *inode;
+  return true;
+}
+
+TAPI_NAMESPACE_INTERNAL_END
@@ -16,6 +16,7 @@
 #include "clang/Basic/FileSystemStatCache.h"
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/VirtualFileSystem.h"
 
 using namespace llvm;
@@ -44,4 +45,61 @@ bool FileManager::isSymlink(StringRef path) {
   return sys::fs::is_symlink_file(path);
 }
 
+const FileManager::DirectoryListing &
+FileManager::getDirectoryListing(StringRef directory) {
+  auto it = directoryListings.find(directory);
+  if (it != directoryListings.end())
+    return it->second;
+
+  DirectoryListing listing;
+  // A directory that is missing from the listing of its parent doesn't need
+  // to be read.
+  if (!mayExist(directory)) {
+    listing.isComplete = true;
+    return directoryListings[directory] = std::move(listing);
+  }
+
+  std::error_code ec;
+  auto &fs = getVirtualFileSystem();
+  vfs::directory_iterator i = fs.dir_begin(directory, ec), ie;
+  if (ec) {
+    // There is nothing in a directory that doesn't exist.
+    listing.isComplete = ec == std::errc::no_such_file_or_directory ||
+                         ec == std::errc::not_a_directory;
+    return directoryListings[directory] = std::move(listing);
+  }
+
+  for (; i != ie; i.increment(ec)) {
+    // Broken symlinks are still listed.
+    if (ec && ec != std::errc::no_such_file_or_directory)
+      break;
+    ec.clear();
+    listing.names.insert(sys::path::filename(i->path()).lower());
+  }
+  listing.isComplete = !ec;
+
+  return directoryListings[directory] = std::move(listing);
+}
+
+bool FileManager::mayExist(StringRef path) {
+  auto name = sys::path::filename(path);
+  auto parent = sys::path::parent_path(path);
+  // Relative and root paths, or paths with dots, are not resolved.
+  if (parent.empty() || name.empty() || name == "." || name == ".." ||
+      parent == path)
+    return true;
+
+  const auto &listing = getDirectoryListing(parent);
+  if (!listing.isComplete)
+    return true;
+
+  return listing.names.count(name.lower());
+}
+
+void FileManager::invalidateDirectoryListings(StringRef path) {
+  for (auto parent = sys::path::parent_path(path); !parent.empty();
+       parent = sys::path::parent_path(parent))
+    directoryListings.erase(parent);
+}
+
 TAPI_NAMESPACE_INTERNAL_END
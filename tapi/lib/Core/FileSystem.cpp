@@ -175,18 +175,40 @@ MaskingOverlayFileSystem::openFileForRead(const Twine &path) {
   return OverlayFileSystem::openFileForRead(path);
 }
 
+void DirectoryPrefixSet::insert(StringRef directory) {
+  // Trailing separators would add an empty component.
+  while (directory.size() > 1 && sys::path::is_separator(directory.back()))
+    directory = directory.drop_back();
+
+  auto *node = &root;
+  for (auto it = sys::path::begin(directory), ie = sys::path::end(directory);
+       it != ie; ++it)
+    node = &node->children[*it];
+  node->isInSet = true;
+}
+
+bool DirectoryPrefixSet::contains(StringRef path) const {
+  const auto *node = &root;
+  for (auto it = sys::path::begin(path), ie = sys::path::end(path);
+       it != ie && !node->isInSet; ++it) {
+    auto child = node->children.find(*it);
+    if (child == node->children.end())
+      return false;
+    node = &child->second;
+  }
+  return node->isInSet;
+}
+
 PathMaskingOverlayFileSystem::PathMaskingOverlayFileSystem(
     IntrusiveRefCntPtr<FileSystem> base)
     : MaskingOverlayFileSystem(base) {}
 
 bool PathMaskingOverlayFileSystem::pathMasked(const Twine &path) const {
+  if (extraMaskingPaths.empty())
+    return false;
+
   SmallString<PATH_MAX> realPath;
-  auto p = path.toStringRef(realPath);
-  for (auto &mask : extraMaskingPath) {
-    if (p.startswith(mask))
-      return true;
-  }
-  return false;
+  return extraMaskingPaths.contains(path.toStringRef(realPath));
 }
 
 PublicSDKOverlayFileSystem::PublicSDKOverlayFileSystem(
@@ -15,6 +15,7 @@
 #include "tapi/Core/FileManager.h"
 #include "tapi/Core/Registry.h"
 #include "tapi/Defines.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/Support/Error.h"
 #include "llvm/TextAPI/TextAPIError.h"
 
@@ -24,7 +25,7 @@ TAPI_NAMESPACE_INTERNAL_BEGIN
 
 InterfaceFileManager::InterfaceFileManager(FileManager &fm,
                                            const bool isVolatile)
-    : _fm(fm), isVolatile(isVolatile) {
+    : _fm(&fm), isVolatile(isVolatile) {
   _registry.addYAMLReaders();
   _registry.addYAMLWriters();
   _registry.addBinaryReaders();
@@ -32,12 +33,28 @@ InterfaceFileManager::InterfaceFileManager(FileManager &fm,
   _registry.addJSONWriters();
 }
 
+void InterfaceFileManager::setFileManager(FileManager &fm,
+                                          const bool isVolatile) {
+  _fm = &fm;
+  this->isVolatile = isVolatile;
+}
+
 Expected<APIs &> InterfaceFileManager::readFile(const std::string &path) {
-  auto file = _fm.getFile(path);
+  SmallString<PATH_MAX> absolutePath(path);
+  _fm->makeAbsolutePath(absolutePath);
+
+  // Reuse the file if it didn't change since it was read.
+  auto identity =
+      FileIdentity::get(_fm->getVirtualFileSystem(), absolutePath);
+  auto it = _libraries.find(std::string(absolutePath));
+  if (it != _libraries.end() && identity && it->second.identity == identity)
+    return it->second.apis;
+
+  auto file = _fm->getFile(path);
   if (!file)
     return errorCodeToError(file.getError());
 
-  auto bufferOrErr = _fm.getBufferForFile(*file,
+  auto bufferOrErr = _fm->getBufferForFile(*file,
                                           /*RequiresNullTerminator=*/true,
                                           /*IsVolatile=*/isVolatile);
   if (!bufferOrErr)
@@ -48,30 +65,39 @@ Expected<APIs &> InterfaceFileManager::readFile(const std::string &path) {
   if (!apis)
     return apis.takeError();
 
+  auto &library = _libraries[std::string(absolutePath)];
+  library.identity = identity;
+
   // Use path location for lookup because
   // it's possible to contain different interfaces for the same library.
+  // Record the library under the requested path too, so it is found without
+  // reading the file again next time.
   if (!apis->empty()) {
     auto api = *apis->begin();
     if (api->hasBinaryInfo()) {
-      auto it = _libraries.find(api->getBinaryInfo().path.str());
-      if (it != _libraries.end())
-        return it->second;
+      SmallString<PATH_MAX> libraryPath(api->getBinaryInfo().path);
+      _fm->makeAbsolutePath(libraryPath);
+      auto it = _libraries.find(std::string(libraryPath));
+      if (it != _libraries.end() && libraryPath != absolutePath) {
+        library.apis = it->second.apis;
+        return library.apis;
+      }
     }
   }
 
-  auto result = _libraries.emplace(path, std::move(apis.get()));
-  return result.first->second;
+  library.apis = std::move(apis.get());
+  return library.apis;
 }
 
 InterfaceFileManager::WriteAction
 InterfaceFileManager::shouldWrite(const std::string &path,
                                   const InterfaceFile *file,
                                   FileType fileType) const {
-  auto existingFile = _fm.getFile(path);
+  auto existingFile = _fm->getFile(path);
   if (auto err = existingFile.getError())
     return WriteAction::NewFile;
 
-  auto bufferOrErr = _fm.getBufferForFile(*existingFile,
+  auto bufferOrErr = _fm->getBufferForFile(*existingFile,
                                           /*RequiresNullTerminator=*/true,
                                           /*IsVolatile=*/isVolatile);
   if (auto err = bufferOrErr.getError())
@@ -98,6 +124,8 @@ Error InterfaceFileManager::writeFile(const std::string &path,
   case WriteAction::SkipWrite:
     return Error::success();
   case WriteAction::NewFile:
+    // Make the new file visible to the library lookups.
+    _fm->invalidateDirectoryListings(path);
     return _registry.writeFile(path, file, fileType, /*replaceFile=*/false);
   case WriteAction::ReplaceFile:
     return _registry.writeFile(path, file, fileType, /*replaceFile=*/true);
@@ -0,0 +1,303 @@
+//===- lib/Core/JSONStreamReader.cpp - JSON Stream Reader -------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Implements the JSON stream reader.
+///
+//===----------------------------------------------------------------------===//
+
+#include "tapi/Core/JSONStreamReader.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/ConvertUTF.h"
+
+using namespace llvm;
+
+TAPI_NAMESPACE_INTERNAL_BEGIN
+
+Error JSONStreamReader::makeError(const char *msg) const {
+  unsigned line = 1;
+  size_t startOfLine = 0;
+  for (size_t i = 0; i < pos; ++i) {
+    if (input[i] == '\n') {
+      ++line;
+      startOfLine = i + 1;
+    }
+  }
+  return make_error<json::ParseError>(msg, line, pos - startOfLine, pos);
+}
+
+void JSONStreamReader::skipWhitespace() {
+  while (pos < input.size() &&
+         (input[pos] == ' ' || input[pos] == '\t' || input[pos] == '\n' ||
+          input[pos] == '\r'))
+    ++pos;
+}
+
+Expected<JSONStreamReader::Token> JSONStreamReader::next() {
+  skipWhitespace();
+  tokenStart = pos;
+  value = StringRef();
+
+  if (containers.empty()) {
+    if (state != State::AfterValue)
+      return readValue();
+    if (pos != input.size())
+      return makeError("Text after end of document");
+    return Token::EndOfInput;
+  }
+
+  auto container = containers.back();
+  char close = container == Container::Object ? '}' : ']';
+  switch (state) {
+  case State::ExpectFirst:
+    if (pos < input.size() && input[pos] == close)
+      return closeContainer(container);
+    return container == Container::Object ? readKey() : readValue();
+  case State::ExpectValue:
+    return readValue();
+  case State::AfterValue:
+    if (pos < input.size() && input[pos] == close)
+      return closeContainer(container);
+    if (pos >= input.size() || input[pos] != ',')
+      return makeError(container == Container::Object
+                           ? "Expected , or } after object property"
+                           : "Expected , or ] after array element");
+    ++pos;
+    skipWhitespace();
+    tokenStart = pos;
+    return container == Container::Object ? readKey() : readValue();
+  }
+  llvm_unreachable("unknown reader state");
+}
+
+JSONStreamReader::Token JSONStreamReader::closeContainer(Container kind) {
+  ++pos;
+  containers.pop_back();
+  state = State::AfterValue;
+  return kind == Container::Object ? Token::ObjectEnd : Token::ArrayEnd;
+}
+
+Expected<JSONStreamReader::Token> JSONStreamReader::readKey() {
+  if (pos >= input.size() || input[pos] != '"')
+    return makeError("Expected object key");
+  if (auto err = readString())
+    return std::move(err);
+
+  skipWhitespace();
+  if (pos >= input.size() || input[pos] != ':')
+    return makeError("Expected : after object key");
+  ++pos;
+  state = State::ExpectValue;
+  return Token::Key;
+}
+
+Expected<JSONStreamReader::Token> JSONStreamReader::readValue() {
+  if (pos >= input.size())
+    return makeError("Unexpected EOF");
+
+  char c = input[pos];
+  if (c == '{' || c == '[') {
+    ++pos;
+    bool isObject = c == '{';
+    containers.push_back(isObject ? Container::Object : Container::Array);
+    state = State::ExpectFirst;
+    return isObject ? Token::ObjectBegin : Token::ArrayBegin;
+  }
+
+  state = State::AfterValue;
+  if (c == '"') {
+    if (auto err = readString())
+      return std::move(err);
+    return Token::String;
+  }
+
+  auto rest = input.drop_front(pos);
+  for (StringRef literal : {"true", "false", "null"}) {
+    if (!rest.startswith(literal))
+      continue;
+    pos += literal.size();
+    if (literal == "null")
+      return Token::Null;
+    value = literal;
+    return Token::Boolean;
+  }
+
+  // Number: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+  size_t start = pos;
+  auto skipDigits = [&]() {
+    size_t first = pos;
+    while (pos < input.size() && isDigit(input[pos]))
+      ++pos;
+    return pos != first;
+  };
+  if (input[pos] == '-')
+    ++pos;
+  if (!skipDigits())
+    return makeError("Invalid JSON value");
+  if (pos < input.size() && input[pos] == '.') {
+    ++pos;
+    if (!skipDigits())
+      return makeError("Invalid JSON value (number?)");
+  }
+  if (pos < input.size() && (input[pos] == 'e' || input[pos] == 'E')) {
+    ++pos;
+    if (pos < input.size() && (input[pos] == '+' || input[pos] == '-'))
+      ++pos;
+    if (!skipDigits())
+      return makeError("Invalid JSON value (number?)");
+  }
+  value = input.slice(start, pos);
+  return Token::Number;
+}
+
+Error JSONStreamReader::readString() {
+  assert(input[pos] == '"' && "expected the start of a string");
+  size_t start = ++pos;
+
+  // Most strings have no escapes and can refer to the input directly.
+  size_t end = input.find_first_of("\"\\", start);
+  if (end == StringRef::npos) {
+    pos = input.size();
+    return makeError("Unterminated string");
+  }
+  if (input[end] == '"') {
+    value = input.slice(start, end);
+    pos = end + 1;
+    if (any_of(value, [](char c) { return (unsigned char)c < 0x20; }))
+      return makeError("Control character in string");
+    if (!json::isUTF8(value))
+      return makeError("Invalid UTF-8 sequence");
+    return Error::success();
+  }
+
+  unescaped.assign(input.data() + start, end - start);
+  pos = end;
+  while (true) {
+    if (pos >= input.size())
+      return makeError("Unterminated string");
+    char c = input[pos++];
+    if (c == '"')
+      break;
+    if ((unsigned char)c < 0x20)
+      return makeError("Control character in string");
+    if (c != '\\') {
+      unescaped.push_back(c);
+      continue;
+    }
+
+    if (pos >= input.size())
+      return makeError("Unterminated string");
+    switch (input[pos++]) {
+    case '"':
+    case '\\':
+    case '/':
+      unescaped.push_back(input[pos - 1]);
+      break;
+    case 'b':
+      unescaped.push_back('\b');
+      break;
+    case 'f':
+      unescaped.push_back('\f');
+      break;
+    case 'n':
+      unescaped.push_back('\n');
+      break;
+    case 'r':
+      unescaped.push_back('\r');
+      break;
+    case 't':
+      unescaped.push_back('\t');
+      break;
+    case 'u':
+      if (auto err = readUnicodeEscape(unescaped))
+        return err;
+      break;
+    default:
+      return makeError("Invalid escape sequence");
+    }
+  }
+
+  if (!json::isUTF8(unescaped))
+    return makeError("Invalid UTF-8 sequence");
+  value = unescaped;
+  return Error::success();
+}
+
+Error JSONStreamReader::readUnicodeEscape(std::string &out) {
+  auto readHex = [&](unsigned &codeUnit) {
+    if (pos + 4 > input.size())
+      return false;
+    codeUnit = 0;
+    for (char c : input.substr(pos, 4)) {
+      if (!isHexDigit(c))
+        return false;
+      codeUnit = (codeUnit << 4) | hexDigitValue(c);
+    }
+    pos += 4;
+    return true;
+  };
+
+  unsigned codePoint;
+  if (!readHex(codePoint))
+    return makeError("Invalid \\u escape sequence");
+
+  // Combine surrogate pairs. Lone surrogates are replaced, like
+  // llvm::json::parse does.
+  if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+    unsigned low;
+    size_t savedPos = pos;
+    if (input.substr(pos).startswith("\\u") && (pos += 2, readHex(low)) &&
+        low >= 0xDC00 && low <= 0xDFFF) {
+      codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+    } else {
+      pos = savedPos;
+      codePoint = 0xFFFD;
+    }
+  } else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF) {
+    codePoint = 0xFFFD;
+  }
+
+  char buffer[UNI_MAX_UTF8_BYTES_PER_CODE_POINT];
+  char *end = buffer;
+  ConvertCodePointToUTF8(codePoint, end);
+  out.append(buffer, end);
+  return Error::success();
+}
+
+Error JSONStreamReader::skipValue() {
+  size_t depth = containers.size();
+  // Scalars are complete already, and so are empty containers once their
+  // end was read.
+  if (state != State::ExpectFirst)
+    return Error::success();
+
+  while (containers.size() >= depth) {
+    auto token = next();
+    if (!token)
+      return token.takeError();
+    if (*token == Token::EndOfInput)
+      return makeError("Unexpected EOF");
+  }
+  return Error::success();
+}
+
+Expected<StringRef> JSONStreamReader::readRawValue() {
+  size_t start = tokenStart;
+  if (auto err = skipValue())
+    return std::move(err);
+  return input.slice(start, pos);
+}
+
+Expected<json::Value> JSONStreamReader::parseValue() {
+  auto text = readRawValue();
+  if (!text)
+    return text.takeError();
+  return json::parse(*text);
+}
+
+TAPI_NAMESPACE_INTERNAL_END
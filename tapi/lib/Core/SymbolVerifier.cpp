@@ -733,11 +733,13 @@ SymbolVerifier::verify(const ObjCInstanceVariableRecord *record,
 }
 
 std::unique_ptr<SymbolSet> SymbolVerifier::getExports() {
+  API2SymbolConverter converter(exports.get());
   for (auto &cov : coverageSymbols) {
     SimpleVisitor visitor{cov.get()};
-    API2SymbolConverter converter(exports.get(), cov->getTarget());
+    converter.setTarget(cov->getTarget());
     visitor.visit(converter);
   }
+  converter.finish();
 
   // TODO: Handle alias list with -Xarch.
   for (const auto &[alias, base] : aliases) {
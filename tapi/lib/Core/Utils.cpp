@@ -119,6 +119,12 @@ std::string findLibrary(StringRef installName, FileManager &fm,
                         ArrayRef<std::string> frameworkSearchPaths,
                         ArrayRef<std::string> librarySearchPaths,
                         ArrayRef<std::string> searchPaths) {
+  // Most candidates don't exist, rule them out with the cached directory
+  // listings before asking the file system.
+  auto exists = [&fm](StringRef path) {
+    return fm.mayExist(path) && fm.exists(path);
+  };
+
   auto filename = sys::path::filename(installName);
   bool isFramework = sys::path::parent_path(installName)
                          .endswith((filename + ".framework").str());
@@ -130,10 +136,10 @@ std::string findLibrary(StringRef installName, FileManager &fm,
 
       SmallString<PATH_MAX> tbdPath = fullPath;
       TAPI_INTERNAL::replace_extension(tbdPath, ".tbd");
-      if (fm.exists(tbdPath))
+      if (exists(tbdPath))
         return tbdPath.str().str();
 
-      if (fm.exists(fullPath))
+      if (exists(fullPath))
         return fullPath.str().str();
     }
   } else {
@@ -149,10 +155,10 @@ std::string findLibrary(StringRef installName, FileManager &fm,
         SmallString<PATH_MAX> tbdPath = fullPath;
         TAPI_INTERNAL::replace_extension(tbdPath, ".tbd");
 
-        if (fm.exists(tbdPath))
+        if (exists(tbdPath))
           return tbdPath.str().str();
 
-        if (fm.exists(fullPath))
+        if (exists(fullPath))
           return fullPath.str().str();
       }
     }
@@ -165,10 +171,10 @@ std::string findLibrary(StringRef installName, FileManager &fm,
     SmallString<PATH_MAX> tbdPath = fullPath;
     TAPI_INTERNAL::replace_extension(tbdPath, ".tbd");
 
-    if (fm.exists(tbdPath))
+    if (exists(tbdPath))
       return tbdPath.str().str();
 
-    if (fm.exists(fullPath))
+    if (exists(fullPath))
       return fullPath.str().str();
   }
 
@@ -179,18 +185,19 @@ namespace {
 
 std::unique_ptr<InterfaceFile> createInterfaceFile(const APIs &apis,
                                                    StringRef installName) {
-  // Pickup symbols first.
+  // Pickup symbols first. Each symbol is added once, with all its targets.
   auto symbols = std::make_unique<SymbolSet>();
+  API2SymbolConverter converter(symbols.get());
   for (auto &api : apis) {
     auto libName = api->getInstallName();
     if (!libName || *libName != installName)
       continue;
     bool includeUndefs =
         api->hasBinaryInfo() && !api->getBinaryInfo().isTwoLevelNamespace;
-    const auto target = Target(api->getTarget());
-    API2SymbolConverter converter(symbols.get(), target, includeUndefs);
+    converter.setTarget(Target(api->getTarget()), includeUndefs);
     api->visit(converter);
   }
+  converter.finish();
 
   auto file = std::make_unique<InterfaceFile>(std::move(symbols));
   // Assign other attributes.
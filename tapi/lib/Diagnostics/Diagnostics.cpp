@@ -52,6 +52,23 @@ struct DiagInfoRec {
   bool operator<(const DiagInfoRec &rhs) const { return id < rhs.id; }
 };
 
+/// Stores the diagnostics instead of printing them.
+class BufferingDiagnosticConsumer : public clang::DiagnosticConsumer {
+public:
+  explicit BufferingDiagnosticConsumer(
+      std::vector<clang::StoredDiagnostic> &buffer)
+      : buffer(buffer) {}
+
+  void HandleDiagnostic(clang::DiagnosticsEngine::Level level,
+                        const clang::Diagnostic &info) override {
+    clang::DiagnosticConsumer::HandleDiagnostic(level, info);
+    buffer.emplace_back(level, info);
+  }
+
+private:
+  std::vector<clang::StoredDiagnostic> &buffer;
+};
+
 } // end anonymous namespace.
 
 TAPI_NAMESPACE_INTERNAL_BEGIN
@@ -123,6 +140,23 @@ DiagnosticsEngine::getDiagnosticLevel(unsigned diagID) {
   return level;
 }
 
+void DiagnosticsEngine::startBuffering(
+    std::vector<clang::StoredDiagnostic> &buffer) {
+  assert(!bufferingClient && "diagnostics are already buffered");
+  savedOwnsClient = diag->ownsClient();
+  savedClient = savedOwnsClient ? diag->takeClient().release()
+                                : diag->getClient();
+  bufferingClient = std::make_unique<BufferingDiagnosticConsumer>(buffer);
+  diag->setClient(bufferingClient.get(), /*ShouldOwnClient=*/false);
+}
+
+void DiagnosticsEngine::stopBuffering() {
+  assert(bufferingClient && "diagnostics are not buffered");
+  diag->setClient(savedClient, savedOwnsClient);
+  bufferingClient.reset();
+  savedClient = nullptr;
+}
+
 void DiagnosticsEngine::setDiagLevel(unsigned diagID,
     clang::DiagnosticIDs::Level level) {
   auto entry = diagLevelMap.insert({diagID, level});
@@ -71,7 +71,7 @@ void APINormalizer::updateAPILoc(APIRecord &record) {
   }
   // Compute the realPath.
   SmallString<PATH_MAX> realPath;
-  auto ec = llvm::sys::fs::real_path(path, realPath);
+  auto ec = getRealPath(path, realPath);
   if (!ec)
     path = realPath;
   auto hasRoot = path.find("/Root/");
@@ -83,6 +83,57 @@ void APINormalizer::updateAPILoc(APIRecord &record) {
                       record.loc.getColumn());
 }
 
+/// Get the real path of \p path like llvm::sys::fs::real_path, but resolve
+/// its directory from the cache. A file listed in the directory under the
+/// same name that isn't a symlink is its own real path. Anything else, like a
+/// symlink or a name that differs in case on a case insensitive file system,
+/// still goes through real_path.
+std::error_code APINormalizer::getRealPath(StringRef path,
+                                           SmallVectorImpl<char> &realPath) {
+  auto directory = llvm::sys::path::parent_path(path);
+  auto filename = llvm::sys::path::filename(path);
+  if (directory.empty() || filename == "." || filename == "..")
+    return llvm::sys::fs::real_path(path, realPath);
+
+  auto cachedDirectory = directoryMap.find(directory);
+  if (cachedDirectory == directoryMap.end())
+    cachedDirectory =
+        directoryMap.try_emplace(directory, readDirectory(directory)).first;
+  if (!cachedDirectory->getValue())
+    return std::make_error_code(std::errc::no_such_file_or_directory);
+
+  const auto &dir = *cachedDirectory->getValue();
+  auto file = dir.files.find(filename);
+  if (file == dir.files.end() ||
+      file->getValue() == llvm::sys::fs::file_type::symlink_file ||
+      file->getValue() == llvm::sys::fs::file_type::type_unknown)
+    return llvm::sys::fs::real_path(path, realPath);
+
+  realPath.assign(dir.realPath.begin(), dir.realPath.end());
+  llvm::sys::path::append(realPath, filename);
+  return {};
+}
+
+llvm::Optional<APINormalizer::Directory>
+APINormalizer::readDirectory(StringRef path) {
+  SmallString<PATH_MAX> realDirectory;
+  if (llvm::sys::fs::real_path(path, realDirectory))
+    return llvm::None;
+
+  Directory directory;
+  directory.realPath = realDirectory.str().str();
+  // Without following symlinks, the type is the one of the entry itself: from
+  // the directory listing, or from an lstat where the listing doesn't have it.
+  std::error_code ec;
+  for (llvm::sys::fs::directory_iterator i(realDirectory, ec,
+                                           /*follow_symlinks=*/false),
+       ie;
+       i != ie && !ec; i.increment(ec))
+    directory.files.try_emplace(llvm::sys::path::filename(i->path()),
+                                i->type());
+  return directory;
+}
+
 void APINormalizer::updateContainer(ObjCContainerRecord &record) {
   for (auto *method : record.methods)
     updateAPIRecord(*method);
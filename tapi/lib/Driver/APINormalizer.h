@@ -13,6 +13,10 @@
 
 #include "tapi/Core/APIVisitor.h"
 #include "tapi/Defines.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/FileSystem.h"
+#include <system_error>
 
 #ifndef TAPI_DRIVER_APINORMALIZER_H
 #define TAPI_DRIVER_APINORMALIZER_H
@@ -34,9 +38,22 @@ private:
   void updateAPIRecord(APIRecord &record);
   void updateAPILoc(APIRecord &record);
   void updateContainer(ObjCContainerRecord &record);
+  std::error_code getRealPath(StringRef path,
+                              SmallVectorImpl<char> &realPath);
+
+  /// A directory resolved with real_path, and the type of each file in it
+  /// keyed by its name on disk.
+  struct Directory {
+    std::string realPath;
+    llvm::StringMap<llvm::sys::fs::file_type> files;
+  };
+  static llvm::Optional<Directory> readDirectory(StringRef path);
 
   bool isPublicLibrary = false;
   llvm::StringMap<std::string> fileMap;
+  /// Each directory, or None if it can't be resolved. The headers of a
+  /// library share few directories, so each is resolved and listed once.
+  llvm::StringMap<llvm::Optional<Directory>> directoryMap;
 };
 
 TAPI_NAMESPACE_INTERNAL_END
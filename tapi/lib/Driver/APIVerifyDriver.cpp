@@ -23,18 +23,22 @@
 #include "tapi/Driver/Options.h"
 #include "tapi/Frontend/Frontend.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Process.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/YAMLTraits.h"
 #include "llvm/Support/raw_ostream.h"
+#include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/Version.inc"
+#include "clang/Driver/DriverDiagnostic.h"
 #include "clang/Config/config.h"
 
 using namespace llvm;
@@ -58,6 +62,7 @@ struct APIComparsionConfiguration {
   unsigned diagnosticDepth;
   std::string allowlist;
   std::string diagStyle;
+  std::string cache;
   APIComparsionContext base;
   APIComparsionContext variant;
 };
@@ -90,6 +95,7 @@ template <> struct MappingTraits<APIComparsionConfiguration> {
     io.mapOptional("diag-depth", config.diagnosticDepth, 4);
     io.mapOptional("allowlist", config.allowlist);
     io.mapOptional("diag-style", config.diagStyle);
+    io.mapOptional("cache", config.cache);
   }
 };
 
@@ -170,36 +176,37 @@ static bool populateHeaderSeq(StringRef path, HeaderSeq &headerFiles,
   return true;
 }
 
-TAPI_NAMESPACE_INTERNAL_BEGIN
-
-/// \brief Parses the headers and generate a text-based stub file.
-bool Driver::APIVerify::run(DiagnosticsEngine &diag, Options &opts) {
-  if (opts.driverOptions.inputs.size() != 1) {
-    diag.report(diag::err_expected_one_input_file);
+static bool readConfiguration(StringRef inputFilename,
+                              APIComparsionConfiguration &config,
+                              DiagnosticsEngine &diag) {
+  auto inputBuf = MemoryBuffer::getFile(inputFilename);
+  if (!inputBuf) {
+    diag.report(diag::err_cannot_open_file)
+        << inputFilename << inputBuf.getError().message();
     return false;
   }
-
-  auto inputFilename = opts.driverOptions.inputs.front();
-  // Parse input.
-  APIComparsionConfiguration config;
-  {
-    auto inputBuf = MemoryBuffer::getFile(inputFilename);
-    if (!inputBuf) {
-      diag.report(diag::err_cannot_open_file)
-          << inputFilename << inputBuf.getError().message();
-      return false;
-    }
-    yaml::Input yin((*inputBuf)->getMemBufferRef());
-    yin >> config;
-    if (yin.error()) {
-      diag.report(diag::err_invalid_input_file) << inputFilename;
-      return false;
-    }
+  yaml::Input yin((*inputBuf)->getMemBufferRef());
+  yin >> config;
+  if (yin.error()) {
+    diag.report(diag::err_invalid_input_file) << inputFilename;
+    return false;
   }
+  return true;
+}
 
+/// \brief Parses the headers of base and variant and compares them.
+///
+/// Clang prints its diagnostics to \p diagStream and everything else is
+/// reported to \p diag, so several configurations can be verified at once.
+static bool verifyConfiguration(const APIComparsionConfiguration &config,
+                                const Options &opts,
+                                StringRef moduleCachePath,
+                                APIVerifierCache *cache,
+                                DiagnosticsEngine &diag,
+                                raw_ostream &diagStream) {
   std::vector<FrontendContext> results;
   FileManager fm((clang::FileSystemOptions()));
-  auto parseHeaders = [&](APIComparsionContext &context) {
+  auto parseHeaders = [&](const APIComparsionContext &context) {
     FrontendJob job;
     HeaderSeq headers;
     if (!populateHeaderSeq(context.path, headers, fm, diag))
@@ -218,6 +225,10 @@ bool Driver::APIVerify::run(DiagnosticsEngine &diag, Options &opts) {
     job.frameworkPaths = opts.frontendOptions.frameworkPaths;
     job.systemFrameworkPaths = context.additionalFrameworks;
     job.systemIncludePaths = context.additionalIncludes;
+    job.enableModules = opts.frontendOptions.enableModules;
+    job.moduleCachePath = moduleCachePath.str();
+    job.validateSystemHeaders = opts.frontendOptions.validateSystemHeaders;
+    job.diagnosticStream = &diagStream;
     auto contextOrError = runFrontend(job);
     if (auto err = contextOrError.takeError())
       return canIgnoreFrontendError(err);
@@ -250,11 +261,106 @@ bool Driver::APIVerify::run(DiagnosticsEngine &diag, Options &opts) {
                    .Case("warning", APIVerifierDiagStyle::Warning)
                    .Case("error", APIVerifierDiagStyle::Error)
                    .Default(APIVerifierDiagStyle::Error);
+  if (cache)
+    apiVerifier.setCache(cache);
+
   apiVerifier.verify(results.front(), results.back(), config.diagnosticDepth,
                      !config.skipExtern, style, config.missingAPI,
                      config.noCascadingDiags);
 
-  return 0;
+  return !apiVerifier.hasErrorOccurred();
+}
+
+TAPI_NAMESPACE_INTERNAL_BEGIN
+
+/// \brief Compares the APIs of the frameworks described by each input
+/// configuration.
+///
+/// The configurations are verified concurrently, unless -v is given. With
+/// -fmodules they share one module cache, so the system headers common to all
+/// frameworks are only parsed once. The diagnostics of every configuration are
+/// printed together, in the order of the inputs.
+bool Driver::APIVerify::run(DiagnosticsEngine &diag, Options &opts) {
+  const auto &inputs = opts.driverOptions.inputs;
+  if (inputs.empty()) {
+    diag.report(clang::diag::err_drv_no_input_files);
+    return false;
+  }
+
+  std::vector<APIComparsionConfiguration> configs(inputs.size());
+  for (size_t i = 0, e = inputs.size(); i != e; ++i)
+    if (!readConfiguration(inputs[i], configs[i], diag))
+      return false;
+
+  // Configurations that name the same cache share it.
+  StringMap<std::unique_ptr<APIVerifierCache>> caches;
+  for (const auto &config : configs) {
+    if (config.cache.empty() || caches.count(config.cache))
+      continue;
+    auto cache = std::make_unique<APIVerifierCache>();
+    if (auto error = cache->read(config.cache)) {
+      diag.report(diag::err_cannot_read_file)
+          << config.cache << toString(std::move(error));
+      return false;
+    }
+    caches[config.cache] = std::move(cache);
+  }
+  auto getCache = [&](const APIComparsionConfiguration &config) {
+    return config.cache.empty() ? nullptr : caches[config.cache].get();
+  };
+
+  // Generate a module cache for all configurations if one was not provided.
+  std::string moduleCachePath = opts.frontendOptions.moduleCachePath;
+  bool customModuleCache = false;
+  if (opts.frontendOptions.enableModules && moduleCachePath.empty()) {
+    SmallString<PATH_MAX> tempPath;
+    sys::path::system_temp_directory(/*erasedOnReboot=*/true, tempPath);
+    if (auto ec = sys::fs::createUniqueDirectory(tempPath, tempPath)) {
+      diag.report(clang::diag::err_unable_to_make_temp) << ec.message();
+      return false;
+    }
+    moduleCachePath =
+        std::string(tempPath) + "/org.llvm.clang.tapi/ModuleCache";
+    customModuleCache = true;
+  }
+
+  bool success = true;
+  if (configs.size() == 1 || opts.frontendOptions.verbose) {
+    // The verbose output of clang, like the header search list, and the header
+    // dump go straight to the standard streams, so verify the configurations
+    // one by one with -v.
+    for (const auto &config : configs)
+      success &= verifyConfiguration(config, opts, moduleCachePath,
+                                     getCache(config), diag, errs());
+  } else {
+    std::vector<std::string> outputs(configs.size());
+    std::vector<char> succeeded(configs.size());
+    parallelFor(0, configs.size(), [&](size_t i) {
+      raw_string_ostream os(outputs[i]);
+      DiagnosticsEngine taskDiag(os);
+      succeeded[i] = verifyConfiguration(configs[i], opts, moduleCachePath,
+                                         getCache(configs[i]), taskDiag, os);
+      os.flush();
+    });
+
+    for (size_t i = 0, e = configs.size(); i != e; ++i) {
+      errs() << outputs[i];
+      success &= succeeded[i];
+    }
+  }
+
+  if (customModuleCache)
+    sys::fs::remove_directories(moduleCachePath, /*IgnoreErrors=*/true);
+
+  for (const auto &entry : caches) {
+    if (auto error = entry.getValue()->write(entry.getKey())) {
+      diag.report(diag::err_cannot_write_file)
+          << entry.getKey() << toString(std::move(error));
+      return false;
+    }
+  }
+
+  return success;
 }
 
 TAPI_NAMESPACE_INTERNAL_END
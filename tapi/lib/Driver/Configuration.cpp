@@ -117,9 +117,11 @@ void Configuration::setConfiguration(ConfigurationFile &&configFile,
                                      Context &context) {
   file = std::move(configFile);
   pathToConfig.clear();
+  publicDylibNames.clear();
+  publicDylibGlobs = GlobSet();
 
   for (auto &conf : file.frameworkConfigurations) {
-    pathToConfig.emplace(conf.path, &conf);
+    pathToConfig.try_emplace(conf.path, &conf);
     conf.frameworkPaths.insert(conf.frameworkPaths.end(),
                                file.frameworkPaths.begin(),
                                file.frameworkPaths.end());
@@ -128,6 +130,13 @@ void Configuration::setConfiguration(ConfigurationFile &&configFile,
                        file.macros.end());
   }
 
+  // Compile the public dylib globs once, instead of for every query.
+  for (const auto &name : file.publicDylibs) {
+    publicDylibNames.insert(name);
+    if (auto err = publicDylibGlobs.add(name))
+      consumeError(std::move(err));
+  }
+
   // Get the project name from environment.
   if (projectName.empty())
     return;
@@ -163,6 +172,14 @@ void Configuration::setConfiguration(ConfigurationFile &&configFile,
   }
 }
 
+const configuration::v1::FrameworkConfiguration *
+Configuration::findFrameworkConfig(StringRef path) const {
+  auto it = pathToConfig.find(path);
+  if (it == pathToConfig.end())
+    return nullptr;
+  return it->second;
+}
+
 std::string Configuration::getSysRoot() const {
   return !commandLine.isysroot.empty() ? commandLine.isysroot : file.isysroot;
 }
@@ -171,9 +188,8 @@ clang::Language Configuration::getLanguage(StringRef path) const {
   if (commandLine.language != clang::Language::Unknown)
     return commandLine.language;
 
-  auto it = pathToConfig.find(path.str());
-  if (it != pathToConfig.end())
-    return it->second->language;
+  if (const auto *conf = findFrameworkConfig(path))
+    return conf->language;
 
   if (projectConfig)
     return projectConfig->language;
@@ -205,9 +221,8 @@ std::vector<Macro> Configuration::getMacros(StringRef path) const {
   if (!commandLine.macros.empty())
     insertElements(macros, commandLine.macros);
 
-  auto it = pathToConfig.find(path.str());
-  if (it != pathToConfig.end())
-    insertElements(macros, it->second->macros);
+  if (const auto *conf = findFrameworkConfig(path))
+    insertElements(macros, conf->macros);
 
   if (projectConfig)
     insertElements(macros, projectConfig->macros);
@@ -227,9 +242,8 @@ PathSeq Configuration::getIncludePaths(StringRef path) const {
     insertElements(includePaths, projectIncludes);
   }
 
-  auto it = pathToConfig.find(path.str());
-  if (it != pathToConfig.end()) {
-    auto frameworkIncludes = updateDirectories(path, it->second->includePaths);
+  if (const auto *conf = findFrameworkConfig(path)) {
+    auto frameworkIncludes = updateDirectories(path, conf->includePaths);
     insertElements(includePaths, frameworkIncludes);
   }
 
@@ -250,10 +264,8 @@ PathSeq Configuration::getFrameworkPaths(StringRef path) const {
     insertElements(frameworkPaths, projectFrameworks);
   }
 
-  auto it = pathToConfig.find(path.str());
-  if (it != pathToConfig.end()) {
-    auto frameworkFrameworks =
-        updateDirectories(path, it->second->frameworkPaths);
+  if (const auto *conf = findFrameworkConfig(path)) {
+    auto frameworkFrameworks = updateDirectories(path, conf->frameworkPaths);
     insertElements(frameworkPaths, frameworkFrameworks);
   }
 
@@ -282,14 +294,14 @@ PathSeq Configuration::getExtraHeaders(StringRef path, HeaderType type) const {
           projectConfig->privateHeaderConfiguration.includes);
   }
 
-  auto it = pathToConfig.find(path.str());
-  if (it == pathToConfig.end())
+  const auto *conf = findFrameworkConfig(path);
+  if (!conf)
     return {};
 
   if (type == HeaderType::Public)
-    return updateSDKHeaderFiles(it->second->publicHeaderConfiguration.includes);
+    return updateSDKHeaderFiles(conf->publicHeaderConfiguration.includes);
 
-  return updateSDKHeaderFiles(it->second->privateHeaderConfiguration.includes);
+  return updateSDKHeaderFiles(conf->privateHeaderConfiguration.includes);
 }
 
 PathSeq Configuration::getPreIncludedHeaders(StringRef path,
@@ -304,14 +316,11 @@ PathSeq Configuration::getPreIncludedHeaders(StringRef path,
                      projectConfig->privateHeaderConfiguration.preIncludes);
   }
 
-  auto it = pathToConfig.find(path.str());
-  if (it != pathToConfig.end()) {
+  if (const auto *conf = findFrameworkConfig(path)) {
     if (type == HeaderType::Public)
-      insertElements(headers,
-                     it->second->publicHeaderConfiguration.preIncludes);
+      insertElements(headers, conf->publicHeaderConfiguration.preIncludes);
     else
-      insertElements(headers,
-                     it->second->privateHeaderConfiguration.preIncludes);
+      insertElements(headers, conf->privateHeaderConfiguration.preIncludes);
   }
   return headers;
 }
@@ -335,14 +344,11 @@ PathSeq Configuration::getExcludedHeaders(StringRef path,
                      projectConfig->privateHeaderConfiguration.excludes);
   }
 
-  auto it = pathToConfig.find(path.str());
-  if (it != pathToConfig.end()) {
+  if (const auto *conf = findFrameworkConfig(path)) {
     if (type == HeaderType::Public)
-      insertElements(excludePaths,
-                     it->second->publicHeaderConfiguration.excludes);
+      insertElements(excludePaths, conf->publicHeaderConfiguration.excludes);
     else
-      insertElements(excludePaths,
-                     it->second->privateHeaderConfiguration.excludes);
+      insertElements(excludePaths, conf->privateHeaderConfiguration.excludes);
   }
 
   return excludePaths;
@@ -366,14 +372,14 @@ std::string Configuration::getUmbrellaHeader(StringRef path,
     return projectConfig->privateHeaderConfiguration.umbrellaHeader;
   }
 
-  auto it = pathToConfig.find(path.str());
-  if (it == pathToConfig.end())
+  const auto *conf = findFrameworkConfig(path);
+  if (!conf)
     return {};
 
   if (type == HeaderType::Public)
-    return it->second->publicHeaderConfiguration.umbrellaHeader;
+    return conf->publicHeaderConfiguration.umbrellaHeader;
 
-  return it->second->privateHeaderConfiguration.umbrellaHeader;
+  return conf->privateHeaderConfiguration.umbrellaHeader;
 }
 
 bool Configuration::isiOSMacProject() const {
@@ -384,9 +390,8 @@ bool Configuration::isZipperedProject() const {
 }
 
 bool Configuration::useOverlay(StringRef path) const {
-  auto it = pathToConfig.find(path.str());
-  if (it != pathToConfig.end())
-    return it->second->useOverlay;
+  if (const auto *conf = findFrameworkConfig(path))
+    return conf->useOverlay;
 
   if (projectConfig)
     return projectConfig->useOverlay;
@@ -420,26 +425,19 @@ PathSeq Configuration::getSDKMaskPaths() const {
 std::vector<std::string>
 Configuration::getClangExtraArgs(StringRef path) const {
   std::vector<std::string> clangExtraArgs = commandLine.clangExtraArgs;
-  auto it = pathToConfig.find(path.str());
-  if (it != pathToConfig.end())
-    llvm::append_range(clangExtraArgs, it->second->clangExtraArgs);
+  if (const auto *conf = findFrameworkConfig(path))
+    llvm::append_range(clangExtraArgs, conf->clangExtraArgs);
   if (projectConfig)
     llvm::append_range(clangExtraArgs, projectConfig->clangExtraArgs);
   return clangExtraArgs;
 }
 
 bool Configuration::isPromotedToPublicDylib(StringRef installName) const {
-  auto result = llvm::find_if(file.publicDylibs, [&](StringRef glob) {
-    if (installName == glob)
-      return true;
-    auto regex = createRegexFromGlob(glob);
-    if (!regex) {
-      consumeError(regex.takeError());
-      return false;
-    }
-    return regex->match(installName);
-  });
-  return result != file.publicDylibs.end();
+  if (publicDylibNames.count(installName))
+    return true;
+  SmallVector<unsigned, 1> matches;
+  publicDylibGlobs.match(installName, matches);
+  return !matches.empty();
 }
 
 TAPI_NAMESPACE_INTERNAL_END
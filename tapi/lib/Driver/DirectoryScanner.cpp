@@ -14,12 +14,15 @@
 //===----------------------------------------------------------------------===//
 
 #include "tapi/Driver/DirectoryScanner.h"
+#include "ScanCache.h"
 #include "tapi/Core/FileManager.h"
 #include "tapi/Core/Framework.h"
 #include "tapi/Core/HeaderFile.h"
 #include "tapi/Core/Utils.h"
 #include "tapi/Diagnostics/Diagnostics.h"
 #include "clang/Basic/Diagnostic.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/VirtualFileSystem.h"
@@ -79,6 +82,93 @@ Framework &DirectoryScanner::getOrCreateFramework(
   return frameworks.back();
 }
 
+/// \brief List the entries of \p directory, or reuse the listing from the scan
+/// cache if the directory didn't change. Entries that were listed but don't
+/// exist are dropped if \p skipMissing is set, and are an error otherwise.
+bool DirectoryScanner::readDirectory(StringRef directory,
+                                     std::vector<ScanDirectoryEntry> &entries,
+                                     bool skipMissing) const {
+  auto &fs = _fm.getVirtualFileSystem();
+  Optional<FileIdentity> identity;
+  const std::vector<ScanDirectoryEntry> *cached = nullptr;
+  if (cache) {
+    identity = FileIdentity::get(fs, directory);
+    if (identity)
+      cached = cache->findDirectory(directory, *identity);
+  }
+
+  std::vector<ScanDirectoryEntry> listing;
+  if (!cached) {
+    std::error_code ec;
+    for (vfs::directory_iterator i = fs.dir_begin(directory, ec), ie; i != ie;
+         i.increment(ec)) {
+      auto path = i->path();
+      ScanDirectoryEntry entry;
+      entry.path = path.str();
+
+      // This usually happens for broken symlinks.
+      if (ec == std::errc::no_such_file_or_directory) {
+        ec.clear();
+        entry.isMissing = true;
+      } else if (ec) {
+        diag.report(diag::err) << path << ec.message();
+        return false;
+      }
+
+      // Only cached listings record the file system flags up front.
+      if (identity) {
+        entry.isSymlink = !entry.isMissing && _fm.isSymlink(path);
+        entry.isDirectory = !entry.isMissing &&
+                            _fm.isDirectory(path, /*CacheFailure=*/false);
+        entry.exists = !entry.isMissing &&
+                       (*entry.isDirectory ||
+                        fs.status(path).getError() !=
+                            std::errc::no_such_file_or_directory);
+      }
+      listing.push_back(std::move(entry));
+    }
+
+    // Don't cache directories that couldn't be opened.
+    if (identity && !ec)
+      cache->addDirectory(directory, *identity, listing);
+    cached = &listing;
+  }
+
+  for (const auto &entry : *cached) {
+    if (entry.isMissing) {
+      if (skipMissing)
+        continue;
+      diag.report(diag::err)
+          << entry.path
+          << std::make_error_code(std::errc::no_such_file_or_directory)
+                 .message();
+      return false;
+    }
+    entries.push_back(entry);
+  }
+
+  return true;
+}
+
+bool DirectoryScanner::isSymlink(const ScanDirectoryEntry &entry) const {
+  if (entry.isSymlink)
+    return *entry.isSymlink;
+  return _fm.isSymlink(entry.path);
+}
+
+bool DirectoryScanner::isDirectory(const ScanDirectoryEntry &entry) const {
+  if (entry.isDirectory)
+    return *entry.isDirectory;
+  return _fm.isDirectory(entry.path, /*CacheFailure=*/false);
+}
+
+bool DirectoryScanner::exists(const ScanDirectoryEntry &entry) const {
+  if (entry.exists)
+    return *entry.exists;
+  return _fm.getVirtualFileSystem().status(entry.path).getError() !=
+         std::errc::no_such_file_or_directory;
+}
+
 bool DirectoryScanner::scanDylibDirectory(
     StringRef directory, std::vector<Framework> &frameworks) const {
 
@@ -144,45 +234,26 @@ bool DirectoryScanner::scanDirectory(StringRef directory) {
 /// \brief Scan the directory for frameworks.
 bool DirectoryScanner::scanFrameworksDirectory(
     std::vector<Framework> &frameworks, StringRef directory) const {
-  std::error_code ec;
-  auto &fs = _fm.getVirtualFileSystem();
-  for (vfs::directory_iterator i = fs.dir_begin(directory, ec), ie; i != ie;
-       i.increment(ec)) {
-    auto path = i->path();
-
-    // Skip files that not exist. This usually happens for broken symlinks.
-    if (ec == std::errc::no_such_file_or_directory) {
-      ec.clear();
-      continue;
-    }
-
-    if (ec) {
-      diag.report(diag::err) << path << ec.message();
-      return false;
-    }
+  std::vector<ScanDirectoryEntry> entries;
+  if (!readDirectory(directory, entries, /*skipMissing=*/true))
+    return false;
 
-    if (_fm.isSymlink(path))
+  for (const auto &entry : entries) {
+    StringRef path = entry.path;
+    if (isSymlink(entry))
       continue;
 
     if (isFramework(path)) {
-      if (!_fm.isDirectory(path, /*CacheFailure=*/false))
+      if (!isDirectory(entry))
         continue;
 
       auto &framework = getOrCreateFramework(path, frameworks);
       if (!scanFrameworkDirectory(framework, path))
         return false;
-    } else if (mode.scanBinaries() &&
-               !_fm.isDirectory(path, /*CacheFailure*/ false)) {
+    } else if (mode.scanBinaries() && !isDirectory(entry)) {
       // Check for dynamic libs.
-      auto result = isDynamicLibrary(path);
-      if (!result) {
-        diag.report(diag::err) << path << toString(result.takeError());
-        return false;
-      }
-
       auto &framework = getOrCreateFramework(path, frameworks);
-      if (result.get())
-        framework.addDynamicLibraryFile(path);
+      addBinary(framework, path);
     }
   }
 
@@ -203,30 +274,18 @@ bool DirectoryScanner::scanFrameworkDirectory(Framework &framework,
   // Unfortunately we cannot identify symlinks in the VFS. We assume that if
   // there is a Versions directory, then we have symlinks and directly proceed
   // to the Versiosn folder.
-  std::error_code ec;
-  auto &fs = _fm.getVirtualFileSystem();
+  std::vector<ScanDirectoryEntry> entries;
+  if (!readDirectory(path, entries, /*skipMissing=*/true))
+    return false;
 
   // If the framework is inside Kernel or IOKit, scan headers in the different
   // directory separately.
   framework.isDynamicLibrary =
       path.contains("Kernel.framework") || path.contains("IOKit.framework");
 
-  for (vfs::directory_iterator i = fs.dir_begin(path, ec), ie;
-       i != ie; i.increment(ec)) {
-    auto path = i->path();
-
-    // Skip files that not exist. This usually happens for broken symlinks.
-    if (ec == std::errc::no_such_file_or_directory) {
-      ec.clear();
-      continue;
-    }
-
-    if (ec) {
-      diag.report(diag::err) << path << ec.message();
-      return false;
-    }
-
-    if (_fm.isSymlink(path))
+  for (const auto &entry : entries) {
+    StringRef path = entry.path;
+    if (isSymlink(entry))
       continue;
 
     StringRef fileName = sys::path::filename(path);
@@ -262,7 +321,7 @@ bool DirectoryScanner::scanFrameworkDirectory(Framework &framework,
     }
 
     // If it is a directory, scan the directory to check for dynamic libs.
-    if (_fm.isDirectory(path, /*CacheFailure=*/false)) {
+    if (isDirectory(entry)) {
       if (!scanLibraryDirectory(framework, path))
         return false;
       continue;
@@ -272,14 +331,7 @@ bool DirectoryScanner::scanFrameworkDirectory(Framework &framework,
       continue;
 
     // Check for dynamic libs.
-    auto result = isDynamicLibrary(path);
-    if (!result) {
-      diag.report(diag::err) << path << toString(result.takeError());
-      return false;
-    }
-
-    if (result.get())
-      framework.addDynamicLibraryFile(path);
+    addBinary(framework, path);
   }
 
   return true;
@@ -294,34 +346,31 @@ bool DirectoryScanner::scanHeaders(Framework &framework, StringRef path,
   if (!mode.scanPrivateHeaders() && type == HeaderType::Private)
     return true;
 
-  std::error_code ec;
-  auto &fs = _fm.getVirtualFileSystem();
+  std::vector<ScanDirectoryEntry> entries;
+  if (!readDirectory(path, entries, /*skipMissing=*/true))
+    return false;
+
   std::vector<std::string> subDirectories;
-  for (vfs::directory_iterator i = fs.dir_begin(path, ec), ie; i != ie;
-       i.increment(ec)) {
-    auto headerPath = i->path();
-    if (ec) {
-      diag.report(diag::err) << headerPath << ec.message();
-      return false;
-    }
+  for (const auto &entry : entries) {
+    StringRef headerPath = entry.path;
 
     // Ignore tmp files from unifdef.
     auto filename = sys::path::filename(headerPath);
     if (filename.startswith("."))
       continue;
 
-    if (_fm.isSymlink(headerPath))
+    if (isSymlink(entry))
       continue;
 
     // If it is a directory, remember the subdirectory.
-    if (_fm.isDirectory(headerPath, /*CacheFailure=*/false))
-      subDirectories.push_back(headerPath.str());
+    if (isDirectory(entry))
+      subDirectories.push_back(entry.path);
 
     if (!isHeaderFile(headerPath))
       continue;
 
     // Skip files that not exist. This usually happens for broken symlinks.
-    if (fs.status(headerPath) == std::errc::no_such_file_or_directory)
+    if (!exists(entry))
       continue;
 
     auto relativePath =
@@ -353,18 +402,15 @@ bool DirectoryScanner::scanHeaders(Framework &framework, StringRef path,
 
 bool DirectoryScanner::scanModules(Framework &framework,
                                    StringRef _path) const {
-  std::error_code ec;
-  auto &fs = _fm.getVirtualFileSystem();
-  for (vfs::directory_iterator i = fs.dir_begin(_path, ec), ie; i != ie;
-       i.increment(ec)) {
-    auto path = i->path();
-    if (ec) {
-      diag.report(diag::err) << path << ec.message();
-      return false;
-    }
+  std::vector<ScanDirectoryEntry> entries;
+  if (!readDirectory(_path, entries, /*skipMissing=*/false))
+    return false;
+
+  for (const auto &entry : entries) {
+    StringRef path = entry.path;
 
     // Skip files that not exist. This usually happens for broken symlinks.
-    if (fs.status(path) == std::errc::no_such_file_or_directory)
+    if (!exists(entry))
       continue;
 
     if (path.endswith(".swiftinterface")) {
@@ -409,28 +455,17 @@ bool DirectoryScanner::scanSwiftModules(Framework &framework,
 /// frameworks.
 bool DirectoryScanner::scanFrameworkVersionsDirectory(Framework &framework,
                                                       StringRef path) const {
-  std::error_code ec;
-  auto &fs = _fm.getVirtualFileSystem();
-  for (vfs::directory_iterator i = fs.dir_begin(path, ec), ie; i != ie;
-       i.increment(ec)) {
-    auto path = i->path();
-
-    // Skip files that not exist. This usually happens for broken symlinks.
-    if (ec == std::errc::no_such_file_or_directory) {
-      ec.clear();
-      continue;
-    }
-
-    if (ec) {
-      diag.report(diag::err) << path << ec.message();
-      return false;
-    }
+  std::vector<ScanDirectoryEntry> entries;
+  if (!readDirectory(path, entries, /*skipMissing=*/true))
+    return false;
 
-    if (_fm.isSymlink(path))
+  for (const auto &entry : entries) {
+    StringRef path = entry.path;
+    if (isSymlink(entry))
       continue;
 
     // Each version is just a framework directory.
-    if (!_fm.isDirectory(path, /*CacheFailure=*/false))
+    if (!isDirectory(entry))
       continue;
 
     auto &version = getOrCreateFramework(path, framework._versions);
@@ -443,27 +478,16 @@ bool DirectoryScanner::scanFrameworkVersionsDirectory(Framework &framework,
 
 bool DirectoryScanner::scanLibraryDirectory(Framework &framework,
                                             StringRef path) const {
-  std::error_code ec;
-  auto &fs = _fm.getVirtualFileSystem();
-  for (vfs::directory_iterator i = fs.dir_begin(path, ec), ie; i != ie;
-       i.increment(ec)) {
-    auto path = i->path();
-
-    // Skip files that not exist. This usually happens for broken symlinks.
-    if (ec == std::errc::no_such_file_or_directory) {
-      ec.clear();
-      continue;
-    }
-
-    if (ec) {
-      diag.report(diag::err) << path << ec.message();
-      return false;
-    }
+  std::vector<ScanDirectoryEntry> entries;
+  if (!readDirectory(path, entries, /*skipMissing=*/true))
+    return false;
 
-    if (_fm.isSymlink(path))
+  for (const auto &entry : entries) {
+    StringRef path = entry.path;
+    if (isSymlink(entry))
       continue;
 
-    if (_fm.isDirectory(path, /*CacheFailure=*/false)) {
+    if (isDirectory(entry)) {
       scanLibraryDirectory(framework, path);
       continue;
     }
@@ -472,46 +496,130 @@ bool DirectoryScanner::scanLibraryDirectory(Framework &framework,
       continue;
 
     // Check for dynamic libs.
-    auto result = isDynamicLibrary(path);
-    if (!result) {
-      diag.report(diag::err) << path << toString(result.takeError());
-      return false;
-    }
-
-    if (result.get())
-      framework.addDynamicLibraryFile(path);
+    addBinary(framework, path);
   }
 
   return true;
 }
 
-Expected<bool> DirectoryScanner::isDynamicLibrary(StringRef path) const {
-  auto bufferOrErr = _fm.getBufferForFile(path);
-  if (auto ec = bufferOrErr.getError()) {
-    if (ec == std::errc::permission_denied) {
-      diag.report(diag::warn_sdkdb_skip_file) << path << ec.message();
-      return false;
-    }
-    return errorCodeToError(ec);
-  }
+namespace {
+struct BinaryIdentification {
+  ScanBinaryKind kind = ScanBinaryKind::Other;
+  Optional<FileIdentity> identity;
+  std::error_code skipped;
+  std::string error;
+};
+} // end anonymous namespace
+
+static BinaryIdentification identifyBinary(vfs::FileSystem &fs,
+                                           const Registry &registry,
+                                           const ScanCache *cache,
+                                           StringRef path) {
+  BinaryIdentification result;
 
   // Metal Libraries pretend to be MachOs, but they do not contain any
   // framework code that developers can use, so we will just skip them.
   if (path.endswith(".metallib"))
-    return false;
+    return result;
+
+  if (cache) {
+    result.identity = FileIdentity::get(fs, path);
+    if (result.identity) {
+      if (auto kind = cache->findBinary(path, *result.identity)) {
+        result.kind = *kind;
+        return result;
+      }
+    }
+  }
 
-  auto fileType = _registry.getFileType(*bufferOrErr.get());
-  if (!fileType)
-    return fileType;
+  auto bufferOrErr =
+      fs.getBufferForFile(path, /*FileSize=*/-1,
+                          /*RequiresNullTerminator=*/false);
+  if (auto ec = bufferOrErr.getError()) {
+    if (ec == std::errc::permission_denied)
+      result.skipped = ec;
+    else
+      result.error = ec.message();
+    return result;
+  }
+
+  auto fileType = registry.getFileType(*bufferOrErr.get());
+  if (!fileType) {
+    result.error = toString(fileType.takeError());
+    return result;
+  }
 
   if (fileType.get() == FileType::MachO_DynamicLibrary ||
       fileType.get() == FileType::MachO_DynamicLibrary_Stub)
-    return true;
+    result.kind = ScanBinaryKind::DynamicLibrary;
+  else if (fileType.get() == FileType::MachO_Bundle)
+    result.kind = ScanBinaryKind::Bundle;
+  return result;
+}
+
+static void removeDynamicLibraryFiles(std::vector<Framework> &frameworks,
+                                      const StringSet<> &paths) {
+  for (auto &framework : frameworks) {
+    llvm::erase_if(framework._dynamicLibraryFiles,
+                   [&](const std::string &path) { return paths.count(path); });
+    removeDynamicLibraryFiles(framework._subFrameworks, paths);
+    removeDynamicLibraryFiles(framework._versions, paths);
+  }
+}
+
+void DirectoryScanner::addBinary(Framework &framework, StringRef path) const {
+  // Assume the file is a dynamic library for now, the ones that aren't are
+  // removed by identifyBinaries.
+  framework.addDynamicLibraryFile(path);
+  binaries.emplace_back(path);
+}
 
-  if (mode.scanBundles() && (fileType.get() == FileType::MachO_Bundle))
+/// \brief Open and identify all binaries found by the walk in parallel, then
+/// drop the ones that are not dynamic libraries from their frameworks. The
+/// framework order and the diagnostics are the same as for a serial scan.
+bool DirectoryScanner::identifyBinaries() {
+  auto paths = std::move(binaries);
+  binaries.clear();
+  if (paths.empty())
     return true;
 
-  return false;
+  // The FileManager is not thread-safe, read the binaries directly through
+  // the file system it wraps.
+  auto &fs = _fm.getVirtualFileSystem();
+  std::vector<BinaryIdentification> results(paths.size());
+  parallelFor(0, paths.size(), [&](size_t i) {
+    SmallString<PATH_MAX> path(paths[i]);
+    _fm.FixupRelativePath(path);
+    results[i] = identifyBinary(fs, _registry, cache, path);
+  });
+
+  StringSet<> notDynamicLibraries;
+  for (size_t i = 0, e = paths.size(); i != e; ++i) {
+    const auto &result = results[i];
+    if (!result.error.empty()) {
+      diag.report(diag::err) << paths[i] << result.error;
+      return false;
+    }
+    if (result.skipped) {
+      diag.report(diag::warn_sdkdb_skip_file)
+          << paths[i] << result.skipped.message();
+      notDynamicLibraries.insert(paths[i]);
+      continue;
+    }
+
+    if (cache && result.identity) {
+      SmallString<PATH_MAX> path(paths[i]);
+      _fm.FixupRelativePath(path);
+      cache->addBinary(path, *result.identity, result.kind);
+    }
+
+    if (result.kind != ScanBinaryKind::DynamicLibrary &&
+        !(mode.scanBundles() && result.kind == ScanBinaryKind::Bundle))
+      notDynamicLibraries.insert(paths[i]);
+  }
+
+  removeDynamicLibraryFiles(frameworks, notDynamicLibraries);
+  return true;
 }
 
 bool DirectoryScanner::scanSDKContent(StringRef directory) {
@@ -586,29 +694,20 @@ bool DirectoryScanner::scanSDKContent(StringRef directory) {
     return false;
 
   // Scan the bundles and extensions in /System/Library.
-  std::error_code ec;
-  auto &fs = _fm.getVirtualFileSystem();
-  for (auto i = fs.dir_begin(getDirectory("System/Library", rootPath), ec);
-       i != vfs::directory_iterator(); i.increment(ec)) {
-    auto path = i->path();
-
-    // Skip files that not exist. This usually happens for broken symlinks.
-    if (ec == std::errc::no_such_file_or_directory) {
-      ec.clear();
-      continue;
-    }
+  std::vector<ScanDirectoryEntry> entries;
+  if (!readDirectory(getDirectory("System/Library", rootPath), entries,
+                     /*skipMissing=*/true))
+    return false;
 
-    if (ec) {
-      diag.report(diag::err) << path << ec.message();
-      return false;
-    }
+  for (const auto &entry : entries) {
+    StringRef path = entry.path;
 
     // Skip framework directories that is handled above.
     if (path.endswith("Frameworks") || path.endswith("PrivateFrameworks"))
       continue;
 
     // Skip all that is not a directory.
-    if (_fm.isDirectory(path, /*CacheFailure=*/false)) {
+    if (isDirectory(entry)) {
       auto &sub = getOrCreateFramework(path, SDKFramework._subFrameworks);
       if (!scanLibraryDirectory(sub, path))
         return false;
@@ -619,13 +718,20 @@ bool DirectoryScanner::scanSDKContent(StringRef directory) {
 }
 
 bool DirectoryScanner::scan(StringRef directory) {
+  bool success;
   if (mode.getMode() == ScannerMode::ScanFrameworks)
-    return scanDirectory(directory);
-
-  if (mode.getMode() == ScannerMode::ScanDylibs)
-    return scanDylibDirectory(directory, frameworks);
+    success = scanDirectory(directory);
+  else if (mode.getMode() == ScannerMode::ScanDylibs)
+    success = scanDylibDirectory(directory, frameworks);
+  else
+    success = scanSDKContent(directory);
+
+  if (!success) {
+    binaries.clear();
+    return false;
+  }
 
-  return scanSDKContent(directory);
+  return identifyBinaries();
 }
 
 static std::string removeVersionsFromPath(StringRef path) {
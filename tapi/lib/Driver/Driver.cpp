@@ -15,6 +15,7 @@
 
 #include "tapi/Driver/Driver.h"
 #include "tapi/Config/Version.h"
+#include "tapi/Core/InterfaceFileManager.h"
 #include "tapi/Core/LLVM.h"
 #include "tapi/Driver/Options.h"
 #include "llvm/ADT/ArrayRef.h"
@@ -36,11 +37,16 @@ bool Driver::run(DiagnosticsEngine &diag, Options &options) {
     return true;
   }
 
+  // Handle --serve.
+  if (options.driverOptions.serve)
+    return Serve::run(diag, options);
+
   return true;
 }
 
 /// Parses the command line options and performs the requested action.
-bool Driver::run(ArrayRef<const char *> args) {
+bool Driver::run(ArrayRef<const char *> args,
+                 InterfaceFileManager *interfaceMgr) {
   auto diag = createDiagnosticsEngine();
   // Parse command line options using TAPIOptions.td.
 
@@ -55,6 +61,12 @@ bool Driver::run(ArrayRef<const char *> args) {
     return true;
   }
 
+  if (interfaceMgr) {
+    interfaceMgr->setFileManager(options.getFileManager(),
+                                 options.tapiOptions.isBnI);
+    options.interfaceMgr = interfaceMgr;
+  }
+
   switch (options.command) {
   case TAPICommand::Driver:
     return Driver::run(*diag, options);
@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include <tapi/Driver/Glob.h>
+#include "llvm/ADT/STLExtras.h"
 
 using namespace llvm;
 
@@ -42,9 +43,13 @@ Expected<Regex> createRegexFromGlob(StringRef globString) {
       if ((numWildcards > 1) &&
           (previousChar == nullptr || *previousChar == '/') &&
           (nextChar == nullptr || *nextChar == '/')) {
+        // The expression already matches the path separator that follows.
         regexString += "(([^/]*(/|$))*)";
-      } else
+      } else {
         regexString += "([^/]*)";
+        // Don't skip the character after the wildcards.
+        --i;
+      }
       break;
     }
     default:
@@ -65,4 +70,114 @@ Expected<Regex> createRegexFromGlob(StringRef globString) {
   return regex;
 }
 
+Error GlobSet::add(StringRef glob) {
+  std::vector<Token> globTokens;
+  bool hasWildcard = false;
+  for (size_t i = 0; i < glob.size(); ++i) {
+    char c = glob[i];
+    if (c == '?') {
+      globTokens.push_back({TokenKind::AnyChar, c, 0});
+      continue;
+    }
+    if (c != '*') {
+      globTokens.push_back({TokenKind::Literal, c, 0});
+      continue;
+    }
+
+    hasWildcard = true;
+    size_t begin = i;
+    while (i + 1 < glob.size() && glob[i + 1] == '*')
+      ++i;
+    bool atComponentStart = begin == 0 || glob[begin - 1] == '/';
+    bool atComponentEnd = i + 1 == glob.size() || glob[i + 1] == '/';
+    if (i > begin && atComponentStart && atComponentEnd) {
+      globTokens.push_back({TokenKind::GlobStar, c, 0});
+      // The globstar also matches the path separator that follows.
+      if (i + 1 < glob.size())
+        ++i;
+    } else
+      globTokens.push_back({TokenKind::Star, c, 0});
+  }
+  if (!hasWildcard)
+    return make_error<StringError>("not a glob", inconvertibleErrorCode());
+
+  starts.push_back(tokens.size());
+  tokens.insert(tokens.end(), globTokens.begin(), globTokens.end());
+  tokens.push_back({TokenKind::Accept, 0, (unsigned)globs.size()});
+  globs.emplace_back(glob.str());
+  return Error::success();
+}
+
+void GlobSet::match(StringRef path, SmallVectorImpl<unsigned> &matches) const {
+  // The set of active states is kept duplicate free by marking every state
+  // with the last step that added it.
+  std::vector<unsigned> marks(2 * tokens.size(), ~0U);
+  SmallVector<unsigned, 64> current;
+  SmallVector<unsigned, 64> next;
+  unsigned step = 0;
+
+  // Add a state and everything reachable from it without consuming input.
+  auto addState = [&](SmallVectorImpl<unsigned> &states, unsigned state) {
+    while (marks[state] != step) {
+      marks[state] = step;
+      states.push_back(state);
+      if (state & 1)
+        return;
+      auto kind = tokens[state / 2].kind;
+      if (kind != TokenKind::Star && kind != TokenKind::GlobStar)
+        return;
+      state += 2;
+    }
+  };
+
+  for (auto start : starts)
+    addState(current, 2 * start);
+
+  for (char c : path) {
+    ++step;
+    next.clear();
+    for (auto state : current) {
+      unsigned index = state / 2;
+      const auto &token = tokens[index];
+      switch (token.kind) {
+      case TokenKind::Literal:
+        if (c == token.c)
+          addState(next, 2 * index + 2);
+        break;
+      case TokenKind::AnyChar:
+        addState(next, 2 * index + 2);
+        break;
+      case TokenKind::Star:
+        if (c != '/')
+          addState(next, 2 * index);
+        break;
+      case TokenKind::GlobStar:
+        addState(next, c == '/' ? 2 * index : 2 * index + 1);
+        break;
+      case TokenKind::Accept:
+        break;
+      }
+    }
+    std::swap(current, next);
+    if (current.empty())
+      return;
+  }
+
+  // A globstar can also end in the middle of the last path component.
+  ++step;
+  for (auto state : current)
+    marks[state] = step;
+  for (size_t i = 0, e = current.size(); i != e; ++i)
+    if (current[i] & 1)
+      addState(current, current[i] + 1);
+
+  size_t firstMatch = matches.size();
+  for (auto state : current) {
+    const auto &token = tokens[state / 2];
+    if (!(state & 1) && token.kind == TokenKind::Accept)
+      matches.push_back(token.glob);
+  }
+  llvm::sort(matches.begin() + firstMatch, matches.end());
+}
+
 TAPI_NAMESPACE_INTERNAL_END
@@ -40,4 +40,35 @@ Expected<std::unique_ptr<HeaderGlob>> HeaderGlob::create(StringRef globString,
   return std::make_unique<HeaderGlob>(globString, std::move(*regex), type);
 }
 
+Error HeaderGlobSet::add(StringRef globString, HeaderType type) {
+  auto &globSet = globSets[type];
+  if (auto err = globSet.add(globString))
+    return err;
+
+  globIndices[type].push_back(globs.size());
+  globs.push_back({type, (unsigned)globSet.size() - 1, false});
+  return Error::success();
+}
+
+bool HeaderGlobSet::match(const HeaderFile &header) {
+  auto it = globSets.find(header.type);
+  if (it == globSets.end())
+    return false;
+
+  SmallVector<unsigned, 4> matches;
+  it->second.match(header.fullPath, matches);
+  const auto &indices = globIndices[header.type];
+  for (auto index : matches)
+    globs[indices[index]].foundMatch = true;
+  return !matches.empty();
+}
+
+std::vector<StringRef> HeaderGlobSet::getUnmatchedGlobs() const {
+  std::vector<StringRef> unmatched;
+  for (const auto &glob : globs)
+    if (!glob.foundMatch)
+      unmatched.push_back(globSets.at(glob.type).str(glob.index));
+  return unmatched;
+}
+
 TAPI_NAMESPACE_INTERNAL_END
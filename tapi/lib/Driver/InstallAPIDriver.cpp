@@ -13,6 +13,7 @@
 
 #include "APINormalizer.h"
 #include "FileListVisitor.h"
+#include "ScanCache.h"
 #include "tapi/APIVerifier/APIVerifier.h"
 #include "tapi/Core/APIPrinter.h"
 #include "tapi/Core/ClangDiagnostics.h"
@@ -351,9 +352,10 @@ static Expected<APIs> getCodeCoverageSymbols(DiagnosticsEngine &diag,
     if (!file)
       return file.takeError();
     assert(file->size() == 1 && "only a single target should exist at a time");
+    // The manager keeps the file, so don't move the API out of it.
     std::shared_ptr<API> api = *file->begin();
     if (api)
-      apis.emplace_back(std::move(*file->begin()));
+      apis.emplace_back(std::move(api));
   }
   return apis;
 }
@@ -497,8 +499,10 @@ bool Driver::InstallAPI::run(DiagnosticsEngine &diag, Options &opts) {
   bool autoZippered = false;
   const auto platforms = mapToPlatformSet(allTargets);
 
-  // Lookup re-exported libraries.
-  InterfaceFileManager manager(fm, opts.tapiOptions.isBnI);
+  // Lookup re-exported libraries. The serve mode provides a manager that keeps
+  // the files it read across commands.
+  InterfaceFileManager localManager(fm, opts.tapiOptions.isBnI);
+  auto &manager = opts.interfaceMgr ? *opts.interfaceMgr : localManager;
   PathSeq frameworkSearchPaths;
   LibAttrs reexportedLibraries;
   std::vector<APIs> reexportedLibraryFiles;
@@ -651,6 +655,22 @@ bool Driver::InstallAPI::run(DiagnosticsEngine &diag, Options &opts) {
                                  ? ScannerMode::ScanDylibs
                                  : ScannerMode::ScanFrameworks);
 
+    // Reuse the unchanged parts of the previous scan if requested. The scan
+    // results depend on the VFS overlays.
+    std::unique_ptr<ScanCache> scanCache;
+    if (!opts.tapiOptions.scanCachePath.empty()) {
+      std::string scanCacheKey;
+      for (const auto &path : opts.driverOptions.vfsOverlayPaths)
+        scanCacheKey += "overlay:" + path + "\n";
+      scanCache = std::make_unique<ScanCache>(scanCacheKey);
+      // Without a usable cache everything is scanned again.
+      if (auto err = scanCache->read(opts.tapiOptions.scanCachePath))
+        diag.report(diag::warn)
+            << ("ignoring scan cache '" + opts.tapiOptions.scanCachePath +
+                "': " + toString(std::move(err)));
+      scanner.setCache(scanCache.get());
+    }
+
     for (const auto &path : inputPaths) {
       if (fm.isDirectory(path, /*CacheFailure=*/false)) {
         SmallString<PATH_MAX> normalizedPath(path);
@@ -664,6 +684,14 @@ bool Driver::InstallAPI::run(DiagnosticsEngine &diag, Options &opts) {
       }
     }
 
+    if (scanCache) {
+      if (auto err = scanCache->write(opts.tapiOptions.scanCachePath)) {
+        diag.report(diag::err_cannot_write_file)
+            << opts.tapiOptions.scanCachePath << toString(std::move(err));
+        return false;
+      }
+    }
+
     auto frameworks = scanner.takeResult();
     if (frameworks.empty()) {
       diag.report(diag::err_no_framework);
@@ -792,15 +820,12 @@ bool Driver::InstallAPI::run(DiagnosticsEngine &diag, Options &opts) {
     }
   }
 
-  std::vector<std::unique_ptr<HeaderGlob>> excludeHeaderGlobs;
+  HeaderGlobSet excludeHeaderGlobs;
   std::set<const FileEntry *> excludeHeaderFiles;
   auto parseGlobs = [&](const PathSeq &paths, HeaderType type) {
     for (const auto &str : paths) {
-      auto glob = HeaderGlob::create(str, type);
-      if (glob)
-        excludeHeaderGlobs.emplace_back(std::move(glob.get()));
-      else {
-        consumeError(glob.takeError());
+      if (auto err = excludeHeaderGlobs.add(str, type)) {
+        consumeError(std::move(err));
         if (auto file = fm.getFile(str))
           excludeHeaderFiles.emplace(*file);
         else {
@@ -822,9 +847,8 @@ bool Driver::InstallAPI::run(DiagnosticsEngine &diag, Options &opts) {
     return false;
 
   for (auto &header : headerFiles) {
-    for (auto &glob : excludeHeaderGlobs)
-      if (glob->match(header))
-        header.isExcluded = true;
+    if (excludeHeaderGlobs.match(header))
+      header.isExcluded = true;
   }
 
   if (!excludeHeaderFiles.empty()) {
@@ -837,9 +861,8 @@ bool Driver::InstallAPI::run(DiagnosticsEngine &diag, Options &opts) {
     }
   }
 
-  for (const auto &glob : excludeHeaderGlobs)
-    if (!glob->didMatch())
-      diag.report(diag::warn_glob_did_not_match) << glob->str();
+  for (auto glob : excludeHeaderGlobs.getUnmatchedGlobs())
+    diag.report(diag::warn_glob_did_not_match) << glob;
 
   // Check if the framework has an umbrella header and move that to the
   // beginning.
@@ -350,6 +350,10 @@ bool Options::processDriverOptions(DiagnosticsEngine &diag,
   if (args.hasArg(OPT_help))
     driverOptions.printHelp = true;
 
+  // Handle --serve.
+  if (args.hasArg(OPT_serve))
+    driverOptions.serve = true;
+
   // Handle output file.
   SmallString<PATH_MAX> outputPath;
   if (auto *arg = args.getLastArg(OPT_output)) {
@@ -1083,6 +1087,12 @@ bool Options::processTAPIOptions(DiagnosticsEngine &diag, InputArgList &args) {
   if (args.hasArg(OPT_deletePrivateFrameworks))
     tapiOptions.deletePrivateFrameworks = true;
 
+  if (auto *arg = args.getLastArg(OPT_stubManifest))
+    tapiOptions.stubManifestPath = arg->getValue();
+
+  if (auto *arg = args.getLastArg(OPT_scanCache))
+    tapiOptions.scanCachePath = arg->getValue();
+
   if (args.hasArg(OPT_noUUIDs))
     diag.report(diag::warn_no_uuids);
 
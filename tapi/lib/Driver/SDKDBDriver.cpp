@@ -11,6 +11,7 @@
 ///
 //===----------------------------------------------------------------------===//
 
+#include "ScanCache.h"
 #include "tapi/APIVerifier/APIVerifier.h"
 #include "tapi/Core/API.h"
 #include "tapi/Core/APIJSONSerializer.h"
@@ -464,15 +465,12 @@ static bool computeFrontendResultFromFramework(
 
   // Create the excluded headers list.
   std::set<const FileEntry *> excludeHeaderFiles;
-  std::vector<std::unique_ptr<HeaderGlob>> excludeHeaderGlobs;
+  HeaderGlobSet excludeHeaderGlobs;
   auto parseGlobs = [&](HeaderType type) {
     for (const auto &str :
          context.config.getExcludedHeaders(frameworkPath, type)) {
-      auto glob = HeaderGlob::create(str, type);
-      if (glob)
-        excludeHeaderGlobs.emplace_back(std::move(glob.get()));
-      else {
-        consumeError(glob.takeError());
+      if (auto err = excludeHeaderGlobs.add(str, type)) {
+        consumeError(std::move(err));
         if (auto file = fm.getFile(str))
           excludeHeaderFiles.emplace(*file);
         else {
@@ -491,9 +489,8 @@ static bool computeFrontendResultFromFramework(
     return false;
 
   for (auto &header : headerFiles) {
-    for (auto &glob : excludeHeaderGlobs)
-      if (glob->match(header))
-        header.isExcluded = true;
+    if (excludeHeaderGlobs.match(header))
+      header.isExcluded = true;
   }
 
   if (!excludeHeaderFiles.empty()) {
@@ -506,9 +503,8 @@ static bool computeFrontendResultFromFramework(
     }
   }
 
-  for (const auto &glob : excludeHeaderGlobs)
-    if (!glob->didMatch())
-      diag.report(diag::warn_glob_did_not_match) << glob->str();
+  for (auto glob : excludeHeaderGlobs.getUnmatchedGlobs())
+    diag.report(diag::warn_glob_did_not_match) << glob;
 
   // Exclude all the headers if the framework is in a special path with
   // the name of architectures.
@@ -1097,6 +1093,11 @@ static bool interfaceScan(sdkdb::Context &context, Options &opts) {
         opts.tapiOptions.privateUmbrellaHeaderPath;
   }
 
+  // The scan results depend on the VFS overlays and the masked paths.
+  std::string scanCacheKey;
+  for (const auto &path : opts.driverOptions.vfsOverlayPaths)
+    scanCacheKey += "overlay:" + path + "\n";
+
   // setup overlay file system if needed.
   if (!context.config.getRootMaskPaths().empty() ||
       !context.config.getSDKMaskPaths().empty()) {
@@ -1109,6 +1110,7 @@ static bool interfaceScan(sdkdb::Context &context, Options &opts) {
       SmallString<PATH_MAX> rootPath(root);
       sys::path::append(rootPath, path);
       overlay->addExtraMaskingDirectory(rootPath);
+      scanCacheKey += "mask:" + rootPath.str().str() + "\n";
     };
     for (auto &path : context.config.getRootMaskPaths()) {
       // mask the path from all the roots.
@@ -1120,6 +1122,17 @@ static bool interfaceScan(sdkdb::Context &context, Options &opts) {
     fm.setVirtualFileSystem(overlay);
   }
 
+  // Reuse the unchanged parts of the previous scan if requested.
+  std::unique_ptr<ScanCache> scanCache;
+  if (!opts.tapiOptions.scanCachePath.empty()) {
+    scanCache = std::make_unique<ScanCache>(scanCacheKey);
+    // Without a usable cache everything is scanned again.
+    if (auto err = scanCache->read(opts.tapiOptions.scanCachePath))
+      diag.report(diag::warn)
+          << ("ignoring scan cache '" + opts.tapiOptions.scanCachePath +
+              "': " + toString(std::move(err)));
+  }
+
   // Scan roots and setup VFS overlays.
   std::vector<Framework> publicFrameworks, internalFrameworks;
 
@@ -1129,6 +1142,7 @@ static bool interfaceScan(sdkdb::Context &context, Options &opts) {
                              ScannerMode::ScanRuntimeRoot);
     // Scan binary first.
     scanner.setSplitHeaderDir(context.config.useSplitHeaderDir());
+    scanner.setCache(scanCache.get());
     if (!scanner.scan(opts.sdkdbOptions.runtimeRoot))
       return false;
 
@@ -1157,6 +1171,7 @@ static bool interfaceScan(sdkdb::Context &context, Options &opts) {
     DirectoryScanner scanner(context.getFileManager(), diag,
                              ScannerMode::ScanRuntimeRoot);
     scanner.setSplitHeaderDir(context.config.useSplitHeaderDir());
+    scanner.setCache(scanCache.get());
     if (!scanner.scan(opts.sdkdbOptions.runtimeRoot))
       return false;
 
@@ -1176,6 +1191,14 @@ static bool interfaceScan(sdkdb::Context &context, Options &opts) {
            "There should be only one top level framework");
   }
 
+  if (scanCache) {
+    if (auto err = scanCache->write(opts.tapiOptions.scanCachePath)) {
+      diag.report(diag::err_cannot_write_file)
+          << opts.tapiOptions.scanCachePath << toString(std::move(err));
+      return false;
+    }
+  }
+
   // Scan frameworks.
   if (config.scanPublicHeaders) {
     auto rootPath = opts.sdkdbOptions.publicSDKContentRoot.empty()
@@ -0,0 +1,219 @@
+//===- ScanCache.cpp - Directory Scanner Cache ------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Implements the directory scanner cache.
+///
+//===----------------------------------------------------------------------===//
+
+#include "ScanCache.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+
+TAPI_NAMESPACE_INTERNAL_BEGIN
+
+static constexpr int64_t scanCacheVersion = 2;
+
+namespace {
+enum EntryFlags : int64_t {
+  Exists = 1U << 0,
+  IsSymlink = 1U << 1,
+  IsDirectory = 1U << 2,
+  IsMissing = 1U << 3,
+};
+} // end anonymous namespace
+
+static json::Value toJSON(const ScanDirectoryEntry &entry) {
+  assert(entry.exists && entry.isSymlink && entry.isDirectory &&
+         "cached entries must have all flags");
+  int64_t flags = 0;
+  if (*entry.exists)
+    flags |= Exists;
+  if (*entry.isSymlink)
+    flags |= IsSymlink;
+  if (*entry.isDirectory)
+    flags |= IsDirectory;
+  if (entry.isMissing)
+    flags |= IsMissing;
+  return json::Array{entry.path, flags};
+}
+
+static bool fromJSON(const json::Value &value, ScanDirectoryEntry &entry,
+                     json::Path path) {
+  const auto *array = value.getAsArray();
+  if (!array || array->size() != 2) {
+    path.report("expected directory entry");
+    return false;
+  }
+
+  auto entryPath = (*array)[0].getAsString();
+  auto flags = (*array)[1].getAsInteger();
+  if (!entryPath || !flags) {
+    path.report("expected directory entry");
+    return false;
+  }
+
+  entry.path = entryPath->str();
+  entry.exists = (bool)(*flags & Exists);
+  entry.isSymlink = (bool)(*flags & IsSymlink);
+  entry.isDirectory = (bool)(*flags & IsDirectory);
+  entry.isMissing = *flags & IsMissing;
+  return true;
+}
+
+Error ScanCache::read(StringRef path) {
+  auto bufferOrErr = MemoryBuffer::getFile(path, /*IsText=*/true);
+  if (auto ec = bufferOrErr.getError()) {
+    // There is no cache before the first run.
+    if (ec == std::errc::no_such_file_or_directory)
+      return Error::success();
+    return errorCodeToError(ec);
+  }
+
+  auto value = json::parse(bufferOrErr.get()->getBuffer());
+  if (!value)
+    return value.takeError();
+
+  auto malformed = [&]() {
+    return make_error<StringError>("malformed scan cache",
+                                   inconvertibleErrorCode());
+  };
+
+  auto *root = value->getAsObject();
+  if (!root)
+    return malformed();
+
+  // The scan results depend on the file system setup.
+  if (root->getInteger("version") != scanCacheVersion ||
+      root->getString("key") != StringRef(key))
+    return Error::success();
+
+  auto *cachedDirectories = root->getObject("directories");
+  auto *cachedBinaries = root->getObject("binaries");
+  if (!cachedDirectories || !cachedBinaries)
+    return malformed();
+
+  json::Path::Root jsonRoot;
+  for (const auto &it : *cachedDirectories) {
+    const auto *object = it.second.getAsObject();
+    if (!object)
+      return malformed();
+
+    Directory directory;
+    const auto *identity = object->get("identity");
+    const auto *entries = object->get("entries");
+    if (!identity || !entries)
+      return malformed();
+    if (!fromJSON(*identity, directory.identity, jsonRoot) ||
+        !json::fromJSON(*entries, directory.entries, jsonRoot))
+      return malformed();
+    directories[it.first] = std::move(directory);
+  }
+
+  for (const auto &it : *cachedBinaries) {
+    const auto *object = it.second.getAsObject();
+    if (!object)
+      return malformed();
+
+    Binary binary;
+    const auto *identity = object->get("identity");
+    auto kind = object->getInteger("kind");
+    if (!identity || !kind || *kind < 0 ||
+        *kind > (int64_t)ScanBinaryKind::Bundle ||
+        !fromJSON(*identity, binary.identity, jsonRoot))
+      return malformed();
+    binary.kind = (ScanBinaryKind)*kind;
+    binaries[it.first] = binary;
+  }
+
+  return Error::success();
+}
+
+Error ScanCache::write(StringRef path) const {
+  // Only write what this run used, so removed files don't accumulate.
+  json::Object cachedDirectories;
+  for (const auto &it : directories) {
+    const auto &directory = it.second;
+    if (!directory.used)
+      continue;
+
+    json::Array entries;
+    for (const auto &entry : directory.entries)
+      entries.push_back(toJSON(entry));
+    cachedDirectories[it.first()] = json::Object{
+        {"identity", toJSON(directory.identity)},
+        {"entries", std::move(entries)},
+    };
+  }
+
+  json::Object cachedBinaries;
+  for (const auto &it : binaries) {
+    const auto &binary = it.second;
+    if (!binary.used)
+      continue;
+
+    cachedBinaries[it.first()] = json::Object{
+        {"identity", toJSON(binary.identity)},
+        {"kind", (int64_t)binary.kind},
+    };
+  }
+
+  json::Object root{
+      {"version", scanCacheVersion},
+      {"key", key},
+      {"directories", std::move(cachedDirectories)},
+      {"binaries", std::move(cachedBinaries)},
+  };
+
+  std::error_code ec;
+  raw_fd_ostream os(path, ec, sys::fs::OF_Text);
+  if (ec)
+    return errorCodeToError(ec);
+  os << json::Value(std::move(root)) << "\n";
+  return Error::success();
+}
+
+const std::vector<ScanDirectoryEntry> *
+ScanCache::findDirectory(StringRef directory, const FileIdentity &identity) {
+  auto it = directories.find(directory);
+  if (it == directories.end() || it->second.identity != identity)
+    return nullptr;
+
+  it->second.used = true;
+  return &it->second.entries;
+}
+
+void ScanCache::addDirectory(StringRef directory, const FileIdentity &identity,
+                             std::vector<ScanDirectoryEntry> entries) {
+  auto &cached = directories[directory];
+  cached.identity = identity;
+  cached.entries = std::move(entries);
+  cached.used = true;
+}
+
+Optional<ScanBinaryKind>
+ScanCache::findBinary(StringRef path, const FileIdentity &identity) const {
+  auto it = binaries.find(path);
+  if (it == binaries.end() || it->second.identity != identity)
+    return None;
+  return it->second.kind;
+}
+
+void ScanCache::addBinary(StringRef path, const FileIdentity &identity,
+                          ScanBinaryKind kind) {
+  auto &cached = binaries[path];
+  cached.identity = identity;
+  cached.kind = kind;
+  cached.used = true;
+}
+
+TAPI_NAMESPACE_INTERNAL_END
@@ -0,0 +1,105 @@
+//===- ScanCache.h - Directory Scanner Cache --------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Records the directory listings and binary types found by the
+///        directory scanner, so the next run doesn't need to read the
+///        unchanged parts of the tree again.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef TAPI_DRIVER_SCANCACHE_H
+#define TAPI_DRIVER_SCANCACHE_H
+
+#include "tapi/Core/FileIdentity.h"
+#include "tapi/Defines.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+#include <string>
+#include <vector>
+
+TAPI_NAMESPACE_INTERNAL_BEGIN
+
+/// \brief An entry of a scanned directory.
+///
+/// The file system flags are only filled in when the listing is cached.
+/// Otherwise the scanner checks the file system when it needs a flag.
+struct ScanDirectoryEntry {
+  std::string path;
+  // The entry was listed but doesn't exist, e.g. a broken symlink.
+  bool isMissing = false;
+  llvm::Optional<bool> exists;
+  llvm::Optional<bool> isSymlink;
+  llvm::Optional<bool> isDirectory;
+};
+
+/// \brief The type of a binary found by the directory scanner.
+enum class ScanBinaryKind : uint8_t {
+  Other,
+  DynamicLibrary,
+  Bundle,
+};
+
+/// \brief On-disk cache of the directory scanner.
+///
+/// A directory listing is reused as long as the modification time and inode of
+/// the directory are unchanged, and a binary type as long as the binary is
+/// unchanged. Changes behind symlinks are not detected.
+class ScanCache {
+public:
+  /// \brief The \p key describes the file system setup of the scan (e.g. the
+  /// masked paths). A cache written with a different key is ignored.
+  explicit ScanCache(std::string key) : key(std::move(key)) {}
+
+  /// \brief Load the cache at \p path. Nothing is loaded if the cache doesn't
+  /// exist or was written with a different key.
+  llvm::Error read(llvm::StringRef path);
+
+  /// \brief Write the entries used by this run to \p path.
+  llvm::Error write(llvm::StringRef path) const;
+
+  /// \brief Find the listing of \p directory if it is unchanged.
+  const std::vector<ScanDirectoryEntry> *
+  findDirectory(llvm::StringRef directory, const FileIdentity &identity);
+
+  /// \brief Record the listing of \p directory.
+  void addDirectory(llvm::StringRef directory, const FileIdentity &identity,
+                    std::vector<ScanDirectoryEntry> entries);
+
+  /// \brief Find the type of the binary at \p path if it is unchanged. This
+  /// can be called concurrently.
+  llvm::Optional<ScanBinaryKind> findBinary(llvm::StringRef path,
+                                            const FileIdentity &identity) const;
+
+  /// \brief Record the type of the binary at \p path.
+  void addBinary(llvm::StringRef path, const FileIdentity &identity,
+                 ScanBinaryKind kind);
+
+private:
+  struct Directory {
+    FileIdentity identity;
+    std::vector<ScanDirectoryEntry> entries;
+    bool used = false;
+  };
+
+  struct Binary {
+    FileIdentity identity;
+    ScanBinaryKind kind = ScanBinaryKind::Other;
+    bool used = false;
+  };
+
+  std::string key;
+  llvm::StringMap<Directory> directories;
+  llvm::StringMap<Binary> binaries;
+};
+
+TAPI_NAMESPACE_INTERNAL_END
+
+#endif // TAPI_DRIVER_SCANCACHE_H
@@ -0,0 +1,256 @@
+//===- lib/Driver/ServeDriver.cpp - TAPI Serve Driver -----------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Implements the serve driver, which runs tapi commands for a build
+///        system in a long running process.
+///
+/// Every line of the standard input is a JSON request:
+///
+///   {"arguments": ["stubify", "-o", "out.tbd", "in.dylib"],
+///    "directory": "/path/to/working/directory"}
+///
+/// The arguments are the ones that follow the program name on the command
+/// line. The command runs exactly as it would from the command line, and the
+/// response is written as one JSON line to the standard output:
+///
+///   {"exitCode": 0, "stdout": "...", "stderr": "..."}
+///
+/// The interface files that installapi reads for re-exported libraries are
+/// parsed once and kept until they change on disk. The other commands, and the
+/// file system caches, start from scratch for every request.
+///
+//===----------------------------------------------------------------------===//
+
+#include "tapi/Core/InterfaceFileManager.h"
+#include "tapi/Core/LLVM.h"
+#include "tapi/Defines.h"
+#include "tapi/Diagnostics/Diagnostics.h"
+#include "tapi/Driver/Driver.h"
+#include "tapi/Driver/Options.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace llvm;
+
+TAPI_NAMESPACE_INTERNAL_BEGIN
+
+namespace {
+
+struct Request {
+  std::vector<std::string> arguments;
+  std::string directory;
+};
+
+struct Response {
+  int exitCode = 1;
+  std::string stdoutText;
+  std::string stderrText;
+};
+
+/// \brief Redirects a standard file descriptor into a temporary file for the
+/// lifetime of the object.
+class CapturedStream {
+public:
+  CapturedStream(int fd) : fd(fd) {}
+
+  Error start() {
+    if (auto ec = sys::fs::createTemporaryFile("tapi-serve", "txt", captureFD,
+                                               capturePath))
+      return errorCodeToError(ec);
+    savedFD = ::dup(fd);
+    if (savedFD < 0 || ::dup2(captureFD, fd) < 0)
+      return errorCodeToError(std::error_code(errno, std::generic_category()));
+    return Error::success();
+  }
+
+  /// \brief Restore the file descriptor and return what was written to it.
+  std::string finish() {
+    if (savedFD >= 0) {
+      ::dup2(savedFD, fd);
+      sys::Process::SafelyCloseFileDescriptor(savedFD);
+      savedFD = -1;
+    }
+    if (captureFD < 0)
+      return {};
+
+    sys::Process::SafelyCloseFileDescriptor(captureFD);
+    captureFD = -1;
+    std::string text;
+    if (auto bufferOrErr = MemoryBuffer::getFile(capturePath))
+      text = bufferOrErr.get()->getBuffer().str();
+    sys::fs::remove(capturePath);
+    return text;
+  }
+
+  ~CapturedStream() { finish(); }
+
+private:
+  int fd;
+  int savedFD = -1;
+  int captureFD = -1;
+  SmallString<PATH_MAX> capturePath;
+};
+
+} // end anonymous namespace.
+
+static Expected<Request> parseRequest(StringRef line) {
+  auto value = json::parse(line);
+  if (!value)
+    return value.takeError();
+
+  auto malformed = []() {
+    return make_error<StringError>("malformed request",
+                                   inconvertibleErrorCode());
+  };
+
+  const auto *object = value->getAsObject();
+  if (!object)
+    return malformed();
+
+  const auto *arguments = object->getArray("arguments");
+  if (!arguments)
+    return malformed();
+
+  Request request;
+  for (const auto &argument : *arguments) {
+    auto str = argument.getAsString();
+    if (!str)
+      return malformed();
+    request.arguments.emplace_back(str->str());
+  }
+
+  // A nested server would read the requests meant for this one.
+  if (is_contained(request.arguments, "--serve"))
+    return make_error<StringError>("requests cannot use --serve",
+                                   inconvertibleErrorCode());
+
+  if (const auto *directory = object->get("directory")) {
+    auto str = directory->getAsString();
+    if (!str)
+      return malformed();
+    request.directory = str->str();
+  }
+
+  return request;
+}
+
+static Response runRequest(StringRef programName, const Request &request,
+                           StringRef initialDirectory,
+                           InterfaceFileManager &interfaceMgr) {
+  Response response;
+  StringRef directory =
+      request.directory.empty() ? initialDirectory : request.directory;
+  if (auto ec = sys::fs::set_current_path(directory)) {
+    response.stderrText = ("error: cannot change the working directory to '" +
+                           directory + "': " + ec.message() + "\n")
+                              .str();
+    return response;
+  }
+
+  std::vector<const char *> args;
+  args.push_back(programName.data());
+  for (const auto &argument : request.arguments)
+    args.push_back(argument.c_str());
+
+  // Capture everything the command prints, including the output of the clang
+  // frontend that doesn't go through the diagnostics engine.
+  outs().flush();
+  CapturedStream capturedStdout(STDOUT_FILENO);
+  CapturedStream capturedStderr(STDERR_FILENO);
+  if (auto err = capturedStdout.start()) {
+    response.stderrText = "error: " + toString(std::move(err)) + "\n";
+    return response;
+  }
+  if (auto err = capturedStderr.start()) {
+    capturedStdout.finish();
+    response.stderrText = "error: " + toString(std::move(err)) + "\n";
+    return response;
+  }
+
+  response.exitCode = Driver::run(args, &interfaceMgr) ? 0 : 1;
+
+  outs().flush();
+  response.stdoutText = capturedStdout.finish();
+  response.stderrText = capturedStderr.finish();
+  return response;
+}
+
+static void writeResponse(raw_ostream &os, Response &response) {
+  auto toJSONString = [](std::string &text) {
+    return json::isUTF8(text) ? std::move(text) : json::fixUTF8(text);
+  };
+
+  json::Object object{
+      {"exitCode", response.exitCode},
+      {"stdout", toJSONString(response.stdoutText)},
+      {"stderr", toJSONString(response.stderrText)},
+  };
+  os << json::Value(std::move(object)) << "\n";
+  os.flush();
+}
+
+/// \brief Run the commands read from the standard input in this process, so a
+/// build system doesn't pay for starting tapi on every invocation.
+bool Driver::Serve::run(DiagnosticsEngine &diag, Options &opts) {
+  SmallString<PATH_MAX> initialDirectory;
+  if (auto ec = sys::fs::current_path(initialDirectory)) {
+    diag.report(diag::err) << "cannot get the working directory"
+                           << ec.message();
+    return false;
+  }
+
+  // The responses go to the original standard output, which is redirected
+  // while a command runs.
+  outs().flush();
+  int responseFD = ::dup(STDOUT_FILENO);
+  if (responseFD < 0) {
+    diag.report(diag::err) << "cannot duplicate the standard output"
+                           << std::strerror(errno);
+    return false;
+  }
+  raw_fd_ostream responses(responseFD, /*shouldClose=*/true);
+
+  // Keep the parsed interface files across the commands.
+  InterfaceFileManager interfaceMgr(opts.getFileManager(),
+                                    opts.tapiOptions.isBnI);
+
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    if (StringRef(line).trim().empty())
+      continue;
+
+    Response response;
+    auto request = parseRequest(line);
+    if (request) {
+      response = runRequest(opts.getProgramName(), *request, initialDirectory,
+                            interfaceMgr);
+      // The file manager of the command is gone, don't keep a reference to it.
+      interfaceMgr.setFileManager(opts.getFileManager(),
+                                  opts.tapiOptions.isBnI);
+    } else {
+      response.stderrText = "error: " + toString(request.takeError()) + "\n";
+    }
+
+    writeResponse(responses, response);
+  }
+
+  return true;
+}
+
+TAPI_NAMESPACE_INTERNAL_END
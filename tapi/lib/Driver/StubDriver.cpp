@@ -11,6 +11,7 @@
 ///
 //===----------------------------------------------------------------------===//
 
+#include "StubManifest.h"
 #include "tapi/Core/ClangDiagnostics.h"
 #include "tapi/Core/FileSystem.h"
 #include "tapi/Core/InterfaceFileManager.h"
@@ -23,8 +24,11 @@
 #include "tapi/Driver/Options.h"
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Driver/DriverDiagnostic.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/BinaryFormat/Magic.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/TextAPI/InterfaceFile.h"
 #include <queue>
 #include <string>
@@ -38,6 +42,17 @@ TAPI_NAMESPACE_INTERNAL_BEGIN
 // Stub Driver Context.
 namespace {
 
+/// A reexported library that was resolved and had its own reexports inlined.
+struct ReexportedLibrary {
+  std::shared_ptr<InterfaceFile> library;
+  /// The libraries inlined into the library. InterfaceFile::inlineLibrary()
+  /// moves them out of the library the first time it is inlined into an
+  /// umbrella, so keep them here for the later umbrellas.
+  std::vector<std::shared_ptr<InterfaceFile>> documents;
+  /// Paths of the library and all the libraries inlined into it.
+  std::set<std::string> dependencies;
+};
+
 struct Context {
   Context(FileManager &fm, DiagnosticsEngine &diag, bool isBnI)
       : fm(fm), diag(diag),
@@ -68,6 +83,15 @@ struct Context {
   DiagnosticsEngine &diag;
   InterfaceFileManager interfaceMgr;
   FileType fileType;
+
+  /// Reexported libraries that were already inlined, by install name.
+  StringMap<ReexportedLibrary> reexportedLibraries;
+
+  /// Manifest of the previous run and the manifest for this run, only used
+  /// for directory inputs.
+  std::string manifestPath;
+  std::unique_ptr<StubManifest> previousManifest;
+  std::unique_ptr<StubManifest> manifest;
 };
 
 struct SymlinkInfo {
@@ -81,6 +105,28 @@ struct SymlinkInfo {
       : srcPath(std::string(path)), symlinkContent(std::string(link)) {}
 };
 
+/// A file found while scanning the input directory that might be a dynamic
+/// library or a text-based stub.
+struct StubCandidate {
+  std::string path;
+  /// The path without extension, which identifies the stub it belongs to.
+  std::string normalizedPath;
+  std::unique_ptr<InterfaceFile> interface;
+  Optional<std::string> error;
+  /// Set if the stub from the previous run is still up to date, the file is
+  /// not read then.
+  const StubManifestEntry *upToDate = nullptr;
+
+  StubCandidate(StringRef path) : path(std::string(path)) {}
+};
+
+/// The file a stub is generated from.
+struct StubInput {
+  std::string path;
+  /// Null if the stub from the previous run is still up to date.
+  std::unique_ptr<InterfaceFile> interface;
+};
+
 
 } // namespace
 
@@ -189,7 +235,36 @@ static bool isPrivatePath(StringRef path, bool isSymlink = false) {
 }
 
 
-static bool inlineFrameworks(Context &ctx, InterfaceFile *dylib) {
+static bool inlineFrameworks(Context &ctx, InterfaceFile *dylib,
+                             std::set<std::string> &dependencies);
+
+/// \brief Find a reexported library and inline its own reexports. The result
+/// is cached, because the same private frameworks are reexported by many
+/// umbrellas.
+static const ReexportedLibrary *getReexportedLibrary(Context &ctx,
+                                                     StringRef installName) {
+  auto it = ctx.reexportedLibraries.find(installName);
+  if (it != ctx.reexportedLibraries.end())
+    return &it->second;
+
+  auto reexportedDylib = findAndGetReexportedLibrary(installName, ctx,
+                                                     /*printErrors = */ true);
+  if (!reexportedDylib)
+    return nullptr;
+  std::set<std::string> dependencies;
+  if (!inlineFrameworks(ctx, reexportedDylib.get(), dependencies))
+    return nullptr;
+  dependencies.emplace(reexportedDylib->getPath());
+
+  auto &entry = ctx.reexportedLibraries[installName];
+  entry.documents = reexportedDylib->documents();
+  entry.dependencies = std::move(dependencies);
+  entry.library = std::move(reexportedDylib);
+  return &entry;
+}
+
+static bool inlineFrameworks(Context &ctx, InterfaceFile *dylib,
+                             std::set<std::string> &dependencies) {
   assert(ctx.fileType >= FileType::TBD_V3 &&
          "inlining is not supported for earlier TBD versions");
   auto &reexports = dylib->reexportedLibraries();
@@ -200,21 +275,23 @@ static bool inlineFrameworks(Context &ctx, InterfaceFile *dylib) {
     if (lib.getInstallName().startswith("@"))
       continue;
 
-    auto reexportedDylib =
-        findAndGetReexportedLibrary(lib.getInstallName(), ctx,
-                                    /*printErrors = */ true);
-    if (!reexportedDylib)
-      return false;
-    if (!inlineFrameworks(ctx, reexportedDylib.get()))
+    auto *reexported = getReexportedLibrary(ctx, lib.getInstallName());
+    if (!reexported)
       return false;
     auto overwriteFramework = false;
 
-    if (!ctx.registry.canWrite(reexportedDylib.get(), ctx.fileType)) {
+    if (!ctx.registry.canWrite(reexported->library.get(), ctx.fileType)) {
       ctx.diag.report(diag::err_cannot_convert_dylib)
-          << reexportedDylib->getPath();
+          << reexported->library->getPath();
       return false;
     }
-    dylib->inlineLibrary(reexportedDylib, overwriteFramework);
+    // Inlining the library would also add its documents, but only the first
+    // time. Add them explicitly so every umbrella gets the same result.
+    for (const auto &document : reexported->documents)
+      dylib->inlineLibrary(document, overwriteFramework);
+    dylib->inlineLibrary(reexported->library, overwriteFramework);
+    dependencies.insert(reexported->dependencies.begin(),
+                        reexported->dependencies.end());
   }
 
   return true;
@@ -261,7 +338,8 @@ static bool stubifyDynamicLibrary(Context &ctx) {
   }
 
   if (ctx.inlinePrivateFrameworks) {
-    if (!inlineFrameworks(ctx, dylib))
+    std::set<std::string> dependencies;
+    if (!inlineFrameworks(ctx, dylib, dependencies))
       return false;
   }
 
@@ -283,6 +361,92 @@ static bool stubifyDynamicLibrary(Context &ctx) {
   return true;
 }
 
+/// \brief Check the start of a file to see if it could be a dynamic library or
+/// a text-based stub, so that resources and data files don't have to be read
+/// completely just to be discarded.
+static std::error_code isPossibleStubInput(StringRef path, bool &result) {
+  result = false;
+  auto fd = sys::fs::openNativeFileForRead(path);
+  if (!fd)
+    return errorToErrorCode(fd.takeError());
+
+  char buffer[512];
+  auto bytesRead =
+      sys::fs::readNativeFile(*fd, MutableArrayRef<char>(buffer));
+  sys::fs::closeFile(*fd);
+  if (!bytesRead)
+    return errorToErrorCode(bytesRead.takeError());
+
+  StringRef header(buffer, *bytesRead);
+  switch (identify_magic(header)) {
+  case file_magic::macho_dynamically_linked_shared_lib:
+  case file_magic::macho_dynamically_linked_shared_lib_stub:
+  case file_magic::macho_universal_binary:
+    result = true;
+    return {};
+  default:
+    break;
+  }
+
+  // YAML text-based stubs start with a document marker. JSON text-based stubs
+  // are only read from files with the .tbd extension.
+  header = header.ltrim();
+  result = header.startswith("---") ||
+           (path.endswith(".tbd") && header.startswith("{"));
+  return {};
+}
+
+/// \brief Read a stub candidate and convert it into an interface file. This
+/// runs concurrently for all candidates, so it must not use the file manager or
+/// report diagnostics.
+static void readStubCandidate(const Context &ctx, StubCandidate &candidate) {
+  if (ctx.previousManifest) {
+    candidate.upToDate = ctx.previousManifest->findUpToDate(candidate.path);
+    if (candidate.upToDate)
+      return;
+  }
+
+  bool isPossibleStub;
+  if (auto ec = isPossibleStubInput(candidate.path, isPossibleStub)) {
+    candidate.error = ec.message();
+    return;
+  }
+  if (!isPossibleStub)
+    return;
+
+  auto bufferOrErr = MemoryBuffer::getFile(candidate.path);
+  if (auto ec = bufferOrErr.getError()) {
+    candidate.error = ec.message();
+    return;
+  }
+
+  // Check for dynamic libs and text-based stub files.
+  if (!ctx.registry.canRead(bufferOrErr.get()->getMemBufferRef(),
+                            FileType::MachO_DynamicLibrary |
+                                FileType::MachO_DynamicLibrary_Stub |
+                                Registry::getTextFileType()))
+    return;
+
+  if (StringRef(candidate.path).endswith(".tbd")) {
+    auto file = ctx.registry.readTextFile(std::move(bufferOrErr.get()),
+                                          ReadFlags::Symbols);
+    if (!file) {
+      candidate.error = toString(file.takeError());
+      return;
+    }
+    candidate.interface = std::move(*file);
+    return;
+  }
+
+  auto file =
+      ctx.registry.readFile(std::move(bufferOrErr.get()), ReadFlags::Symbols);
+  if (!file) {
+    candidate.error = toString(file.takeError());
+    return;
+  }
+  candidate.interface = convertToInterfaceFile(*file);
+}
+
 /// \brief Converts all dynamic libraries/frameworks to text-based stubs if
 /// possible. Also create the same symlinks as the ones that pointed to the
 /// original library. If requested the source library will be deleted.
@@ -291,10 +455,23 @@ static bool stubifyDynamicLibrary(Context &ctx) {
 static bool stubifyDirectory(Context &ctx) {
   assert(ctx.inputPath.back() != '/' && "Unexpected / at end of input path.");
 
+  if (!ctx.manifestPath.empty()) {
+    ctx.previousManifest = std::make_unique<StubManifest>(
+        ctx.fileType, ctx.inlinePrivateFrameworks);
+    ctx.manifest = std::make_unique<StubManifest>(ctx.fileType,
+                                                  ctx.inlinePrivateFrameworks);
+    // Without a usable manifest every input is stubified again.
+    if (auto err = ctx.previousManifest->read(ctx.manifestPath))
+      ctx.diag.report(diag::warn)
+          << ("ignoring stub manifest '" + ctx.manifestPath +
+              "': " + toString(std::move(err)));
+  }
+
   std::map<std::string, std::vector<SymlinkInfo>> symlinks;
-  std::map<std::string, std::unique_ptr<InterfaceFile>> dylibs;
+  std::map<std::string, StubInput> dylibs;
   std::map<std::string, std::string> originalNames;
   std::set<std::pair<std::string, bool>> toDelete;
+  std::vector<StubCandidate> candidates;
   std::error_code ec;
   for (sys::fs::recursive_directory_iterator i(ctx.inputPath, ec), ie; i != ie;
        i.increment(ec)) {
@@ -407,96 +584,62 @@ static bool stubifyDirectory(Context &ctx) {
       continue;
     }
 
-    auto bufferOrErr = ctx.fm.getBufferForFile(*file);
-    if (auto ec = bufferOrErr.getError()) {
-      ctx.diag.report(diag::err_cannot_read_file) << path << ec.message();
-      return false;
-    }
-
-    // Check for dynamic libs and text-based stub files.
-    if (!ctx.registry.canRead(bufferOrErr.get()->getMemBufferRef(),
-                              FileType::MachO_DynamicLibrary |
-                                  FileType::MachO_DynamicLibrary_Stub |
-                                  Registry::getTextFileType()))
-      continue;
-
-    std::unique_ptr<InterfaceFile> interface = nullptr;
-    if (path.endswith(".tbd")) {
-      auto file2 = ctx.registry.readTextFile(std::move(bufferOrErr.get()),
-                                             ReadFlags::Symbols);
-      if (!file2) {
-        ctx.diag.report(diag::err_cannot_read_file)
-            << path << toString(file2.takeError());
-        return false;
-      }
-      interface = std::move(*file2);
-    } else {
-      auto file2 = ctx.registry.readFile(std::move(bufferOrErr.get()),
-                                         ReadFlags::Symbols);
-      if (!file2) {
-        ctx.diag.report(diag::err_cannot_read_file)
-            << path << toString(file2.takeError());
-        return false;
-      }
-      interface = convertToInterfaceFile(*file2);
-    }
-
-    if (ctx.traceLibraryLocation)
-      errs() << path << "\n";
+    candidates.emplace_back(path);
+  }
 
-    // Normalize path for map lookup by removing the extension.
-    SmallString<PATH_MAX> normalizedPath(path);
+  // Count the candidates of every stub. A stub can be written once all the
+  // candidates with its path were merged.
+  StringMap<unsigned> pendingCandidates;
+  for (auto &candidate : candidates) {
+    SmallString<PATH_MAX> normalizedPath(candidate.path);
     TAPI_INTERNAL::replace_extension(normalizedPath, "");
-
-    if ((interface->getFileType() == FileType::MachO_DynamicLibrary) ||
-        (interface->getFileType() == FileType::MachO_DynamicLibrary_Stub)) {
-      originalNames[normalizedPath.c_str()] = interface->getPath();
-
-      // Don't add this MachO dynamic library, because we already have a
-      // text-based stub recorded for this path.
-      if (dylibs.count(normalizedPath.c_str()))
-        continue;
-    }
-
-    // FIXME: Once we use C++17, this can be simplified.
-    auto it = dylibs.find(normalizedPath.c_str());
-    if (it != dylibs.end())
-      it->second = std::move(interface);
-    else
-      dylibs.emplace(std::piecewise_construct,
-                     std::forward_as_tuple(normalizedPath.c_str()),
-                     std::forward_as_tuple(std::move(interface)));
+    candidate.normalizedPath = std::string(normalizedPath);
+    ++pendingCandidates[candidate.normalizedPath];
   }
 
-  for (auto &it : dylibs) {
-    auto &dylib = it.second;
-    SmallString<PATH_MAX> input(dylib->getPath());
-    SmallString<PATH_MAX> output = input;
+  auto writeStub = [&](StubInput &input) {
+    SmallString<PATH_MAX> output(input.path);
     TAPI_INTERNAL::replace_extension(output, ".tbd");
 
-    if (!ctx.registry.canWrite(dylib.get(), ctx.fileType)) {
-      ctx.diag.report(diag::err_cannot_convert_dylib) << dylib->getPath();
-      return false;
-    }
+    // Inputs without an interface file are unchanged since the previous run
+    // and still have their stub.
+    if (auto &dylib = input.interface) {
+      if (!ctx.registry.canWrite(dylib.get(), ctx.fileType)) {
+        ctx.diag.report(diag::err_cannot_convert_dylib) << dylib->getPath();
+        return false;
+      }
 
-    if (ctx.inlinePrivateFrameworks && !inlineFrameworks(ctx, dylib.get()))
-      return false;
+      std::set<std::string> dependencies;
+      if (ctx.inlinePrivateFrameworks &&
+          !inlineFrameworks(ctx, dylib.get(), dependencies))
+        return false;
 
+      auto result = ctx.interfaceMgr.writeFile(std::string(output),
+                                               dylib.get(), ctx.fileType);
+      if (result) {
+        ctx.diag.report(diag::err_cannot_write_file)
+            << output << toString(std::move(result));
+        return false;
+      }
 
-    auto result = ctx.interfaceMgr.writeFile(std::string(output), dylib.get(),
-                                             ctx.fileType);
-    if (result) {
-      ctx.diag.report(diag::err_cannot_write_file)
-          << output << toString(std::move(result));
-      return false;
+      if (ctx.manifest) {
+        auto fileType = dylib->getFileType();
+        ctx.manifest->add(input.path, output,
+                          fileType == FileType::MachO_DynamicLibrary ||
+                              fileType == FileType::MachO_DynamicLibrary_Stub,
+                          dependencies);
+      }
+
+      // Only the path is needed from here on, release the interface file.
+      dylib.reset();
     }
 
     // Get the original file name.
-    SmallString<PATH_MAX> normalizedPath(dylib->getPath());
+    SmallString<PATH_MAX> normalizedPath(input.path);
     TAPI_INTERNAL::replace_extension(normalizedPath, "");
     auto it2 = originalNames.find(normalizedPath.c_str());
     if (it2 == originalNames.end())
-      continue;
+      return true;
     auto originalName = it2->second;
 
     if (ctx.deleteInputFile)
@@ -522,6 +665,7 @@ static bool stubifyDirectory(Context &ctx) {
             ctx.diag.report(diag::err) << linkTarget << ec.message();
             return false;
           }
+          ctx.fm.invalidateDirectoryListings(linkSrc);
 
           if (ctx.deleteInputFile)
             toDelete.emplace(symInfo.srcPath, true);
@@ -531,7 +675,78 @@ static bool stubifyDirectory(Context &ctx) {
       } else
         break;
     }
+
+    return true;
+  };
+
+  // Reading and converting the files is independent, so do it on all threads,
+  // a batch at a time. The results are merged in scan order to keep the output
+  // deterministic, and every stub is written as soon as all its candidates
+  // were merged, so only a few interface files are kept in memory. An input
+  // that can't be read stops the conversion, but the stubs of the previous
+  // batches are already written by then.
+  size_t batchSize = parallel::strategy.compute_thread_count() * 4;
+  for (size_t begin = 0; begin < candidates.size(); begin += batchSize) {
+    auto batch =
+        makeMutableArrayRef(candidates).slice(begin).take_front(batchSize);
+    parallelForEach(batch, [&](StubCandidate &candidate) {
+      readStubCandidate(ctx, candidate);
+    });
+
+    std::vector<StringRef> finished;
+    for (auto &candidate : batch) {
+      StringRef path = candidate.path;
+      if (candidate.error) {
+        ctx.diag.report(diag::err_cannot_read_file) << path << *candidate.error;
+        return false;
+      }
+
+      if (--pendingCandidates[candidate.normalizedPath] == 0)
+        finished.emplace_back(candidate.normalizedPath);
+
+      bool isDynamicLibrary;
+      if (candidate.upToDate) {
+        isDynamicLibrary = candidate.upToDate->isDynamicLibrary;
+        ctx.manifest->add(path, *candidate.upToDate);
+      } else {
+        // Not a dynamic library or text-based stub file.
+        if (!candidate.interface)
+          continue;
+
+        if (ctx.traceLibraryLocation)
+          errs() << path << "\n";
+
+        auto fileType = candidate.interface->getFileType();
+        isDynamicLibrary = fileType == FileType::MachO_DynamicLibrary ||
+                           fileType == FileType::MachO_DynamicLibrary_Stub;
+      }
+
+      if (isDynamicLibrary) {
+        originalNames[candidate.normalizedPath] = candidate.path;
+
+        // Don't add this MachO dynamic library, because we already have a
+        // text-based stub recorded for this path.
+        if (dylibs.count(candidate.normalizedPath)) {
+          candidate.interface.reset();
+          continue;
+        }
+      }
+
+      auto &input = dylibs[candidate.normalizedPath];
+      input.path = candidate.path;
+      input.interface = std::move(candidate.interface);
+    }
+
+    for (auto normalizedPath : finished) {
+      auto it = dylibs.find(normalizedPath.str());
+      if (it == dylibs.end())
+        continue;
+      if (!writeStub(it->second))
+        return false;
+      dylibs.erase(it);
+    }
   }
+  assert(dylibs.empty() && "all stubs should have been written");
 
   // Recursively delete the directories (this will abort when they are not empty
   // or we reach the root of the SDK.
@@ -556,6 +771,14 @@ static bool stubifyDirectory(Context &ctx) {
     } while (!ec);
   }
 
+  if (ctx.manifest) {
+    if (auto err = ctx.manifest->write(ctx.manifestPath)) {
+      ctx.diag.report(diag::err_cannot_write_file)
+          << ctx.manifestPath << toString(std::move(err));
+      return false;
+    }
+  }
+
   return true;
 }
 
@@ -578,6 +801,7 @@ bool Driver::Stub::run(DiagnosticsEngine &diag, Options &opts) {
   ctx.inlinePrivateFrameworks = opts.tapiOptions.inlinePrivateFrameworks;
   ctx.deletePrivateFrameworks = opts.tapiOptions.deletePrivateFrameworks;
   ctx.traceLibraryLocation = opts.tapiOptions.traceLibraryLocation;
+  ctx.manifestPath = opts.tapiOptions.stubManifestPath;
 
 
   // Handle isysroot.
@@ -635,6 +859,12 @@ bool Driver::Stub::run(DiagnosticsEngine &diag, Options &opts) {
     return false;
   }
 
+  // Only the directory mode records and reuses its stubs in a manifest.
+  if (isFile && !ctx.manifestPath.empty()) {
+    diag.report(diag::err_manifest_requires_directory) << ctx.inputPath;
+    return false;
+  }
+
   // Handle -o.
   if (!opts.driverOptions.outputPath.empty())
     ctx.outputPath = opts.driverOptions.outputPath;
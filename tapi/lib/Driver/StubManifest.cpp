@@ -0,0 +1,196 @@
+//===- StubManifest.cpp - Stubify Manifest ----------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Implements the stubify manifest.
+///
+//===----------------------------------------------------------------------===//
+
+#include "StubManifest.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+using namespace llvm::MachO;
+
+TAPI_NAMESPACE_INTERNAL_BEGIN
+
+static constexpr int64_t manifestVersion = 1;
+
+static Optional<FileIdentity> parseIdentity(const json::Value *value) {
+  FileIdentity identity;
+  json::Path::Root root;
+  if (!value || !fromJSON(*value, identity, root))
+    return None;
+  return identity;
+}
+
+static Optional<StubManifestEntry> parseEntry(const json::Object &object) {
+  StubManifestEntry entry;
+  auto input = parseIdentity(object.get("identity"));
+  auto isDynamicLibrary = object.getBoolean("dylib");
+  auto outputPath = object.getString("output");
+  auto output = parseIdentity(object.get("outputIdentity"));
+  const auto *dependencies = object.getArray("dependencies");
+  if (!input || !isDynamicLibrary || !outputPath || !output || !dependencies)
+    return None;
+
+  entry.input = *input;
+  entry.isDynamicLibrary = *isDynamicLibrary;
+  entry.outputPath = outputPath->str();
+  entry.output = *output;
+  for (const auto &value : *dependencies) {
+    const auto *dependency = value.getAsObject();
+    if (!dependency)
+      return None;
+    auto path = dependency->getString("path");
+    auto identity = parseIdentity(dependency->get("identity"));
+    if (!path || !identity)
+      return None;
+    entry.dependencies.emplace_back(path->str(), *identity);
+  }
+
+  return entry;
+}
+
+Error StubManifest::read(StringRef path) {
+  auto bufferOrErr = MemoryBuffer::getFile(path, /*IsText=*/true);
+  if (auto ec = bufferOrErr.getError()) {
+    // There is no manifest before the first run.
+    if (ec == std::errc::no_such_file_or_directory)
+      return Error::success();
+    return errorCodeToError(ec);
+  }
+
+  auto value = json::parse(bufferOrErr.get()->getBuffer());
+  if (!value)
+    return value.takeError();
+
+  auto malformed = [&]() {
+    return make_error<StringError>("malformed stub manifest",
+                                   inconvertibleErrorCode());
+  };
+
+  auto *root = value->getAsObject();
+  if (!root)
+    return malformed();
+
+  // Stubs written for different options are out of date.
+  if (root->getInteger("version") != manifestVersion ||
+      root->getInteger("fileType") != (int64_t)fileType ||
+      root->getBoolean("inlinePrivateFrameworks") != inlinePrivateFrameworks)
+    return Error::success();
+
+  auto *inputs = root->getObject("inputs");
+  if (!inputs)
+    return malformed();
+
+  for (const auto &input : *inputs) {
+    const auto *object = input.second.getAsObject();
+    if (!object)
+      return malformed();
+    auto entry = parseEntry(*object);
+    if (!entry)
+      return malformed();
+    entries.emplace(input.first.str(), std::move(*entry));
+  }
+
+  return Error::success();
+}
+
+Error StubManifest::write(StringRef path) const {
+  json::Object inputs;
+  for (const auto &it : entries) {
+    const auto &entry = it.second;
+    json::Array dependencies;
+    for (const auto &dependency : entry.dependencies)
+      dependencies.push_back(json::Object{
+          {"path", dependency.first},
+          {"identity", toJSON(dependency.second)},
+      });
+
+    inputs[it.first] = json::Object{
+        {"identity", toJSON(entry.input)},
+        {"dylib", entry.isDynamicLibrary},
+        {"output", entry.outputPath},
+        {"outputIdentity", toJSON(entry.output)},
+        {"dependencies", std::move(dependencies)},
+    };
+  }
+
+  json::Object root{
+      {"version", manifestVersion},
+      {"fileType", (int64_t)fileType},
+      {"inlinePrivateFrameworks", inlinePrivateFrameworks},
+      {"inputs", std::move(inputs)},
+  };
+
+  std::error_code ec;
+  raw_fd_ostream os(path, ec, sys::fs::OF_Text);
+  if (ec)
+    return errorCodeToError(ec);
+  os << formatv("{0:2}", json::Value(std::move(root))) << "\n";
+  return Error::success();
+}
+
+const StubManifestEntry *StubManifest::findUpToDate(StringRef inputPath) const {
+  auto it = entries.find(inputPath.str());
+  if (it == entries.end())
+    return nullptr;
+
+  const auto &entry = it->second;
+  auto isUnchanged = [](StringRef path, const FileIdentity &identity) {
+    auto current = FileIdentity::get(path);
+    return current && *current == identity;
+  };
+
+  if (!isUnchanged(inputPath, entry.input) ||
+      !isUnchanged(entry.outputPath, entry.output))
+    return nullptr;
+
+  for (const auto &dependency : entry.dependencies) {
+    if (!isUnchanged(dependency.first, dependency.second))
+      return nullptr;
+  }
+
+  return &entry;
+}
+
+void StubManifest::add(StringRef inputPath, const StubManifestEntry &entry) {
+  entries[inputPath.str()] = entry;
+}
+
+void StubManifest::add(StringRef inputPath, StringRef outputPath,
+                       bool isDynamicLibrary,
+                       const std::set<std::string> &dependencies) {
+  // Don't record the stub if any of the files can't be accessed, it will be
+  // regenerated by the next run.
+  auto input = FileIdentity::get(inputPath);
+  auto output = FileIdentity::get(outputPath);
+  if (!input || !output)
+    return;
+
+  StubManifestEntry entry;
+  entry.input = *input;
+  entry.isDynamicLibrary = isDynamicLibrary;
+  entry.outputPath = outputPath.str();
+  entry.output = *output;
+  for (const auto &path : dependencies) {
+    auto identity = FileIdentity::get(path);
+    if (!identity)
+      return;
+    entry.dependencies.emplace_back(path, *identity);
+  }
+
+  entries[inputPath.str()] = std::move(entry);
+}
+
+TAPI_NAMESPACE_INTERNAL_END
@@ -0,0 +1,71 @@
+//===- StubManifest.h - Stubify Manifest ------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Records the stubs written by a stubify run, so the next run can skip
+///        the inputs that didn't change.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef TAPI_DRIVER_STUBMANIFEST_H
+#define TAPI_DRIVER_STUBMANIFEST_H
+
+#include "tapi/Core/FileIdentity.h"
+#include "tapi/Defines.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+#include "llvm/TextAPI/InterfaceFile.h"
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+TAPI_NAMESPACE_INTERNAL_BEGIN
+
+/// \brief A stub written for an input file.
+struct StubManifestEntry {
+  FileIdentity input;
+  bool isDynamicLibrary = false;
+  std::string outputPath;
+  FileIdentity output;
+  /// Reexported libraries that were inlined into the stub.
+  std::vector<std::pair<std::string, FileIdentity>> dependencies;
+};
+
+class StubManifest {
+public:
+  StubManifest(llvm::MachO::FileType fileType, bool inlinePrivateFrameworks)
+      : fileType(fileType), inlinePrivateFrameworks(inlinePrivateFrameworks) {}
+
+  /// \brief Load the entries of the manifest at \p path. Nothing is loaded if
+  /// the manifest doesn't exist or was written for different stub options.
+  llvm::Error read(llvm::StringRef path);
+
+  /// \brief Write the manifest to \p path.
+  llvm::Error write(llvm::StringRef path) const;
+
+  /// \brief Find the entry for \p inputPath if the input, the stub and all the
+  /// inlined libraries are unchanged since the entry was recorded.
+  const StubManifestEntry *findUpToDate(llvm::StringRef inputPath) const;
+
+  /// \brief Record an existing entry for \p inputPath.
+  void add(llvm::StringRef inputPath, const StubManifestEntry &entry);
+
+  /// \brief Record the stub that was just written for \p inputPath.
+  void add(llvm::StringRef inputPath, llvm::StringRef outputPath,
+           bool isDynamicLibrary, const std::set<std::string> &dependencies);
+
+private:
+  llvm::MachO::FileType fileType;
+  bool inlinePrivateFrameworks;
+  std::map<std::string, StubManifestEntry> entries;
+};
+
+TAPI_NAMESPACE_INTERNAL_END
+
+#endif // TAPI_DRIVER_STUBMANIFEST_H
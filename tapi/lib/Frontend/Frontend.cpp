@@ -130,7 +130,8 @@ CompilerInvocation *newInvocation(clang::DiagnosticsEngine *diagnostics,
 }
 
 static bool runClang(FrontendContext &context, ArrayRef<std::string> options,
-                     std::unique_ptr<llvm::MemoryBuffer> input) {
+                     std::unique_ptr<llvm::MemoryBuffer> input,
+                     raw_ostream &diagStream) {
   context.compiler = std::make_unique<CompilerInstance>();
   IntrusiveRefCntPtr<DiagnosticIDs> diagID(new DiagnosticIDs());
   IntrusiveRefCntPtr<DiagnosticOptions> diagOpts(new DiagnosticOptions());
@@ -144,7 +145,7 @@ static bool runClang(FrontendContext &context, ArrayRef<std::string> options,
   llvm::opt::InputArgList parsedArgs = opts.ParseArgs(
       ArrayRef<const char *>(argv).slice(1), MissingArgIndex, MissingArgCount);
   ParseDiagnosticArgs(*diagOpts, parsedArgs);
-  TextDiagnosticPrinter diagnosticPrinter(llvm::errs(), &*diagOpts);
+  TextDiagnosticPrinter diagnosticPrinter(diagStream, &*diagOpts);
   clang::DiagnosticsEngine diagnosticsEngine(diagID, &*diagOpts,
                                              &diagnosticPrinter, false);
 
@@ -167,9 +168,9 @@ static bool runClang(FrontendContext &context, ArrayRef<std::string> options,
 
   // Show the invocation, with -v.
   if (invocation->getHeaderSearchOpts().Verbose) {
-    llvm::errs() << "clang Invocation:\n";
-    compilation->getJobs().Print(llvm::errs(), "\n", true);
-    llvm::errs() << "\n";
+    diagStream << "clang Invocation:\n";
+    compilation->getJobs().Print(diagStream, "\n", true);
+    diagStream << "\n";
   }
 
   if (input)
@@ -182,7 +183,8 @@ static bool runClang(FrontendContext &context, ArrayRef<std::string> options,
   auto action = std::make_unique<APIVisitorAction>(context);
 
   // Create the compiler's actual diagnostics engine.
-  context.compiler->createDiagnostics();
+  context.compiler->createDiagnostics(new TextDiagnosticPrinter(
+      diagStream, &context.compiler->getDiagnosticOpts()));
   if (!context.compiler->hasDiagnostics())
     return false;
 
@@ -194,23 +196,20 @@ static bool runClang(FrontendContext &context, ArrayRef<std::string> options,
 
 static std::string getClangExecutablePath() {
   static int staticSymbol;
-  static std::string clangExecutablePath;
-
-  if (!clangExecutablePath.empty())
-    return clangExecutablePath;
-
-  // Try to find clang first in the toolchain. If that fails, then fall-back to
-  // the default search PATH.
-  auto mainExecutable = sys::fs::getMainExecutable("tapi", &staticSymbol);
-  StringRef toolchainBinDir = sys::path::parent_path(mainExecutable);
-  auto clangBinary =
-      sys::findProgramByName("clang", makeArrayRef(toolchainBinDir));
-  if (clangBinary.getError())
-    clangBinary = sys::findProgramByName("clang");
-  if (auto ec = clangBinary.getError())
-    clangExecutablePath = "clang";
-  else
-    clangExecutablePath = clangBinary.get();
+  // Initialized once, even when frontend jobs run concurrently.
+  static const std::string clangExecutablePath = []() -> std::string {
+    // Try to find clang first in the toolchain. If that fails, then fall-back
+    // to the default search PATH.
+    auto mainExecutable = sys::fs::getMainExecutable("tapi", &staticSymbol);
+    StringRef toolchainBinDir = sys::path::parent_path(mainExecutable);
+    auto clangBinary =
+        sys::findProgramByName("clang", makeArrayRef(toolchainBinDir));
+    if (clangBinary.getError())
+      clangBinary = sys::findProgramByName("clang");
+    if (clangBinary.getError())
+      return "clang";
+    return clangBinary.get();
+  }();
 
   return clangExecutablePath;
 }
@@ -451,7 +450,8 @@ extern Expected<FrontendContext> runFrontend(const FrontendJob &job,
     args.emplace_back(arg);
 
   args.emplace_back(inputFilePath);
-  if (runClang(context, args, std::move(input)))
+  auto &diagStream = job.diagnosticStream ? *job.diagnosticStream : errs();
+  if (runClang(context, args, std::move(input), diagStream))
     return context;
 
   // Create a reproducer.
@@ -13,11 +13,12 @@
 
 #include "tapi/SDKDB/BitcodeReader.h"
 #include "SDKDBBitcodeFormat.h"
-
+#include "tapi/Core/APIJSONSerializer.h"
 #include "llvm/Bitcode/BitcodeConvenience.h"
 #include "llvm/Bitstream/BitCodes.h"
 #include "llvm/Bitstream/BitstreamReader.h"
 #include "llvm/Support/EndianStream.h"
+#include "llvm/Support/JSON.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/OnDiskHashTable.h"
 #include "llvm/Support/raw_ostream.h"
@@ -84,6 +85,20 @@ public:
 SDKDBBitcodeMaterializeOption SDKDBBitcodeMaterializeOption::defaultOption =
     SDKDBBitcodeMaterializeOption();
 
+bool SDKDBBitcodeMaterializeOption::shouldParseTarget(Triple &target) const {
+  if (targets.empty())
+    return true;
+
+  return llvm::any_of(targets, [&](const Triple &triple) {
+    return SDKDB::areCompatibleTargets(target, triple);
+  });
+}
+
+bool SDKDBBitcodeMaterializeOption::shouldParseDylib(
+    StringRef installName) const {
+  return installNames.empty() || installNames.count(installName);
+}
+
 class SDKDBBitcodeReader::Implementation {
 public:
   Implementation(MemoryBufferRef input, SDKDBBitcodeMaterializeOption &option,
@@ -91,7 +106,8 @@ public:
 
   const std::vector<Triple> &getAvailableTriples() const { return triples; }
 
-  Error materialize(SDKDBBuilder &builder) const;
+  Error materialize(SDKDBBuilder &builder,
+                    const Triple *onlyTarget = nullptr) const;
 
   std::string getSDKDBVersion() const;
 
@@ -115,6 +131,8 @@ public:
   }
 
 private:
+  friend class SDKDBBitcodeView;
+
   using SerializedLibraryTable =
       OnDiskIterableChainedHashTable<LibraryTableInfo>;
 
@@ -129,8 +147,11 @@ private:
                            BitstreamBlockInfo &info) const;
   Error readControlBlock(BitstreamCursor &cursor);
   Error readIdentificationBlock(BitstreamCursor &cursor) const;
-  Error readSDKDBBlock(BitstreamCursor &cursor, SDKDBBuilder &builder) const;
+  Error readSDKDBBlock(BitstreamCursor &cursor, SDKDBBuilder &builder,
+                       const Triple *onlyTarget) const;
   Expected<API *> readAPIBlock(BitstreamCursor &cursor, SDKDB &sdkdb) const;
+  Expected<bool> readAPIBlock(BitstreamCursor &cursor, API &api,
+                              const StringSet<> &installNames) const;
   Error readGlobalBlock(BitstreamCursor &cursor, API &api) const;
   Error readObjCClassBlock(BitstreamCursor &cursor, API &api) const;
   Error readObjCCategoryBlock(BitstreamCursor &cursor, API &api) const;
@@ -155,6 +176,12 @@ private:
   Error materializeLibraryTable() const;
   Error readLibraryTableBlock(BitstreamCursor &cursor) const;
 
+  // Position a new cursor at a top-level block recorded by validateSDKDB.
+  Error jumpToTopLevelBlock(BitstreamCursor &cursor, uint64_t offset) const;
+
+  // Find the library table for target.
+  SerializedLibraryTable *getLibraryTable(const Triple &target) const;
+
   // Look for offset of the library in the dylibTable.
   Expected<uint64_t> getOffsetForLibrary(Triple &target, StringRef path);
   // Look for offset of the library and taking fallback targets into
@@ -170,12 +197,23 @@ private:
   std::string buildVersion;
   std::vector<std::string> projectWithError;
 
+  // Abbreviations from the BLOCKINFO block, shared by all cursors.
+  mutable BitstreamBlockInfo blockInfo;
+
+  // Bit offsets of the top-level blocks, recorded by validateSDKDB.
+  SmallVector<uint64_t, 4> sdkdbBlockOffsets;
+  SmallVector<uint64_t, 4> libraryTableBlockOffsets;
+
   // stringTable.
   mutable StringRef stringTable;
 
   // lookupTable for dylibs
   mutable StringMap<std::unique_ptr<SerializedLibraryTable>> dylibTable;
 
+  // Library table for each target that was looked up, or null if the SDKDB
+  // has none.
+  mutable StringMap<SerializedLibraryTable *> dylibTableForTarget;
+
   // scatch space.
   mutable SmallVector<uint64_t, 64> scratch;
 };
@@ -211,6 +249,11 @@ Error SDKDBBitcodeReader::materialize(SDKDBBuilder &builder) const {
   return impl.materialize(builder);
 }
 
+Error SDKDBBitcodeReader::materialize(SDKDBBuilder &builder,
+                                      const Triple &target) const {
+  return impl.materialize(builder, &target);
+}
+
 std::string SDKDBBitcodeReader::getSDKDBVersion() const {
   return impl.getSDKDBVersion();
 }
@@ -448,7 +491,6 @@ Error SDKDBBitcodeReader::Implementation::readTripleFromSDKDB(
 
 Error SDKDBBitcodeReader::Implementation::validateSDKDB() {
   BitstreamCursor cursor(input);
-  BitstreamBlockInfo blockInfo;
 
   if (auto err = readSignature(cursor))
     return err;
@@ -477,11 +519,25 @@ Error SDKDBBitcodeReader::Implementation::validateSDKDB() {
     }
 
     case SDKDB_BLOCK_ID: {
+      sdkdbBlockOffsets.push_back(cursor.GetCurrentBitNo());
       if (auto err = readTripleFromSDKDB(cursor))
         return err;
       break;
     }
 
+    case IDENTIFIER_BLOCK_ID: {
+      if (auto err = readIdentificationBlock(cursor))
+        return err;
+      break;
+    }
+
+    case LIBRARY_TABLE_BLOCK_ID: {
+      libraryTableBlockOffsets.push_back(cursor.GetCurrentBitNo());
+      if (auto err = cursor.SkipBlock())
+        return err;
+      break;
+    }
+
     default: { // Skip all the other blocks.
       if (auto err = cursor.SkipBlock())
         return err;
@@ -493,14 +549,31 @@ Error SDKDBBitcodeReader::Implementation::validateSDKDB() {
   return Error::success();
 }
 
+Error SDKDBBitcodeReader::Implementation::jumpToTopLevelBlock(
+    BitstreamCursor &cursor, uint64_t offset) const {
+  cursor.setBlockInfo(&blockInfo);
+  return cursor.JumpToBit(offset);
+}
+
 Expected<API *>
 SDKDBBitcodeReader::Implementation::readAPIBlock(BitstreamCursor &cursor,
                                                  SDKDB &sdkdb) const {
+  API api(sdkdb.getTargetTriple());
+  auto loaded = readAPIBlock(cursor, api, option.installNames);
+  if (!loaded)
+    return loaded.takeError();
+
+  if (!*loaded)
+    return nullptr;
+  return &sdkdb.recordAPI(std::move(api));
+}
+
+Expected<bool> SDKDBBitcodeReader::Implementation::readAPIBlock(
+    BitstreamCursor &cursor, API &api, const StringSet<> &installNames) const {
   if (auto err = cursor.EnterSubBlock(API_BLOCK_ID))
     return std::move(err);
 
-  bool skipBlock = !option.installNames.empty();
-  API api(sdkdb.getTargetTriple());
+  bool skipBlock = !installNames.empty();
   while (true) {
     auto maybeEntry = cursor.advance();
     if (!maybeEntry)
@@ -523,7 +596,7 @@ SDKDBBitcodeReader::Implementation::readAPIBlock(BitstreamCursor &cursor,
         unsigned offset = scratch[0];
         unsigned size = scratch[1];
         if (auto installName = readStringFromTable(offset, size)) {
-          if (option.installNames.count(*installName))
+          if (installNames.count(*installName))
             skipBlock &= false;
           auto name = api.copyString(*installName);
           api.getBinaryInfo().installName = name;
@@ -628,9 +701,7 @@ SDKDBBitcodeReader::Implementation::readAPIBlock(BitstreamCursor &cursor,
       }
     }
     case BitstreamEntry::EndBlock:
-      if (!skipBlock)
-        return &sdkdb.recordAPI(std::move(api));
-      return nullptr;
+      return !skipBlock;
     }
   }
 }
@@ -1511,7 +1582,8 @@ Error SDKDBBitcodeReader::Implementation::readTypedefBlock(
 }
 
 Error SDKDBBitcodeReader::Implementation::readSDKDBBlock(
-    BitstreamCursor &cursor, SDKDBBuilder &builder) const {
+    BitstreamCursor &cursor, SDKDBBuilder &builder,
+    const Triple *onlyTarget) const {
   if (auto err = cursor.EnterSubBlock(SDKDB_BLOCK_ID))
     return err;
 
@@ -1543,10 +1615,12 @@ Error SDKDBBitcodeReader::Implementation::readSDKDBBlock(
       switch (kind) {
       case sdkdb_block::TARGET_TRIPLE: {
         Triple triple(tripleStr);
-        if (option.targets.size() &&
-            llvm::find_if(option.targets, [&](const Triple &target) {
-              return SDKDB::areCompatibleTargets(triple, target);
-            }) == option.targets.end())
+        if (onlyTarget && !SDKDB::areCompatibleTargets(triple, *onlyTarget))
+          skipBlock = true;
+        else if (option.targets.size() &&
+                 llvm::find_if(option.targets, [&](const Triple &target) {
+                   return SDKDB::areCompatibleTargets(triple, target);
+                 }) == option.targets.end())
           skipBlock = true;
         else
           db = &builder.getSDKDBForTarget(triple);
@@ -1581,10 +1655,7 @@ Error SDKDBBitcodeReader::Implementation::readSDKDBBlock(
 }
 
 Error SDKDBBitcodeReader::Implementation::materialize(
-    SDKDBBuilder &builder) const {
-  BitstreamCursor cursor(input);
-  BitstreamBlockInfo blockInfo;
-
+    SDKDBBuilder &builder, const Triple *onlyTarget) const {
   // set build version.
   builder.setBuildVersion(buildVersion);
   builder.setBuilderOptions(builderOpts);
@@ -1593,43 +1664,12 @@ Error SDKDBBitcodeReader::Implementation::materialize(
   for (auto &proj : projectWithError)
     builder.addProjectWithError(proj);
 
-  if (auto err = readSignature(cursor))
-    return err;
-
-  while (!cursor.AtEndOfStream()) {
-    auto maybeTopLevelEntry = cursor.advance();
-    if (!maybeTopLevelEntry)
-      return maybeTopLevelEntry.takeError();
-
-    auto topLevelEntry = maybeTopLevelEntry.get();
-    if (topLevelEntry.Kind != BitstreamEntry::SubBlock)
-      break;
-
-    switch (topLevelEntry.ID) {
-    case bitc::BLOCKINFO_BLOCK_ID: {
-      if (auto err = readBlockInfoBlock(cursor, blockInfo))
-        return err;
-
-      break;
-    }
-
-    case SDKDB_BLOCK_ID: {
-      if (auto err = readSDKDBBlock(cursor, builder))
-        return err;
-      break;
-    }
-    case IDENTIFIER_BLOCK_ID: {
-      if (auto err = readIdentificationBlock(cursor))
-        return err;
-      break;
-    }
-
-    default: { // Skip all the other blocks.
-      if (auto err = cursor.SkipBlock())
-        return err;
-      break;
-    }
-    }
+  BitstreamCursor cursor(input);
+  for (auto offset : sdkdbBlockOffsets) {
+    if (auto err = jumpToTopLevelBlock(cursor, offset))
+      return err;
+    if (auto err = readSDKDBBlock(cursor, builder, onlyTarget))
+      return err;
   }
 
   return Error::success();
@@ -1648,52 +1688,14 @@ SDKDBBitcodeReader::Implementation::dylibExistsForPath(Triple &target,
 
 Error SDKDBBitcodeReader::Implementation::loadAPIsFromSDKDB(
     SDKDBBuilder &builder, Triple &target, StringRef path) {
-  // Create cursor and parse BlockInfo block.
-  BitstreamCursor cursor(input);
-  BitstreamBlockInfo blockInfo;
-  uint64_t sdkdbBlockStart = 0;
-
-  if (auto err = readSignature(cursor))
-    return err;
-
-  while (!cursor.AtEndOfStream()) {
-    auto maybeTopLevelEntry = cursor.advance();
-    if (!maybeTopLevelEntry)
-      return maybeTopLevelEntry.takeError();
-
-    auto topLevelEntry = maybeTopLevelEntry.get();
-    if (topLevelEntry.Kind != BitstreamEntry::SubBlock)
-      break;
-
-    switch (topLevelEntry.ID) {
-    case bitc::BLOCKINFO_BLOCK_ID: {
-      if (auto err = readBlockInfoBlock(cursor, blockInfo))
-        return err;
-
-      break;
-    }
-    case SDKDB_BLOCK_ID: {
-      sdkdbBlockStart = cursor.GetCurrentBitNo();
-      if (auto err = cursor.SkipBlock())
-        return err;
-      break;
-    }
-    case IDENTIFIER_BLOCK_ID: {
-      if (auto err = readIdentificationBlock(cursor))
-        return err;
-      break;
-    }
-    default: { // Skip all the other blocks.
-      if (auto err = cursor.SkipBlock())
-        return err;
-      break;
-    }
-    }
-  }
+  if (sdkdbBlockOffsets.empty())
+    return make_error<StringError>("Dylib not found in SDKDB",
+                                   inconvertibleErrorCode());
 
-  // reset the cursor to the beginning of SDKDB block so we can enter its
-  // context.
-  if (auto err = cursor.JumpToBit(sdkdbBlockStart))
+  // Enter an SDKDB block so the cursor uses its abbreviation width; the API
+  // blocks are then reached through the library table offsets.
+  BitstreamCursor cursor(input);
+  if (auto err = jumpToTopLevelBlock(cursor, sdkdbBlockOffsets.back()))
     return err;
 
   if (auto err = cursor.EnterSubBlock(SDKDB_BLOCK_ID))
@@ -1756,44 +1758,11 @@ Error SDKDBBitcodeReader::Implementation::materializeLibraryTable() const {
     return Error::success();
 
   BitstreamCursor cursor(input);
-  BitstreamBlockInfo blockInfo;
-
-  if (auto err = readSignature(cursor))
-    return err;
-
-  while (!cursor.AtEndOfStream()) {
-    auto maybeTopLevelEntry = cursor.advance();
-    if (!maybeTopLevelEntry)
-      return maybeTopLevelEntry.takeError();
-
-    auto topLevelEntry = maybeTopLevelEntry.get();
-    if (topLevelEntry.Kind != BitstreamEntry::SubBlock)
-      break;
-
-    switch (topLevelEntry.ID) {
-    case bitc::BLOCKINFO_BLOCK_ID: {
-      if (auto err = readBlockInfoBlock(cursor, blockInfo))
-        return err;
-
-      break;
-    }
-    case IDENTIFIER_BLOCK_ID: {
-      if (auto err = readIdentificationBlock(cursor))
-        return err;
-      break;
-    }
-    case LIBRARY_TABLE_BLOCK_ID: {
-      if (auto err = readLibraryTableBlock(cursor))
-        return err;
-      break;
-    }
-
-    default: { // Skip all the other blocks.
-      if (auto err = cursor.SkipBlock())
-        return err;
-      break;
-    }
-    }
+  for (auto offset : libraryTableBlockOffsets) {
+    if (auto err = jumpToTopLevelBlock(cursor, offset))
+      return err;
+    if (auto err = readLibraryTableBlock(cursor))
+      return err;
   }
 
   return Error::success();
@@ -1858,18 +1827,35 @@ SDKDBBitcodeReader::Implementation::getOffsetForLibrary(Triple &target,
   if (auto err = materializeLibraryTable())
     return std::move(err);
 
+  auto *table = getLibraryTable(target);
+  if (!table)
+    return 0;
+
+  auto dylib = table->find(path);
+  if (dylib != table->end())
+    return *dylib;
+
+  return 0;
+}
+
+SDKDBBitcodeReader::Implementation::SerializedLibraryTable *
+SDKDBBitcodeReader::Implementation::getLibraryTable(
+    const Triple &target) const {
+  // Targets are compared as triples, not strings, so remember the result for
+  // each target instead of parsing every table triple on every lookup.
+  auto cached = dylibTableForTarget.try_emplace(target.str(), nullptr);
+  if (!cached.second)
+    return cached.first->getValue();
+
   for (auto &entry : dylibTable) {
     if (target != Triple(entry.getKey()))
       continue;
 
-    auto dylib = entry.getValue()->find(path);
-    if (dylib != entry.getValue()->end())
-      return *dylib;
-
-    return 0;
+    cached.first->getValue() = entry.getValue().get();
+    break;
   }
 
-  return 0;
+  return cached.first->getValue();
 }
 
 Expected<uint64_t>
@@ -1914,4 +1900,375 @@ SDKDBBitcodeReader::Implementation::Implementation(
   err = validateSDKDB();
 }
 
+SDKDBBitcodeView::SDKDBBitcodeView(MemoryBufferRef input, Error &err)
+    : input(input) {
+  ErrorAsOutParameter errorAsOutParameter(&err);
+  auto readerOrErr = SDKDBBitcodeReader::get(
+      input, SDKDBBitcodeMaterializeOption::defaultOption);
+  if (!readerOrErr) {
+    err = readerOrErr.takeError();
+    return;
+  }
+  reader = std::move(*readerOrErr);
+  err = indexAPIBlocks();
+}
+
+SDKDBBitcodeView::~SDKDBBitcodeView() = default;
+
+Expected<std::unique_ptr<SDKDBBitcodeView>>
+SDKDBBitcodeView::get(MemoryBufferRef input) {
+  Error error = Error::success();
+  auto view = std::make_unique<SDKDBBitcodeView>(input, error);
+  if (error)
+    return std::move(error);
+
+  return view;
+}
+
+std::string SDKDBBitcodeView::getSDKDBVersion() const {
+  return reader->getSDKDBVersion();
+}
+
+std::string SDKDBBitcodeView::getBuildVersion() const {
+  return reader->getBuildVersion();
+}
+
+bool SDKDBBitcodeView::isPublicOnly() const { return reader->isPublicOnly(); }
+
+bool SDKDBBitcodeView::noObjCMetadata() const {
+  return reader->noObjCMetadata();
+}
+
+const std::vector<std::string> &
+SDKDBBitcodeView::getProjectsWithError() const {
+  return reader->getProjectsWithError();
+}
+
+Error SDKDBBitcodeView::indexAPIBlocks() {
+  auto &impl = reader->impl;
+  BitstreamCursor cursor(input);
+
+  for (auto offset : impl.sdkdbBlockOffsets) {
+    if (auto err = impl.jumpToTopLevelBlock(cursor, offset))
+      return err;
+    if (auto err = indexSDKDBBlock(cursor))
+      return err;
+  }
+
+  return Error::success();
+}
+
+SDKDBBitcodeView::TargetBlock &
+SDKDBBitcodeView::getTargetBlock(const Triple &triple) {
+  for (auto &block : targetBlocks) {
+    if (SDKDB::areCompatibleTargets(block.target, triple))
+      return block;
+  }
+
+  // Drop the OS version the same way SDKDBBuilder::getSDKDBForTarget does.
+  TargetBlock block;
+  block.target = triple;
+  block.target.setOSName(Triple::getOSTypeName(triple.getOS()));
+  targetBlocks.emplace_back(std::move(block));
+  return targetBlocks.back();
+}
+
+Error SDKDBBitcodeView::indexSDKDBBlock(BitstreamCursor &cursor) {
+  uint64_t sdkdbOffset = cursor.GetCurrentBitNo();
+  if (auto err = cursor.EnterSubBlock(SDKDB_BLOCK_ID))
+    return err;
+
+  TargetBlock *block = nullptr;
+  SmallVector<uint64_t, 4> scratch;
+  while (true) {
+    uint64_t entryStart = cursor.GetCurrentBitNo();
+    auto maybeEntry = cursor.advance();
+    if (!maybeEntry)
+      return maybeEntry.takeError();
+    auto entry = maybeEntry.get();
+
+    switch (entry.Kind) {
+    case BitstreamEntry::Error:
+      return make_error<StringError>("error malformed entry",
+                                     inconvertibleErrorCode());
+    case BitstreamEntry::Record: {
+      scratch.clear();
+      StringRef tripleStr;
+      auto maybeKind = cursor.readRecord(entry.ID, scratch, &tripleStr);
+      if (!maybeKind)
+        return maybeKind.takeError();
+      if (maybeKind.get() == sdkdb_block::TARGET_TRIPLE)
+        block = &getTargetBlock(Triple(tripleStr));
+      continue;
+    }
+    case BitstreamEntry::SubBlock: {
+      if (entry.ID != API_BLOCK_ID) {
+        if (auto err = cursor.SkipBlock())
+          return err;
+        continue;
+      }
+      if (!block)
+        return make_error<StringError>("SDKDB is not started with triple",
+                                       inconvertibleErrorCode());
+      auto api = indexAPIBlock(cursor);
+      if (!api)
+        return api.takeError();
+      api->sdkdbOffset = sdkdbOffset;
+      api->offset = entryStart;
+      block->apis.emplace_back(*api);
+      continue;
+    }
+    case BitstreamEntry::EndBlock:
+      return Error::success();
+    }
+  } // while
+}
+
+Expected<SDKDBBitcodeView::APIBlock>
+SDKDBBitcodeView::indexAPIBlock(BitstreamCursor &cursor) const {
+  if (auto err = cursor.EnterSubBlock(API_BLOCK_ID))
+    return std::move(err);
+
+  auto &impl = reader->impl;
+  APIBlock block;
+  SmallVector<uint64_t, 8> scratch;
+  while (true) {
+    auto maybeEntry = cursor.advance();
+    if (!maybeEntry)
+      return maybeEntry.takeError();
+    auto entry = maybeEntry.get();
+
+    switch (entry.Kind) {
+    case BitstreamEntry::Error:
+      return make_error<StringError>("error malformed entry",
+                                     inconvertibleErrorCode());
+    case BitstreamEntry::Record: {
+      scratch.clear();
+      auto maybeKind = cursor.readRecord(entry.ID, scratch);
+      if (!maybeKind)
+        return maybeKind.takeError();
+      switch (maybeKind.get()) {
+      case api_block::INSTALL_NAME: {
+        auto installName = impl.readStringFromTable(scratch[0], scratch[1]);
+        if (!installName)
+          return installName.takeError();
+        block.installName = *installName;
+        block.hasBinaryInfo = true;
+        continue;
+      }
+      case api_block::FILE_TYPE:
+        block.fileType = (FileType)scratch[0];
+        block.hasBinaryInfo = true;
+        continue;
+      case api_block::FLAGS:
+        block.isTwoLevelNamespace = (bool)scratch[0];
+        block.hasBinaryInfo = true;
+        continue;
+      case api_block::UUID:
+      case api_block::REEXPORTED:
+      case api_block::PARENT_UMBRELLA:
+      case api_block::SWIFT_VERSION:
+        block.hasBinaryInfo = true;
+        continue;
+      case api_block::PROJECT_NAME: {
+        auto project = impl.readStringFromTable(scratch[0], scratch[1]);
+        if (!project)
+          return project.takeError();
+        block.projectName = *project;
+        continue;
+      }
+      default:
+        continue;
+      }
+    }
+    case BitstreamEntry::SubBlock: {
+      switch (entry.ID) {
+      case GLOBAL_BLOCK_ID:
+        ++block.numGlobals;
+        break;
+      case OBJC_CLASS_BLOCK_ID:
+        ++block.numInterfaces;
+        break;
+      case OBJC_PROTOCOL_BLOCK_ID:
+        ++block.numProtocols;
+        break;
+      case ENUM_BLOCK_ID:
+        ++block.numEnums;
+        break;
+      default:
+        break;
+      }
+      if (auto err = cursor.SkipBlock())
+        return std::move(err);
+      continue;
+    }
+    case BitstreamEntry::EndBlock:
+      return block;
+    }
+  }
+}
+
+Error SDKDBBitcodeView::loadAPI(const TargetBlock &target,
+                                const APIBlock &block, API &api) const {
+  BitstreamCursor cursor(input);
+
+  // Enter the SDKDB block first so the cursor uses its abbreviation width.
+  if (auto err = reader->impl.jumpToTopLevelBlock(cursor, block.sdkdbOffset))
+    return err;
+  if (auto err = cursor.EnterSubBlock(SDKDB_BLOCK_ID))
+    return err;
+  if (auto err = cursor.JumpToBit(block.offset))
+    return err;
+
+  auto maybeAPIEntry = cursor.advance();
+  if (!maybeAPIEntry)
+    return maybeAPIEntry.takeError();
+
+  auto apiEntry = maybeAPIEntry.get();
+  if (apiEntry.Kind != BitstreamEntry::SubBlock ||
+      apiEntry.ID != API_BLOCK_ID)
+    return make_error<StringError>("Wrong offset for API block",
+                                   inconvertibleErrorCode());
+
+  auto loaded = reader->impl.readAPIBlock(cursor, api, StringSet<>());
+  if (!loaded)
+    return loaded.takeError();
+  return Error::success();
+}
+
+// Mirrors API::operator< on the information recorded in the block index.
+static bool compareAPIBlocks(const SDKDBBitcodeView::APIBlock *lhs,
+                             const SDKDBBitcodeView::APIBlock *rhs) {
+  if (lhs->hasBinaryInfo != rhs->hasBinaryInfo)
+    return lhs->hasBinaryInfo;
+
+  if (lhs->hasBinaryInfo) {
+    BinaryInfo lhsInfo, rhsInfo;
+    lhsInfo.fileType = lhs->fileType;
+    lhsInfo.installName = lhs->installName;
+    lhsInfo.isTwoLevelNamespace = lhs->isTwoLevelNamespace;
+    rhsInfo.fileType = rhs->fileType;
+    rhsInfo.installName = rhs->installName;
+    rhsInfo.isTwoLevelNamespace = rhs->isTwoLevelNamespace;
+    if (lhsInfo != rhsInfo)
+      return lhsInfo < rhsInfo;
+  }
+
+  if (lhs->numGlobals != rhs->numGlobals)
+    return lhs->numGlobals > rhs->numGlobals;
+  if (lhs->numInterfaces != rhs->numInterfaces)
+    return lhs->numInterfaces > rhs->numInterfaces;
+  if (lhs->numProtocols != rhs->numProtocols)
+    return lhs->numProtocols > rhs->numProtocols;
+  if (lhs->numEnums != rhs->numEnums)
+    return lhs->numEnums > rhs->numEnums;
+  return false;
+}
+
+Error SDKDBBitcodeView::forEachAPI(
+    const TargetBlock &target, const SDKDBBitcodeMaterializeOption &option,
+    function_ref<Error(const API &)> callback) const {
+  // SDKDB groups the APIs by project before sorting them, do the same so the
+  // order matches a materialized SDKDB.
+  std::vector<const APIBlock *> blocks;
+  for (const auto &block : target.apis) {
+    if (!option.shouldParseDylib(block.installName))
+      continue;
+    blocks.emplace_back(&block);
+  }
+  llvm::stable_sort(blocks, [](const APIBlock *lhs, const APIBlock *rhs) {
+    return lhs->projectName < rhs->projectName;
+  });
+  llvm::stable_sort(blocks, compareAPIBlocks);
+
+  for (const auto *block : blocks) {
+    API api(target.target);
+    if (auto err = loadAPI(target, *block, api))
+      return err;
+    if (auto err = callback(api))
+      return err;
+  }
+
+  return Error::success();
+}
+
+// Mirrors the check in SDKDB::recordAPI, which sees the APIs in storage order.
+void SDKDBBitcodeView::reportConflictingInstallNames(
+    const TargetBlock &target, const SDKDBBitcodeMaterializeOption &option,
+    DiagnosticsEngine &diag) const {
+  StringMap<StringRef> installNames;
+  for (const auto &block : target.apis) {
+    if (block.installName.empty() ||
+        !option.shouldParseDylib(block.installName))
+      continue;
+    auto result =
+        installNames.try_emplace(block.installName, block.projectName);
+    if (!result.second)
+      diag.report(diag::warn_sdkdb_conflict_install_name)
+          << block.installName << result.first->getValue()
+          << block.projectName;
+  }
+}
+
+Error SDKDBBitcodeView::serialize(raw_ostream &os, bool compact,
+                                  const SDKDBBitcodeMaterializeOption &option,
+                                  DiagnosticsEngine &diag) const {
+  APIJSONOption serializeOpts = {
+      compact,
+      !(bool)(reader->impl.builderOpts & SDKDBBuilderOptions::hasUUID),
+      /*no target*/ true,
+      /*external only*/ true,
+      isPublicOnly(),
+      /*ignore line and col*/ true,
+  };
+
+  // The root object is printed with sorted keys, like json::Object.
+  std::vector<std::pair<std::string, const TargetBlock *>> keys;
+  for (const auto &block : targetBlocks) {
+    auto triple = block.target;
+    if (!option.shouldParseTarget(triple))
+      continue;
+    keys.emplace_back(block.target.str(), &block);
+    reportConflictingInstallNames(block, option, diag);
+  }
+  if (isPublicOnly())
+    keys.emplace_back("public", nullptr);
+  if (!getProjectsWithError().empty())
+    keys.emplace_back("projectWithError", nullptr);
+  llvm::stable_sort(keys, [](const auto &lhs, const auto &rhs) {
+    return StringRef(lhs.first) < StringRef(rhs.first);
+  });
+
+  Error error = Error::success();
+  json::OStream out(os, compact ? 0 : 2);
+  out.object([&] {
+    for (const auto &key : keys) {
+      if (!key.second) {
+        if (key.first == "public")
+          out.attribute(key.first, true);
+        else
+          out.attributeArray(key.first, [&] {
+            for (const auto &proj : getProjectsWithError())
+              out.value(proj);
+          });
+        continue;
+      }
+      out.attributeArray(key.first, [&] {
+        if (error)
+          return;
+        error = forEachAPI(*key.second, option, [&](const API &api) {
+          if (!api.isEmpty())
+            APIJSONSerializer(api, serializeOpts).serialize(out);
+          return Error::success();
+        });
+      });
+    }
+  });
+  if (error)
+    return error;
+
+  os << "\n";
+  return Error::success();
+}
+
 TAPI_NAMESPACE_INTERNAL_END
@@ -25,6 +25,7 @@
 #include "llvm/Support/EndianStream.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/OnDiskHashTable.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/Path.h"
 
 using namespace llvm;
@@ -79,6 +80,27 @@ public:
 };
 } // end anonymous namespace
 
+namespace {
+/// Library lookup table entry produced while encoding an API block. The
+/// entries are added to the table in order once the final offset of the block
+/// in the output is known.
+struct LibraryIndexEntry {
+  StringRef name;
+  /// Previous install names do not overwrite existing entries.
+  bool isPreviousInstallName;
+};
+
+/// An API block encoded into the buffer of its chunk.
+struct EncodedAPIBlock {
+  /// Byte range of the block in the chunk buffer. Empty if the API is not
+  /// written.
+  size_t begin = 0;
+  size_t end = 0;
+  unsigned chunk = 0;
+  std::vector<LibraryIndexEntry> libraryEntries;
+};
+} // end anonymous namespace
+
 class SDKDBWriter {
 public:
   SDKDBWriter(const SDKDBBuilder &builder);
@@ -88,12 +110,10 @@ public:
 private:
   void addSDKDB(const SDKDB &sdkdb);
 
-  void writeBlockInfoBlock();
+  void encodeAPIBlocks();
   void writeControlBlock();
   void writeIdentifierBlock();
-  void writeSDKDBBlock(const SDKDB &db);
-  void writeAPIBlock(const API& api);
-  void writeBinaryInfoBlock(const BinaryInfo &info);
+  void writeSDKDBBlock(const SDKDB &db, ArrayRef<EncodedAPIBlock> apis);
   void writeLibraryTable();
 
   Optional<StringRef> getShallowFrameworkPath(StringRef installName);
@@ -112,6 +132,12 @@ private:
   /// stringtable.
   BumpPtrAllocator allocator;
 
+  /// API blocks encoded ahead of time, in output order, and the buffers that
+  /// hold them.
+  std::vector<EncodedAPIBlock> encodedAPIs;
+  std::vector<ArrayRef<EncodedAPIBlock>> encodedSDKDBs;
+  std::vector<SmallVector<char, 0>> encodedChunks;
+
   /// Table for building library index. [triple][path] -> index
   Triple currentTriple;
   uint64_t currentAPIStart;
@@ -319,11 +345,11 @@ private:
 //   - docComment
 class APISerializer : public APIVisitor {
 public:
-  APISerializer(BitstreamWriter &writer, StringTableBuilder &table,
-                uint64_t currentAPIStart, StringMap<uint64_t> &libraryIndex,
+  APISerializer(BitstreamWriter &writer, const StringTableBuilder &table,
+                std::vector<LibraryIndexEntry> &libraryEntries,
                 const SDKDBBuilder &builder)
-      : writer(writer), stringBuilder(table), currentAPIStart(currentAPIStart),
-        libraryIndex(libraryIndex), builder(builder) {}
+      : writer(writer), stringBuilder(table), libraryEntries(libraryEntries),
+        builder(builder) {}
 
   void visitGlobal(const GlobalRecord &record) override;
 
@@ -353,9 +379,29 @@ private:
   void writeObjCInstanceVariable(const ObjCInstanceVariableRecord &record);
 
   BitstreamWriter &writer;
-  StringTableBuilder &stringBuilder;
-  uint64_t currentAPIStart;
-  StringMap<uint64_t> &libraryIndex;
+  const StringTableBuilder &stringBuilder;
+  std::vector<LibraryIndexEntry> &libraryEntries;
+  const SDKDBBuilder &builder;
+  /// Scratch space.
+  SmallVector<uint64_t, 64> scratchRecord;
+};
+
+/// Encodes API blocks into a standalone bitstream. Inside an SDKDB block every
+/// API block starts and ends on a word boundary, so the encoded words can be
+/// copied into the final output as they are.
+class APIBlockWriter {
+public:
+  APIBlockWriter(BitstreamWriter &writer, const StringTableBuilder &table,
+                 const SDKDBBuilder &builder)
+      : writer(writer), stringBuilder(table), builder(builder) {}
+
+  void writeAPIBlock(const API &api, EncodedAPIBlock &encoded);
+
+private:
+  void writeBinaryInfoBlock(const BinaryInfo &info, EncodedAPIBlock &encoded);
+
+  BitstreamWriter &writer;
+  const StringTableBuilder &stringBuilder;
   const SDKDBBuilder &builder;
   /// Scratch space.
   SmallVector<uint64_t, 64> scratchRecord;
@@ -363,6 +409,8 @@ private:
 
 } // anonymous namespace
 
+static void writeBlockInfoBlock(BitstreamWriter &writer);
+
 // Add SDKDB to output writer. Record all the strings and calculate the size
 // of the slice.
 void SDKDBWriter::addSDKDB(const SDKDB &sdkdb) {
@@ -409,12 +457,16 @@ void SDKDBWriter::writeToStream(raw_ostream &os) {
   for (unsigned char byte : SDKDB_SIGNATURE)
     writer->Emit(byte, 8);
 
+  // The API blocks only depend on the string table, encode them up front.
+  encodeAPIBlocks();
+
   // Emit the blocks.
-  writeBlockInfoBlock();
+  writeBlockInfoBlock(*writer);
   writeControlBlock();
   writeIdentifierBlock();
-  for (auto *db : builder.getDatabases())
-    writeSDKDBBlock(*db);
+  auto databases = builder.getDatabases();
+  for (unsigned i = 0, e = databases.size(); i < e; ++i)
+    writeSDKDBBlock(*databases[i], encodedSDKDBs[i]);
   writeLibraryTable();
 
   // Write the buffer to the stream.
@@ -511,13 +563,13 @@ static void addProtocolAbbrev(BitstreamWriter &writer, unsigned record,
     llvm_unreachable("Unexpected abbrev ordering!");
 }
 
-void SDKDBWriter::writeBlockInfoBlock() {
-  BCBlockRAII restoreBlock(*writer, bitc::BLOCKINFO_BLOCK_ID,
+static void writeBlockInfoBlock(BitstreamWriter &writer) {
+  BCBlockRAII restoreBlock(writer, bitc::BLOCKINFO_BLOCK_ID,
                            /*abbrevLen=*/2);
 
   SmallVector<unsigned char, 64> nameBuffer;
-#define BLOCK(X) emitBlockID(*writer, X##_ID, #X, nameBuffer)
-#define BLOCK_RECORD(K, X) emitRecordID(*writer, K::X, #X, nameBuffer)
+#define BLOCK(X) emitBlockID(writer, X##_ID, #X, nameBuffer)
+#define BLOCK_RECORD(K, X) emitRecordID(writer, K::X, #X, nameBuffer)
 
   BLOCK(CONTROL_BLOCK);
   BLOCK_RECORD(control_block, METADATA);
@@ -618,7 +670,7 @@ void SDKDBWriter::writeBlockInfoBlock() {
     abbv->Add(BitCodeAbbrevOp(sdkdb_block::TARGET_TRIPLE));
     // Target triple.
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob));
-    if (writer->EmitBlockInfoAbbrev(SDKDB_BLOCK_ID, abbv) !=
+    if (writer.EmitBlockInfoAbbrev(SDKDB_BLOCK_ID, abbv) !=
         SDKDB_TARGET_TRIPLE_ABBREV)
       llvm_unreachable("Unexpected abbrev ordering!");
   }
@@ -629,7 +681,7 @@ void SDKDBWriter::writeBlockInfoBlock() {
     // InstallName string offset and size.
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8));
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));
-    if (writer->EmitBlockInfoAbbrev(API_BLOCK_ID, abbv) !=
+    if (writer.EmitBlockInfoAbbrev(API_BLOCK_ID, abbv) !=
         API_INSTALL_NAME_ABBREV)
       llvm_unreachable("Unexpected abbrev ordering!");
   }
@@ -637,14 +689,14 @@ void SDKDBWriter::writeBlockInfoBlock() {
     auto abbv = std::make_shared<BitCodeAbbrev>();
     abbv->Add(BitCodeAbbrevOp(api_block::FILE_TYPE));
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 4));
-    if (writer->EmitBlockInfoAbbrev(API_BLOCK_ID, abbv) != API_FILE_TYPE_ABBREV)
+    if (writer.EmitBlockInfoAbbrev(API_BLOCK_ID, abbv) != API_FILE_TYPE_ABBREV)
       llvm_unreachable("Unexpected abbrev ordering!");
   }
   { // UUID.
     auto abbv = std::make_shared<BitCodeAbbrev>();
     abbv->Add(BitCodeAbbrevOp(api_block::UUID));
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob));
-    if (writer->EmitBlockInfoAbbrev(API_BLOCK_ID, abbv) != API_UUID_ABBREV)
+    if (writer.EmitBlockInfoAbbrev(API_BLOCK_ID, abbv) != API_UUID_ABBREV)
       llvm_unreachable("Unexpected abbrev ordering!");
   }
   { // Re-exported.
@@ -653,7 +705,7 @@ void SDKDBWriter::writeBlockInfoBlock() {
     // Re-exported library string.
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8));
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));
-    if (writer->EmitBlockInfoAbbrev(API_BLOCK_ID, abbv) !=
+    if (writer.EmitBlockInfoAbbrev(API_BLOCK_ID, abbv) !=
         API_REEXPORTED_ABBREV)
       llvm_unreachable("Unexpected abbrev ordering!");
   }
@@ -663,7 +715,7 @@ void SDKDBWriter::writeBlockInfoBlock() {
     // Library string.
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8));
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));
-    if (writer->EmitBlockInfoAbbrev(API_BLOCK_ID, abbv) !=
+    if (writer.EmitBlockInfoAbbrev(API_BLOCK_ID, abbv) !=
         API_ALLOWABLE_CLIENT_ABBREV)
       llvm_unreachable("Unexpected abbrev ordering!");
   }
@@ -673,7 +725,7 @@ void SDKDBWriter::writeBlockInfoBlock() {
     // Library string.
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8));
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));
-    if (writer->EmitBlockInfoAbbrev(API_BLOCK_ID, abbv) !=
+    if (writer.EmitBlockInfoAbbrev(API_BLOCK_ID, abbv) !=
         API_PARENT_UMBRELLA_ABBREV)
       llvm_unreachable("Unexpected abbrev ordering!");
   }
@@ -684,7 +736,7 @@ void SDKDBWriter::writeBlockInfoBlock() {
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 32));
     // compatibility version.
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 32));
-    if (writer->EmitBlockInfoAbbrev(API_BLOCK_ID, abbv) !=
+    if (writer.EmitBlockInfoAbbrev(API_BLOCK_ID, abbv) !=
         API_DYLIB_VERSION_ABBREV)
       llvm_unreachable("Unexpected abbrev ordering!");
   }
@@ -695,7 +747,7 @@ void SDKDBWriter::writeBlockInfoBlock() {
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 1));
     // Applicate extension safe.
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 1));
-    if (writer->EmitBlockInfoAbbrev(API_BLOCK_ID, abbv) !=
+    if (writer.EmitBlockInfoAbbrev(API_BLOCK_ID, abbv) !=
         API_FLAGS_ABBREV)
       llvm_unreachable("Unexpected abbrev ordering!");
   }
@@ -704,7 +756,7 @@ void SDKDBWriter::writeBlockInfoBlock() {
     abbv->Add(BitCodeAbbrevOp(api_block::SWIFT_VERSION));
     // Swift version.
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 8));
-    if (writer->EmitBlockInfoAbbrev(API_BLOCK_ID, abbv) !=
+    if (writer.EmitBlockInfoAbbrev(API_BLOCK_ID, abbv) !=
         API_SWIFT_VERSION_ABBREV)
       llvm_unreachable("Unexpected abbrev ordering!");
   }
@@ -714,7 +766,7 @@ void SDKDBWriter::writeBlockInfoBlock() {
     // Selector name.
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8));
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));
-    if (writer->EmitBlockInfoAbbrev(API_BLOCK_ID, abbv) !=
+    if (writer.EmitBlockInfoAbbrev(API_BLOCK_ID, abbv) !=
         API_POTENTIALLY_DEFINED_SELECTOR_ABBREV)
       llvm_unreachable("Unexpected abbrev ordering!");
   }
@@ -724,7 +776,7 @@ void SDKDBWriter::writeBlockInfoBlock() {
     // Project name.
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8));
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));
-    if (writer->EmitBlockInfoAbbrev(API_BLOCK_ID, abbv) !=
+    if (writer.EmitBlockInfoAbbrev(API_BLOCK_ID, abbv) !=
         API_PROJECT_NAME_ABBREV)
       llvm_unreachable("Unexpected abbrev ordering!");
   }
@@ -736,15 +788,15 @@ void SDKDBWriter::writeBlockInfoBlock() {
     addAPIRecordAbbrev(abbv.get());
     // GVKind.
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 2));
-    if (writer->EmitBlockInfoAbbrev(GLOBAL_BLOCK_ID, abbv) !=
+    if (writer.EmitBlockInfoAbbrev(GLOBAL_BLOCK_ID, abbv) !=
         GLOBAL_INFO_ABBREV)
       llvm_unreachable("Unexpected abbrev ordering!");
 
-    addAvailabilityAbbrev(*writer, global_block::AVAILABILITY, GLOBAL_BLOCK_ID,
+    addAvailabilityAbbrev(writer, global_block::AVAILABILITY, GLOBAL_BLOCK_ID,
                           GLOBAL_AVAILABILITY_ABBREV);
-    addFileNameAbbrev(*writer, global_block::FILENAME, GLOBAL_BLOCK_ID,
+    addFileNameAbbrev(writer, global_block::FILENAME, GLOBAL_BLOCK_ID,
                       GLOBAL_FILENAME_ABBREV);
-    addLocationAbbrev(*writer, global_block::LOCATION, GLOBAL_BLOCK_ID,
+    addLocationAbbrev(writer, global_block::LOCATION, GLOBAL_BLOCK_ID,
                       GLOBAL_LOCATION_ABBREV);
   }
   // ObjC Class Entry.
@@ -758,16 +810,16 @@ void SDKDBWriter::writeBlockInfoBlock() {
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));
     // Exception attribute.
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 1));
-    if (writer->EmitBlockInfoAbbrev(OBJC_CLASS_BLOCK_ID, abbv) !=
+    if (writer.EmitBlockInfoAbbrev(OBJC_CLASS_BLOCK_ID, abbv) !=
         OBJC_CLASS_INFO_ABBREV)
       llvm_unreachable("Unexpected abbrev ordering!");
-    addAvailabilityAbbrev(*writer, objc_class_block::AVAILABILITY,
+    addAvailabilityAbbrev(writer, objc_class_block::AVAILABILITY,
                           OBJC_CLASS_BLOCK_ID, OBJC_CLASS_AVAILABILITY_ABBREV);
-    addFileNameAbbrev(*writer, objc_class_block::FILENAME, OBJC_CLASS_BLOCK_ID,
+    addFileNameAbbrev(writer, objc_class_block::FILENAME, OBJC_CLASS_BLOCK_ID,
                       OBJC_CLASS_FILENAME_ABBREV);
-    addLocationAbbrev(*writer, objc_class_block::LOCATION, OBJC_CLASS_BLOCK_ID,
+    addLocationAbbrev(writer, objc_class_block::LOCATION, OBJC_CLASS_BLOCK_ID,
                       OBJC_CLASS_LOCATION_ABBREV);
-    addProtocolAbbrev(*writer, objc_class_block::PROTOCOL, OBJC_CLASS_BLOCK_ID,
+    addProtocolAbbrev(writer, objc_class_block::PROTOCOL, OBJC_CLASS_BLOCK_ID,
                       OBJC_CLASS_PROTOCOL_ABBREV);
   }
   // ObjC Category Entry.
@@ -779,17 +831,17 @@ void SDKDBWriter::writeBlockInfoBlock() {
     // Interface Name.
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8));
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));
-    if (writer->EmitBlockInfoAbbrev(OBJC_CATEGORY_BLOCK_ID, abbv) !=
+    if (writer.EmitBlockInfoAbbrev(OBJC_CATEGORY_BLOCK_ID, abbv) !=
         OBJC_CATEGORY_INFO_ABBREV)
       llvm_unreachable("Unexpected abbrev ordering!");
-    addAvailabilityAbbrev(*writer, objc_category_block::AVAILABILITY,
+    addAvailabilityAbbrev(writer, objc_category_block::AVAILABILITY,
                           OBJC_CATEGORY_BLOCK_ID,
                           OBJC_CATEGORY_AVAILABILITY_ABBREV);
-    addFileNameAbbrev(*writer, objc_category_block::FILENAME,
+    addFileNameAbbrev(writer, objc_category_block::FILENAME,
                       OBJC_CATEGORY_BLOCK_ID, OBJC_CATEGORY_FILENAME_ABBREV);
-    addLocationAbbrev(*writer, objc_category_block::LOCATION,
+    addLocationAbbrev(writer, objc_category_block::LOCATION,
                       OBJC_CATEGORY_BLOCK_ID, OBJC_CATEGORY_LOCATION_ABBREV);
-    addProtocolAbbrev(*writer, objc_category_block::PROTOCOL,
+    addProtocolAbbrev(writer, objc_category_block::PROTOCOL,
                       OBJC_CATEGORY_BLOCK_ID, OBJC_CATEGORY_PROTOCOL_ABBREV);
   }
   // ObjC Protocol Entry.
@@ -798,17 +850,17 @@ void SDKDBWriter::writeBlockInfoBlock() {
     auto abbv = std::make_shared<BitCodeAbbrev>();
     abbv->Add(BitCodeAbbrevOp(objc_protocol_block::INFO));
     addAPIRecordAbbrev(abbv.get());
-    if (writer->EmitBlockInfoAbbrev(OBJC_PROTOCOL_BLOCK_ID, abbv) !=
+    if (writer.EmitBlockInfoAbbrev(OBJC_PROTOCOL_BLOCK_ID, abbv) !=
         OBJC_PROTOCOL_INFO_ABBREV)
       llvm_unreachable("Unexpected abbrev ordering!");
-    addAvailabilityAbbrev(*writer, objc_protocol_block::AVAILABILITY,
+    addAvailabilityAbbrev(writer, objc_protocol_block::AVAILABILITY,
                           OBJC_PROTOCOL_BLOCK_ID,
                           OBJC_PROTOCOL_AVAILABILITY_ABBREV);
-    addFileNameAbbrev(*writer, objc_protocol_block::FILENAME,
+    addFileNameAbbrev(writer, objc_protocol_block::FILENAME,
                       OBJC_PROTOCOL_BLOCK_ID, OBJC_PROTOCOL_FILENAME_ABBREV);
-    addLocationAbbrev(*writer, objc_protocol_block::LOCATION,
+    addLocationAbbrev(writer, objc_protocol_block::LOCATION,
                       OBJC_PROTOCOL_BLOCK_ID, OBJC_PROTOCOL_LOCATION_ABBREV);
-    addProtocolAbbrev(*writer, objc_protocol_block::PROTOCOL,
+    addProtocolAbbrev(writer, objc_protocol_block::PROTOCOL,
                       OBJC_PROTOCOL_BLOCK_ID, OBJC_PROTOCOL_PROTOCOL_ABBREV);
   }
   // ObjC Method Entry.
@@ -823,15 +875,15 @@ void SDKDBWriter::writeBlockInfoBlock() {
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 1));
     // dynamic.
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 1));
-    if (writer->EmitBlockInfoAbbrev(OBJC_METHOD_BLOCK_ID, abbv) !=
+    if (writer.EmitBlockInfoAbbrev(OBJC_METHOD_BLOCK_ID, abbv) !=
         OBJC_METHOD_ABBREV)
       llvm_unreachable("Unexpected abbrev ordering!");
-    addAvailabilityAbbrev(*writer, objc_method_block::AVAILABILITY,
+    addAvailabilityAbbrev(writer, objc_method_block::AVAILABILITY,
                           OBJC_METHOD_BLOCK_ID,
                           OBJC_METHOD_AVAILABILITY_ABBREV);
-    addFileNameAbbrev(*writer, objc_method_block::FILENAME,
+    addFileNameAbbrev(writer, objc_method_block::FILENAME,
                       OBJC_METHOD_BLOCK_ID, OBJC_METHOD_FILENAME_ABBREV);
-    addLocationAbbrev(*writer, objc_method_block::LOCATION,
+    addLocationAbbrev(writer, objc_method_block::LOCATION,
                       OBJC_METHOD_BLOCK_ID, OBJC_METHOD_LOCATION_ABBREV);
   }
   // ObjC Property Entry.
@@ -850,15 +902,15 @@ void SDKDBWriter::writeBlockInfoBlock() {
     // setter.
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8));
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));
-    if (writer->EmitBlockInfoAbbrev(OBJC_PROPERTY_BLOCK_ID, abbv) !=
+    if (writer.EmitBlockInfoAbbrev(OBJC_PROPERTY_BLOCK_ID, abbv) !=
         OBJC_PROPERTY_ABBREV)
       llvm_unreachable("Unexpected abbrev ordering!");
-    addAvailabilityAbbrev(*writer, objc_property_block::AVAILABILITY,
+    addAvailabilityAbbrev(writer, objc_property_block::AVAILABILITY,
                           OBJC_PROPERTY_BLOCK_ID,
                           OBJC_PROPERTY_AVAILABILITY_ABBREV);
-    addFileNameAbbrev(*writer, objc_property_block::FILENAME,
+    addFileNameAbbrev(writer, objc_property_block::FILENAME,
                       OBJC_PROPERTY_BLOCK_ID, OBJC_PROPERTY_FILENAME_ABBREV);
-    addLocationAbbrev(*writer, objc_property_block::LOCATION,
+    addLocationAbbrev(writer, objc_property_block::LOCATION,
                       OBJC_PROPERTY_BLOCK_ID, OBJC_PROPERTY_LOCATION_ABBREV);
   }
   // ObjC ivar Entry.
@@ -869,14 +921,14 @@ void SDKDBWriter::writeBlockInfoBlock() {
     addAPIRecordAbbrev(abbv.get());
     // access control.
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 3));
-    if (writer->EmitBlockInfoAbbrev(OBJC_IVAR_BLOCK_ID, abbv) !=
+    if (writer.EmitBlockInfoAbbrev(OBJC_IVAR_BLOCK_ID, abbv) !=
         OBJC_IVAR_ABBREV)
       llvm_unreachable("Unexpected abbrev ordering!");
-    addAvailabilityAbbrev(*writer, objc_ivar_block::AVAILABILITY,
+    addAvailabilityAbbrev(writer, objc_ivar_block::AVAILABILITY,
                           OBJC_IVAR_BLOCK_ID, OBJC_IVAR_AVAILABILITY_ABBREV);
-    addFileNameAbbrev(*writer, objc_ivar_block::FILENAME, OBJC_IVAR_BLOCK_ID,
+    addFileNameAbbrev(writer, objc_ivar_block::FILENAME, OBJC_IVAR_BLOCK_ID,
                       OBJC_IVAR_FILENAME_ABBREV);
-    addLocationAbbrev(*writer, objc_ivar_block::LOCATION, OBJC_IVAR_BLOCK_ID,
+    addLocationAbbrev(writer, objc_ivar_block::LOCATION, OBJC_IVAR_BLOCK_ID,
                       OBJC_IVAR_LOCATION_ABBREV);
   }
   // Library table lookup entry.
@@ -885,7 +937,7 @@ void SDKDBWriter::writeBlockInfoBlock() {
     abbv->Add(BitCodeAbbrevOp(library_table_block::TARGET_TRIPLE));
     // Target triple.
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob));
-    if (writer->EmitBlockInfoAbbrev(LIBRARY_TABLE_BLOCK_ID, abbv) !=
+    if (writer.EmitBlockInfoAbbrev(LIBRARY_TABLE_BLOCK_ID, abbv) !=
         LIBRARY_TABLE_TARGET_TRIPLE_ABBREV)
       llvm_unreachable("Unexpected abbrev ordering!");
   }
@@ -896,7 +948,7 @@ void SDKDBWriter::writeBlockInfoBlock() {
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8));
     // Data
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob));
-    if (writer->EmitBlockInfoAbbrev(LIBRARY_TABLE_BLOCK_ID, abbv) !=
+    if (writer.EmitBlockInfoAbbrev(LIBRARY_TABLE_BLOCK_ID, abbv) !=
         LIBRARY_TABLE_LOOKUP_TABLE_ABBREV)
       llvm_unreachable("Unexpected abbrev ordering!");
   }
@@ -909,14 +961,14 @@ void SDKDBWriter::writeBlockInfoBlock() {
     // USR.
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8));
     abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));
-    if (writer->EmitBlockInfoAbbrev(ENUM_BLOCK_ID, abbv) != ENUM_INFO_ABBREV)
+    if (writer.EmitBlockInfoAbbrev(ENUM_BLOCK_ID, abbv) != ENUM_INFO_ABBREV)
       llvm_unreachable("Unexpected abbrev ordering!");
 
-    addAvailabilityAbbrev(*writer, enum_block::AVAILABILITY, ENUM_BLOCK_ID,
+    addAvailabilityAbbrev(writer, enum_block::AVAILABILITY, ENUM_BLOCK_ID,
                           ENUM_AVAILABILITY_ABBREV);
-    addFileNameAbbrev(*writer, enum_block::FILENAME, ENUM_BLOCK_ID,
+    addFileNameAbbrev(writer, enum_block::FILENAME, ENUM_BLOCK_ID,
                       ENUM_FILENAME_ABBREV);
-    addLocationAbbrev(*writer, enum_block::LOCATION, ENUM_BLOCK_ID,
+    addLocationAbbrev(writer, enum_block::LOCATION, ENUM_BLOCK_ID,
                       ENUM_LOCATION_ABBREV);
   }
   // Enum Constant Entry.
@@ -925,16 +977,16 @@ void SDKDBWriter::writeBlockInfoBlock() {
     auto abbv = std::make_shared<BitCodeAbbrev>();
     abbv->Add(BitCodeAbbrevOp(enum_constant_block::INFO));
     addAPIRecordAbbrev(abbv.get());
-    if (writer->EmitBlockInfoAbbrev(ENUM_CONSTANT_BLOCK_ID, abbv) !=
+    if (writer.EmitBlockInfoAbbrev(ENUM_CONSTANT_BLOCK_ID, abbv) !=
         ENUM_CONSTANT_INFO_ABBREV)
       llvm_unreachable("Unexpected abbrev ordering!");
 
-    addAvailabilityAbbrev(*writer, enum_constant_block::AVAILABILITY,
+    addAvailabilityAbbrev(writer, enum_constant_block::AVAILABILITY,
                           ENUM_CONSTANT_BLOCK_ID,
                           ENUM_CONSTANT_AVAILABILITY_ABBREV);
-    addFileNameAbbrev(*writer, enum_constant_block::FILENAME,
+    addFileNameAbbrev(writer, enum_constant_block::FILENAME,
                       ENUM_CONSTANT_BLOCK_ID, ENUM_CONSTANT_FILENAME_ABBREV);
-    addLocationAbbrev(*writer, enum_constant_block::LOCATION,
+    addLocationAbbrev(writer, enum_constant_block::LOCATION,
                       ENUM_CONSTANT_BLOCK_ID, ENUM_CONSTANT_LOCATION_ABBREV);
   }
   // typedef Entry.
@@ -943,15 +995,15 @@ void SDKDBWriter::writeBlockInfoBlock() {
     auto abbv = std::make_shared<BitCodeAbbrev>();
     abbv->Add(BitCodeAbbrevOp(typedef_block::INFO));
     addAPIRecordAbbrev(abbv.get());
-    if (writer->EmitBlockInfoAbbrev(TYPEDEF_BLOCK_ID, abbv) !=
+    if (writer.EmitBlockInfoAbbrev(TYPEDEF_BLOCK_ID, abbv) !=
         TYPEDEF_INFO_ABBREV)
       llvm_unreachable("Unexpected abbrev ordering!");
 
-    addAvailabilityAbbrev(*writer, typedef_block::AVAILABILITY,
+    addAvailabilityAbbrev(writer, typedef_block::AVAILABILITY,
                           TYPEDEF_BLOCK_ID, TYPEDEF_AVAILABILITY_ABBREV);
-    addFileNameAbbrev(*writer, typedef_block::FILENAME, TYPEDEF_BLOCK_ID,
+    addFileNameAbbrev(writer, typedef_block::FILENAME, TYPEDEF_BLOCK_ID,
                       TYPEDEF_FILENAME_ABBREV);
-    addLocationAbbrev(*writer, typedef_block::LOCATION, TYPEDEF_BLOCK_ID,
+    addLocationAbbrev(writer, typedef_block::LOCATION, TYPEDEF_BLOCK_ID,
                       TYPEDEF_LOCATION_ABBREV);
   }
 }
@@ -1018,19 +1070,90 @@ void SDKDBWriter::writeIdentifierBlock() {
                              stringBuffer);
 }
 
-void SDKDBWriter::writeSDKDBBlock(const SDKDB &db) {
+void SDKDBWriter::encodeAPIBlocks() {
+  std::vector<const API *> apis;
+  std::vector<size_t> sdkdbEnds;
+  for (auto *db : builder.getDatabases()) {
+    for (auto *api : db->api())
+      apis.emplace_back(api);
+    sdkdbEnds.emplace_back(apis.size());
+  }
+  encodedAPIs.resize(apis.size());
+  size_t sdkdbBegin = 0;
+  for (auto end : sdkdbEnds) {
+    encodedSDKDBs.emplace_back(
+        ArrayRef<EncodedAPIBlock>(encodedAPIs).slice(sdkdbBegin,
+                                                     end - sdkdbBegin));
+    sdkdbBegin = end;
+  }
+
+  // Split the APIs into a few chunks per thread, each chunk gets its own
+  // bitstream so the chunks can be encoded independently.
+  size_t numChunks = std::min<size_t>(
+      apis.size(), parallel::strategy.compute_thread_count() * 4);
+  encodedChunks.resize(numChunks);
+  parallelFor(0, numChunks, [&](size_t chunk) {
+    size_t begin = apis.size() * chunk / numChunks;
+    size_t end = apis.size() * (chunk + 1) / numChunks;
+
+    BitstreamWriter chunkWriter(encodedChunks[chunk]);
+    writeBlockInfoBlock(chunkWriter);
+    // API blocks are nested inside an SDKDB block, enter one to use the same
+    // abbrev width.
+    chunkWriter.EnterSubblock(SDKDB_BLOCK_ID, /*CodeLen=*/3);
+    APIBlockWriter apiWriter(chunkWriter, stringBuilder, builder);
+    // Blocks start and end word aligned, so the blocks can be copied byte
+    // by byte.
+    for (size_t i = begin; i < end; ++i) {
+      auto &encoded = encodedAPIs[i];
+      encoded.chunk = chunk;
+      assert(chunkWriter.GetCurrentBitNo() % 32 == 0 && "unaligned API block");
+      encoded.begin = chunkWriter.GetCurrentBitNo() / 8;
+      apiWriter.writeAPIBlock(*apis[i], encoded);
+      encoded.end = chunkWriter.GetCurrentBitNo() / 8;
+    }
+    chunkWriter.ExitBlock();
+  });
+}
+
+void SDKDBWriter::writeSDKDBBlock(const SDKDB &db,
+                                  ArrayRef<EncodedAPIBlock> apis) {
   BCBlockRAII restoreBlock(*writer, SDKDB_BLOCK_ID, /*abbrevLen=*/3);
   scratchRecord = {sdkdb_block::TARGET_TRIPLE};
   writer->EmitRecordWithBlob(SDKDB_TARGET_TRIPLE_ABBREV, scratchRecord,
                              db.getTargetTriple().str());
   currentTriple = db.getTargetTriple();
-  for (auto *api : db.api()) {
+  for (const auto &encoded : apis) {
     currentAPIStart = writer->GetCurrentBitNo();
-    writeAPIBlock(*api);
+    if (encoded.begin == encoded.end)
+      continue;
+
+    auto &index = libraryIndex[currentTriple.str()];
+    for (const auto &entry : encoded.libraryEntries) {
+      // Using try_emplace here to not overwriting any value if already exists.
+      if (entry.isPreviousInstallName) {
+        index.try_emplace(entry.name, currentAPIStart);
+        continue;
+      }
+      index[entry.name] = currentAPIStart;
+      // If there is a shallow framework path for the framework, add to table.
+      if (auto shallowName = getShallowFrameworkPath(entry.name))
+        index[*shallowName] = currentAPIStart;
+      auto symlink = symlinkMap.find(entry.name);
+      if (symlink != symlinkMap.end())
+        index[symlink->second] = currentAPIStart;
+    }
+
+    // The block is word aligned, so it can be copied without size or padding.
+    const auto &chunk = encodedChunks[encoded.chunk];
+    writer->emitBlob(
+        StringRef(chunk.data() + encoded.begin, encoded.end - encoded.begin),
+        /*ShouldEmitSize=*/false);
   }
 }
 
-void SDKDBWriter::writeAPIBlock(const API& api) {
+void APIBlockWriter::writeAPIBlock(const API &api,
+                                   EncodedAPIBlock &encoded) {
   if (api.isEmpty())
     return;
 
@@ -1038,12 +1161,12 @@ void SDKDBWriter::writeAPIBlock(const API& api) {
       api.getBinaryInfo().fileType == FileType::MachO_Bundle)
     return;
 
-  BCBlockRAII restoreBlock(*writer, API_BLOCK_ID, /*abbrevLen=*/5);
+  BCBlockRAII restoreBlock(writer, API_BLOCK_ID, /*abbrevLen=*/5);
   if (api.hasBinaryInfo())
-    writeBinaryInfoBlock(api.getBinaryInfo());
+    writeBinaryInfoBlock(api.getBinaryInfo(), encoded);
 
-  APISerializer serializer(*writer, stringBuilder, currentAPIStart,
-                           libraryIndex[currentTriple.str()], builder);
+  APISerializer serializer(writer, stringBuilder, encoded.libraryEntries,
+                           builder);
   api.visit(serializer);
 
   // potentially defined selectors.
@@ -1051,7 +1174,7 @@ void SDKDBWriter::writeAPIBlock(const API& api) {
     unsigned nameOffset = stringBuilder.getOffset(selector.first());
     scratchRecord = {api_block::POTENTIALLY_DEFINED_SELECTOR, nameOffset,
                      selector.first().size()};
-    writer->EmitRecordWithAbbrev(API_POTENTIALLY_DEFINED_SELECTOR_ABBREV,
+    writer.EmitRecordWithAbbrev(API_POTENTIALLY_DEFINED_SELECTOR_ABBREV,
                                  scratchRecord);
   }
 
@@ -1059,65 +1182,61 @@ void SDKDBWriter::writeAPIBlock(const API& api) {
   if (!project.empty()) {
     unsigned nameOffset = stringBuilder.getOffset(project);
     scratchRecord = {api_block::PROJECT_NAME, nameOffset, project.size()};
-    writer->EmitRecordWithAbbrev(API_PROJECT_NAME_ABBREV, scratchRecord);
+    writer.EmitRecordWithAbbrev(API_PROJECT_NAME_ABBREV, scratchRecord);
   }
 }
 
-void SDKDBWriter::writeBinaryInfoBlock(const BinaryInfo &info) {
+void APIBlockWriter::writeBinaryInfoBlock(const BinaryInfo &info,
+                                          EncodedAPIBlock &encoded) {
   auto installName = info.installName;
   if (!installName.empty()) {
     // Insert library path into table.
-    libraryIndex[currentTriple.str()][installName] = currentAPIStart;
-    // If there is a shallow framework path for the framework, add to table.
-    if (auto shallowName = getShallowFrameworkPath(installName))
-      libraryIndex[currentTriple.str()][*shallowName] = currentAPIStart;
-    auto symlink = symlinkMap.find(installName);
-    if (symlink != symlinkMap.end())
-      libraryIndex[currentTriple.str()][symlink->second] = currentAPIStart;
+    encoded.libraryEntries.push_back({installName,
+                                      /*isPreviousInstallName=*/false});
     unsigned installNameOffset = stringBuilder.getOffset(installName);
     scratchRecord = {api_block::INSTALL_NAME, installNameOffset,
                      installName.size()};
-    writer->EmitRecordWithAbbrev(API_INSTALL_NAME_ABBREV, scratchRecord);
+    writer.EmitRecordWithAbbrev(API_INSTALL_NAME_ABBREV, scratchRecord);
   }
 
   if (info.fileType != FileType::Invalid) {
     scratchRecord = {api_block::FILE_TYPE, (unsigned)info.fileType};
-    writer->EmitRecordWithAbbrev(API_FILE_TYPE_ABBREV, scratchRecord);
+    writer.EmitRecordWithAbbrev(API_FILE_TYPE_ABBREV, scratchRecord);
   }
 
   if (builder.hasUUID() && !info.uuid.empty()) {
     scratchRecord = {api_block::UUID};
-    writer->EmitRecordWithBlob(API_UUID_ABBREV, scratchRecord, info.uuid);
+    writer.EmitRecordWithBlob(API_UUID_ABBREV, scratchRecord, info.uuid);
   }
 
   for (auto reexport: info.reexportedLibraries) {
     unsigned nameOffset = stringBuilder.getOffset(reexport);
     scratchRecord = {api_block::REEXPORTED, nameOffset, reexport.size()};
-    writer->EmitRecordWithAbbrev(API_REEXPORTED_ABBREV, scratchRecord);
+    writer.EmitRecordWithAbbrev(API_REEXPORTED_ABBREV, scratchRecord);
   }
 
   if (!info.parentUmbrella.empty()) {
     unsigned nameOffset = stringBuilder.getOffset(info.parentUmbrella);
     scratchRecord = {api_block::PARENT_UMBRELLA, nameOffset,
                      info.parentUmbrella.size()};
-    writer->EmitRecordWithAbbrev(API_PARENT_UMBRELLA_ABBREV, scratchRecord);
+    writer.EmitRecordWithAbbrev(API_PARENT_UMBRELLA_ABBREV, scratchRecord);
   }
 
   if (info.currentVersion.rawValue() || info.compatibilityVersion.rawValue()) {
     scratchRecord = {api_block::DYLIB_VERSION, info.currentVersion.rawValue(),
                      info.compatibilityVersion.rawValue()};
-    writer->EmitRecordWithAbbrev(API_DYLIB_VERSION_ABBREV, scratchRecord);
+    writer.EmitRecordWithAbbrev(API_DYLIB_VERSION_ABBREV, scratchRecord);
   }
 
   if (info.isTwoLevelNamespace || info.isAppExtensionSafe) {
     scratchRecord = {api_block::FLAGS, info.isTwoLevelNamespace,
                      info.isAppExtensionSafe};
-    writer->EmitRecordWithAbbrev(API_FLAGS_ABBREV, scratchRecord);
+    writer.EmitRecordWithAbbrev(API_FLAGS_ABBREV, scratchRecord);
   }
 
   if (info.swiftABIVersion) {
     scratchRecord = {api_block::SWIFT_VERSION, info.swiftABIVersion};
-    writer->EmitRecordWithAbbrev(API_SWIFT_VERSION_ABBREV, scratchRecord);
+    writer.EmitRecordWithAbbrev(API_SWIFT_VERSION_ABBREV, scratchRecord);
   }
 }
 
@@ -1186,9 +1305,8 @@ void APISerializer::visitGlobal(const GlobalRecord &record) {
   writeLocationBlock(record.loc, global_block::FILENAME, GLOBAL_FILENAME_ABBREV,
                      global_block::LOCATION, GLOBAL_LOCATION_ABBREV);
   // Add previous installName into lookup table.
-  // Using try_emplace here to not overwriting any value if already exists.
   if (auto name = getPreviousInstallName(record.name))
-    libraryIndex.try_emplace(*name, currentAPIStart);
+    libraryEntries.push_back({*name, /*isPreviousInstallName=*/true});
 }
 
 void APISerializer::visitObjCInterface(const ObjCInterfaceRecord &record) {
@@ -138,10 +138,8 @@ Error PartialSDKDB::serialize(
     const std::vector<FrontendContext> &privateHeaderContext,
     const std::vector<API> &privateHeaderAPIs, bool hasErrors,
     bool useCompatFormat) {
-  // Write partial SDKDB.
-  json::Object root;
-  // Runtime Root.
-  json::Array binaryInterfacesList;
+  // Write partial SDKDB. The keys are written in sorted order, like
+  // json::Object is printed.
   APIJSONOption options{
       /*compact*/ false,
       /*noUUID*/ true,
@@ -150,45 +148,37 @@ Error PartialSDKDB::serialize(
       /*publicOnly*/ false,
       /*ignore line and col*/ true,
   };
-  for (const auto &api : binaryInterfaces) {
-    APIJSONSerializer serializer(api, options);
-    binaryInterfacesList.emplace_back(serializer.getJSONObject());
-  }
-  root["RuntimeRoot"] = std::move(binaryInterfacesList);
-  // SDKContentRoot Root.
-  json::Array internalSDKInterfacesList;
-  for (const auto &result : privateHeaderContext) {
-    APIJSONSerializer serializer(*result.api, options);
-    internalSDKInterfacesList.emplace_back(serializer.getJSONObject());
-  }
-  for (const auto &api : privateHeaderAPIs) {
-    APIJSONSerializer serializer(api, options);
-    internalSDKInterfacesList.emplace_back(serializer.getJSONObject());
-  }
-  root["SDKContentRoot"] = std::move(internalSDKInterfacesList);
-  // PublicSDKContentRoot Root.
-  json::Array publicSDKInterfacesList;
-  for (const auto &result : publicHeaderContext) {
-    APIJSONSerializer serializer(*result.api, options);
-    publicSDKInterfacesList.emplace_back(serializer.getJSONObject());
-  }
-  for (const auto &api : publicHeaderAPIs) {
-    APIJSONSerializer serializer(api, options);
-    publicSDKInterfacesList.emplace_back(serializer.getJSONObject());
-  }
-  root["PublicSDKContentRoot"] = std::move(publicSDKInterfacesList);
-
-  root["version"] = PartialSDKDB::version;
-  if (hasErrors)
-    root["error"] = true;
-
-  if (!project.empty())
-    root["projectName"] = project;
-
-  if (useCompatFormat)
-    os << formatv("{0}", json::Value(std::move(root))) << "\n";
-  else
-    os << formatv("{0:2}", json::Value(std::move(root))) << "\n";
+  json::OStream out(os, useCompatFormat ? 0 : 2);
+  out.object([&] {
+    // PublicSDKContentRoot Root.
+    out.attributeArray("PublicSDKContentRoot", [&] {
+      for (const auto &result : publicHeaderContext)
+        APIJSONSerializer(*result.api, options).serialize(out);
+      for (const auto &api : publicHeaderAPIs)
+        APIJSONSerializer(api, options).serialize(out);
+    });
+    // Runtime Root.
+    out.attributeArray("RuntimeRoot", [&] {
+      for (const auto &api : binaryInterfaces)
+        APIJSONSerializer(api, options).serialize(out);
+    });
+    // SDKContentRoot Root.
+    out.attributeArray("SDKContentRoot", [&] {
+      for (const auto &result : privateHeaderContext)
+        APIJSONSerializer(*result.api, options).serialize(out);
+      for (const auto &api : privateHeaderAPIs)
+        APIJSONSerializer(api, options).serialize(out);
+    });
+
+    if (hasErrors)
+      out.attribute("error", true);
+
+    if (!project.empty())
+      out.attribute("projectName", project);
+
+    out.attribute("version", PartialSDKDB::version);
+  });
+  os << "\n";
 
   return Error::success();
 }
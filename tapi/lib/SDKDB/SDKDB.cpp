@@ -12,10 +12,12 @@
 //===----------------------------------------------------------------------===//
 
 #include "tapi/SDKDB/SDKDB.h"
+#include "tapi/SDKDB/BitcodeReader.h"
 #include "tapi/SDKDB/CompareConfigFileReader.h"
 
 #include "tapi/Core/APIJSONSerializer.h"
 #include "tapi/Core/APIVisitor.h"
+#include "tapi/Core/JSONStreamReader.h"
 #include "tapi/Core/Utils.h"
 #include "tapi/Diagnostics/Diagnostics.h"
 #include "llvm/ADT/STLExtras.h"
@@ -1075,29 +1077,55 @@ Error SDKDBBuilder::finalize() {
 }
 
 llvm::Error SDKDBBuilder::parse(StringRef JSON) {
-  auto inputValue = json::parse(JSON);
-  if (!inputValue)
-    return inputValue.takeError();
-
-  auto *root = inputValue->getAsObject();
-  if (!root)
+  // Walk the SDKDB without building it in memory and parse one API at a time.
+  JSONStreamReader reader(JSON);
+  auto token = reader.next();
+  if (!token)
+    return token.takeError();
+  if (*token != JSONStreamReader::Token::ObjectBegin) {
+    // Report malformed input before the unexpected type, like json::parse.
+    if (auto err = reader.skipValue())
+      return err;
+    token = reader.next();
+    if (!token)
+      return token.takeError();
     return make_error<APIJSONError>("SDKDB is not a JSON Object");
+  }
+
+  while (true) {
+    token = reader.next();
+    if (!token)
+      return token.takeError();
+    if (*token == JSONStreamReader::Token::ObjectEnd)
+      break;
 
-  for (auto &target : *root) {
-    const StringRef key = target.first;
-    if (key == "public")
+    const std::string key = reader.getValue().str();
+    token = reader.next();
+    if (!token)
+      return token.takeError();
+    if (key == "public") {
+      if (auto err = reader.skipValue())
+        return err;
       continue;
+    }
     auto triple = Triple(key);
-    auto payload = target.second.getAsArray();
-    if (!payload)
+    if (*token != JSONStreamReader::Token::ArrayBegin)
       return make_error<APIJSONError>("Target Payload is not a JSON Array");
 
-    for (auto &value : *payload) {
-      auto obj = value.getAsObject();
-      if (!obj)
+    while (true) {
+      token = reader.next();
+      if (!token)
+        return token.takeError();
+      if (*token == JSONStreamReader::Token::ArrayEnd)
+        break;
+      if (*token != JSONStreamReader::Token::ObjectBegin)
         return make_error<APIJSONError>(
             "SDKDB doesn't include correct API format");
-      auto api = APIJSONSerializer::parse(obj, isPublicOnly(), &triple);
+
+      auto text = reader.readRawValue();
+      if (!text)
+        return text.takeError();
+      auto api = APIJSONSerializer::parseObject(*text, isPublicOnly(), &triple);
       if (!api)
         return api.takeError();
 
@@ -1106,6 +1134,9 @@ llvm::Error SDKDBBuilder::parse(StringRef JSON) {
     }
   }
 
+  token = reader.next();
+  if (!token)
+    return token.takeError();
   return Error::success();
 }
 
@@ -1129,7 +1160,6 @@ std::vector<const SDKDB*> SDKDBBuilder::getDatabases() const {
 }
 
 void SDKDBBuilder::serialize(raw_ostream &os, bool compact) const {
-  json::Object root;
   APIJSONOption serializeOpts = {
       compact,
       !hasUUID(),
@@ -1138,30 +1168,42 @@ void SDKDBBuilder::serialize(raw_ostream &os, bool compact) const {
       isPublicOnly(),
       /*ignore line and col*/ true,
   };
-  for (auto *entry : getDatabases()) {
-    auto target = entry->getTargetTriple();
-    json::Array apiList;
-    for (auto *api : entry->api()) {
-      if (api->isEmpty())
-        continue;
-      APIJSONSerializer serializer(*api, serializeOpts);
-      apiList.emplace_back(serializer.getJSONObject());
-    }
-    root[target.str()] = std::move(apiList);
-  }
-  if (isPublicOnly())
-    root["public"] = true;
 
-  json::Array projects;
-  for (auto &proj : projectWithError)
-    projects.push_back(proj);
-  if (!projects.empty())
-    root["projectWithError"] = std::move(projects);
+  // The root object is printed with sorted keys, like json::Object.
+  std::vector<std::pair<std::string, const SDKDB *>> keys;
+  for (auto *entry : getDatabases())
+    keys.emplace_back(entry->getTargetTriple().str(), entry);
+  if (isPublicOnly())
+    keys.emplace_back("public", nullptr);
+  if (!projectWithError.empty())
+    keys.emplace_back("projectWithError", nullptr);
+  llvm::stable_sort(keys, [](const auto &lhs, const auto &rhs) {
+    return StringRef(lhs.first) < StringRef(rhs.first);
+  });
 
-  if (compact)
-    os << formatv("{0}", json::Value(std::move(root))) << "\n";
-  else
-    os << formatv("{0:2}", json::Value(std::move(root))) << "\n";
+  json::OStream out(os, compact ? 0 : 2);
+  out.object([&] {
+    for (const auto &key : keys) {
+      if (!key.second) {
+        if (key.first == "public")
+          out.attribute(key.first, true);
+        else
+          out.attributeArray(key.first, [&] {
+            for (auto &proj : projectWithError)
+              out.value(proj);
+          });
+        continue;
+      }
+      out.attributeArray(key.first, [&] {
+        for (auto *api : key.second->api()) {
+          if (api->isEmpty())
+            continue;
+          APIJSONSerializer(*api, serializeOpts).serialize(out);
+        }
+      });
+    }
+  });
+  os << "\n";
 }
 
 template <typename LookupMapTy>
@@ -1948,23 +1990,162 @@ bool SDKDBBuilder::diagnoseDifferences(SDKDBBuilder &baseline) {
 
   assert(!diag.hasErrorOccurred() && "no error should occured");
   // Compare the SDKDBs by lookup table.
-  for (const auto &base : baseline.databases) {
-    // Check to see if the target exists.
-    auto *db = llvm::find_if(databases, [&](const SDKDB &db) {
-      return SDKDB::areCompatibleTargets(db.triple, base.triple);
-    });
-    if (db == databases.end()) {
-      report(diag::err_sdkdb_missing_target) << base.triple.str();
-      continue;
+  for (const auto &base : baseline.databases)
+    diagnoseDifferences(base, compareConfigFileReader.get());
+
+  return !diag.hasErrorOccurred();
+}
+
+void SDKDBBuilder::diagnoseDifferences(
+    const SDKDB &base, const CompareConfigFileReader *configReader) {
+  // Check to see if the target exists.
+  auto *db = llvm::find_if(databases, [&](const SDKDB &db) {
+    return SDKDB::areCompatibleTargets(db.triple, base.triple);
+  });
+  if (db == databases.end()) {
+    report(diag::err_sdkdb_missing_target) << base.triple.str();
+    return;
+  }
+
+  if (configReader)
+    db->expectedChanges = &configReader->getExpectedChanges(db->triple);
+
+  db->diagnoseDifferences(base);
+}
+
+Expected<bool>
+SDKDBBuilder::diagnoseDifferences(const SDKDBBitcodeReader &test,
+                                  const SDKDBBitcodeReader &baseline,
+                                  bool &baselineFailed) {
+  assert(!diag.hasErrorOccurred() && "no error should occured");
+  baselineFailed = false;
+
+  // The lookup tables of a target only depend on the APIs of that target, so
+  // the targets can be loaded and compared one after another. The diagnostics
+  // of each step are buffered and emitted at the end in the order of
+  // materializing both SDKDBs and calling diagnoseDifferences(): the warnings
+  // from reading the test SDKDB and the baseline, then the ones from building
+  // the lookup tables of the baseline and the test SDKDB, then the
+  // differences.
+  using Diagnostics = std::vector<clang::StoredDiagnostic>;
+  struct TargetDiagnostics {
+    Diagnostics materialize;
+    Diagnostics lookupTables;
+  };
+  const auto &testTargets = test.getAvailableTriples();
+  const auto &baselineTargets = baseline.getAvailableTriples();
+  std::vector<TargetDiagnostics> testDiags(testTargets.size());
+  std::vector<TargetDiagnostics> baselineDiags(baselineTargets.size());
+  std::vector<Diagnostics> differences(baselineTargets.size());
+  std::vector<bool> testRead(testTargets.size());
+
+  auto buffered = [&](Diagnostics &buffer, function_ref<void()> callback) {
+    diag.startBuffering(buffer);
+    callback();
+    diag.stopBuffering();
+  };
+  // The comparison options, like reporting warnings as errors, don't apply to
+  // reading the SDKDBs.
+  auto materialize = [&](Diagnostics &buffer, const SDKDBBitcodeReader &reader,
+                         SDKDBBuilder &builder, const Triple &target) {
+    bool warningsAsErrors = diag.getWarningsAsErrors();
+    diag.setWarningsAsErrors(false);
+    diag.startBuffering(buffer);
+    auto err = reader.materialize(builder, target);
+    diag.stopBuffering();
+    diag.setWarningsAsErrors(warningsAsErrors);
+    return err;
+  };
+  auto readTest = [&](size_t index, SDKDBBuilder &builder) {
+    testRead[index] = true;
+    return materialize(testDiags[index].materialize, test, builder,
+                       testTargets[index]);
+  };
+
+  Error testErr = Error::success();
+  Error baselineErr = Error::success();
+  auto setError = [](Error &target, Error err) {
+    consumeError(std::move(target));
+    target = std::move(err);
+  };
+  size_t testErrIndex = testTargets.size();
+  for (size_t i = 0, e = baselineTargets.size(); i != e; ++i) {
+    SDKDBBuilder base(diag);
+    if (auto err = materialize(baselineDiags[i].materialize, baseline, base,
+                               baselineTargets[i])) {
+      setError(baselineErr, std::move(err));
+      break;
     }
+    // The target is filtered out by the materialize option.
+    if (base.databases.empty())
+      continue;
 
-    if (compareConfigFileReader)
-      db->expectedChanges =
-          &compareConfigFileReader->getExpectedChanges(db->triple);
+    SDKDBBuilder current(diag);
+    auto testTarget = llvm::find_if(testTargets, [&](const Triple &target) {
+      return SDKDB::areCompatibleTargets(target, baselineTargets[i]);
+    });
+    size_t testIndex = testTarget - testTargets.begin();
+    if (testTarget != testTargets.end()) {
+      if (auto err = readTest(testIndex, current)) {
+        setError(testErr, std::move(err));
+        testErrIndex = testIndex;
+        break;
+      }
+    }
+    current.setDiagnoseFrontendAPI(shouldDiagnoseFrontendAPI);
+
+    buffered(baselineDiags[i].lookupTables,
+             [&]() { base.buildLookupTables(); });
+    if (testTarget != testTargets.end())
+      buffered(testDiags[testIndex].lookupTables,
+               [&]() { current.buildLookupTables(); });
+    buffered(differences[i], [&]() {
+      current.diagnoseDifferences(base.databases.front(),
+                                  compareConfigFileReader.get());
+    });
+  }
 
-    db->diagnoseDifferences(base);
+  // Read the remaining targets of the test SDKDB for their warnings, and all
+  // targets before a failed one because they would have been read first.
+  for (size_t i = 0; i != testErrIndex; ++i) {
+    if (testRead[i])
+      continue;
+    SDKDBBuilder current(diag);
+    if (auto err = readTest(i, current)) {
+      setError(testErr, std::move(err));
+      testErrIndex = i;
+      break;
+    }
+    if (!baselineErr && !current.databases.empty())
+      buffered(testDiags[i].lookupTables,
+               [&]() { current.buildLookupTables(); });
   }
 
+  auto emit = [&](const Diagnostics &diags) {
+    for (const auto &storedDiag : diags)
+      diag.emit(storedDiag);
+  };
+  for (size_t i = 0, e = testTargets.size(); i != e && i <= testErrIndex; ++i)
+    emit(testDiags[i].materialize);
+  if (testErr) {
+    consumeError(std::move(baselineErr));
+    return std::move(testErr);
+  }
+
+  for (const auto &diags : baselineDiags)
+    emit(diags.materialize);
+  if (baselineErr) {
+    baselineFailed = true;
+    return std::move(baselineErr);
+  }
+
+  for (const auto &diags : baselineDiags)
+    emit(diags.lookupTables);
+  for (const auto &diags : testDiags)
+    emit(diags.lookupTables);
+  for (const auto &diags : differences)
+    emit(diags);
+
   return !diag.hasErrorOccurred();
 }
 
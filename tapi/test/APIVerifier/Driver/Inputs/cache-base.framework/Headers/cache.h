@@ -0,0 +1,8 @@
+struct Point {
+  int x;
+  int y;
+};
+typedef struct Point Point;
+
+int distance(Point a, Point b);
+int changed(void);
@@ -0,0 +1,3 @@
+#include <Shared/Shared.h>
+
+int uses_shared(void);
@@ -0,0 +1,60 @@
+// RUN: %tapi-frontend -target x86_64-apple-macos10.15 -target x86_64-apple-ios13.0-macabi -verify -no-print %s 2>&1 | FileCheck %s
+
+// The methods and properties of Outer refer to interfaces that are declared
+// later, so they are only indexed while Outer is compared. Enough of them are
+// declared to make the index grow in the middle of the comparison. Their
+// methods are declared in a different order for each target, so their
+// fingerprints differ and they are compared member by member, but they are
+// still equivalent.
+
+#define CLASS(N) @class Inner##N;
+#define CLASS8(N)                                                              \
+  CLASS(N##0) CLASS(N##1) CLASS(N##2) CLASS(N##3)                              \
+  CLASS(N##4) CLASS(N##5) CLASS(N##6) CLASS(N##7)
+
+CLASS8(1) CLASS8(2) CLASS8(3) CLASS8(4) CLASS8(5) CLASS8(6) CLASS8(7) CLASS8(8)
+CLASS8(9)
+
+#define METHOD(N) -(Inner##N *)get##N;
+#define METHOD8(N)                                                             \
+  METHOD(N##0) METHOD(N##1) METHOD(N##2) METHOD(N##3)                          \
+  METHOD(N##4) METHOD(N##5) METHOD(N##6) METHOD(N##7)
+
+#define PROPERTY(N) @property Inner##N *prop##N;
+#define PROPERTY8(N)                                                           \
+  PROPERTY(N##0) PROPERTY(N##1) PROPERTY(N##2) PROPERTY(N##3)                  \
+  PROPERTY(N##4) PROPERTY(N##5) PROPERTY(N##6) PROPERTY(N##7)
+
+// CHECK: nested-containers.m:[[@LINE+1]]:12: warning: 'Outer' has incompatible definitions
+@interface Outer
+METHOD8(1) METHOD8(2) METHOD8(3) METHOD8(4) METHOD8(5) METHOD8(6) METHOD8(7)
+METHOD8(8) METHOD8(9)
+PROPERTY8(1) PROPERTY8(2) PROPERTY8(3) PROPERTY8(4) PROPERTY8(5) PROPERTY8(6)
+PROPERTY8(7) PROPERTY8(8) PROPERTY8(9)
+#if !__is_target_environment(macabi)
+// CHECK: nested-containers.m:[[@LINE+1]]:4: note: return value has type 'int' here
+- (int)mismatchRet;
+#else
+// CHECK: nested-containers.m:[[@LINE+1]]:4: note: return value has type 'void' here
+- (void)mismatchRet;
+#endif
+@end
+
+#if !__is_target_environment(macabi)
+#define INNER_METHODS - (int)value; - (int)other;
+#else
+#define INNER_METHODS - (int)other; - (int)value;
+#endif
+
+#define INNER(N)                                                               \
+  @interface Inner##N                                                          \
+  INNER_METHODS                                                                \
+  @property int count;                                                         \
+  @end
+
+#define INNER8(N)                                                              \
+  INNER(N##0) INNER(N##1) INNER(N##2) INNER(N##3)                              \
+  INNER(N##4) INNER(N##5) INNER(N##6) INNER(N##7)
+
+INNER8(1) INNER8(2) INNER8(3) INNER8(4) INNER8(5) INNER8(6) INNER8(7) INNER8(8)
+INNER8(9)
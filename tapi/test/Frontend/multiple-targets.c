@@ -0,0 +1,48 @@
+// RUN: rm -f %t.json
+// RUN: %tapi-frontend -target i386-apple-macos10.12 \
+// RUN:   -target x86_64-apple-macos10.15 -target x86_64-apple-ios13.0-macabi \
+// RUN:   -v -no-print -json %t.json %s 2>&1 | FileCheck %s
+// RUN: FileCheck --check-prefix=JSON %s < %t.json
+
+// Without -v the targets are parsed concurrently, and their diagnostics are
+// still printed in target order.
+// RUN: not %tapi-frontend -target i386-apple-macos10.12 \
+// RUN:   -target x86_64-apple-macos10.15 -target x86_64-apple-ios13.0-macabi \
+// RUN:   -Xparser -DDIAGNOSE -no-print %s 2>&1 \
+// RUN:   | FileCheck --check-prefix=DIAG %s
+
+// The output of every target, including the header search list that clang
+// prints itself, is in target order.
+// CHECK:      clang Invocation:
+// CHECK:      "-triple" "i386-apple-macosx10.12
+// CHECK:      #include <...> search starts here:
+// CHECK:      End of search list.
+// CHECK:      clang Invocation:
+// CHECK:      "-triple" "x86_64-apple-macosx10.15
+// CHECK:      #include <...> search starts here:
+// CHECK:      End of search list.
+// CHECK:      clang Invocation:
+// CHECK:      "-triple" "x86_64-apple-ios13.0
+// CHECK:      #include <...> search starts here:
+// CHECK:      End of search list.
+
+// JSON:       "target": "i386-apple-macos
+// JSON:       "target": "x86_64-apple-macos
+// JSON:       "target": "x86_64-apple-ios
+
+// DIAG:      warning: "diagnosing i386"
+// DIAG:      warning: "diagnosing x86_64"
+// DIAG:      error: "diagnosing macabi"
+// DIAG-NOT:  diagnosing
+
+#ifdef DIAGNOSE
+#if __is_target_environment(macabi)
+#error "diagnosing macabi"
+#elif defined(__i386__)
+#warning "diagnosing i386"
+#else
+#warning "diagnosing x86_64"
+#endif
+#endif
+
+void foo(void);
@@ -14,10 +14,12 @@
 //===----------------------------------------------------------------------===//
 #include "tapi/Core/API.h"
 #include "tapi/Core/APIJSONSerializer.h"
+#include "tapi/Core/JSONStreamReader.h"
 #include "tapi/Diagnostics/Diagnostics.h"
 #include "tapi/SDKDB/PartialSDKDB.h"
 #include "tapi/SDKDB/SDKDB.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FormatVariadic.h"
 #include "llvm/Support/JSON.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Process.h"
@@ -37,6 +39,12 @@ static cl::opt<bool> isPartialSDKDB("partial-sdkdb",
 static cl::opt<bool> isFullSDKDB("sdkdb", cl::desc("input is complete sdkdb"),
                                  cl::cat(tapiCategory));
 
+static cl::opt<bool>
+    streamInputs("stream",
+                 cl::desc("compare complete sdkdb inputs incrementally, in "
+                          "the order tapi writes them"),
+                 cl::cat(tapiCategory));
+
 static cl::opt<std::string> lhsInputFilename(cl::Positional,
                                              cl::desc("<input file1>"),
                                              cl::cat(tapiCategory));
@@ -129,10 +137,10 @@ bool checkPartialsEquality(const Partials &lhs, const Partials &rhs) {
 }
 
 Expected<std::unique_ptr<const API>> loadFullAPI(const StringRef filePath) {
-  auto jsonOrErr = loadJSON(filePath);
-  if (!jsonOrErr)
-    return jsonOrErr.takeError();
-  auto apiOrErr = APIJSONSerializer::parse(jsonOrErr->get());
+  auto bufferOrErr = loadFile(filePath);
+  if (!bufferOrErr)
+    return bufferOrErr.takeError();
+  auto apiOrErr = APIJSONSerializer::parse((*bufferOrErr)->getBuffer());
   if (!apiOrErr)
     return apiOrErr.takeError();
   return std::make_unique<const API>(std::move(*apiOrErr));
@@ -184,6 +192,200 @@ Expected<bool> checkFullSDKDBEquality(const StringRef lhsPath,
   return true;
 }
 
+/// Reads the APIs of a complete SDKDB one at a time, so only the APIs being
+/// compared are in memory.
+class SDKDBStream {
+public:
+  SDKDBStream(std::unique_ptr<MemoryBuffer> buffer)
+      : buffer(std::move(buffer)), reader(this->buffer->getBuffer()) {}
+
+  Error start() {
+    // The "public" flag changes how the APIs are read, but it may follow
+    // them, so look it up first.
+    JSONStreamReader scanner(buffer->getBuffer());
+    if (auto err = expect(scanner, JSONStreamReader::Token::ObjectBegin))
+      return err;
+    while (true) {
+      auto token = scanner.next();
+      if (!token)
+        return token.takeError();
+      if (*token == JSONStreamReader::Token::ObjectEnd)
+        break;
+      bool isPublicFlag = scanner.getValue() == "public";
+      token = scanner.next();
+      if (!token)
+        return token.takeError();
+      if (isPublicFlag)
+        publicOnly = scanner.getValue() == "true";
+      if (auto err = scanner.skipValue())
+        return err;
+    }
+
+    return expect(reader, JSONStreamReader::Token::ObjectBegin);
+  }
+
+  bool isPublicOnly() const { return publicOnly; }
+
+  /// Read the key of the next top-level entry, or None after the last one.
+  Expected<Optional<std::string>> nextEntry() {
+    auto token = reader.next();
+    if (!token)
+      return token.takeError();
+    if (*token == JSONStreamReader::Token::ObjectEnd)
+      return None;
+    return reader.getValue().str();
+  }
+
+  /// Parse the value of the current top-level entry.
+  Expected<json::Value> parseEntry() {
+    auto token = reader.next();
+    if (!token)
+      return token.takeError();
+    return reader.parseValue();
+  }
+
+  /// Start reading the APIs of the current top-level entry.
+  Error startAPIs() {
+    return expect(reader, JSONStreamReader::Token::ArrayBegin);
+  }
+
+  /// Read the next API of the current entry, or nullptr after the last one.
+  Expected<std::unique_ptr<API>> nextAPI(Triple &triple) {
+    auto token = reader.next();
+    if (!token)
+      return token.takeError();
+    if (*token == JSONStreamReader::Token::ArrayEnd)
+      return nullptr;
+
+    if (*token != JSONStreamReader::Token::ObjectBegin)
+      return make_error<APIJSONError>(
+          "SDKDB doesn't include correct API format");
+    auto text = reader.readRawValue();
+    if (!text)
+      return text.takeError();
+    auto api = APIJSONSerializer::parseObject(*text, publicOnly, &triple);
+    if (!api)
+      return api.takeError();
+    return std::make_unique<API>(std::move(*api));
+  }
+
+private:
+  static Error expect(JSONStreamReader &reader, JSONStreamReader::Token kind) {
+    auto token = reader.next();
+    if (!token)
+      return token.takeError();
+    if (*token != kind)
+      return make_error<APIJSONError>("unexpected SDKDB format");
+    return Error::success();
+  }
+
+  std::unique_ptr<MemoryBuffer> buffer;
+  JSONStreamReader reader;
+  bool publicOnly = false;
+};
+
+Expected<std::unique_ptr<SDKDBStream>> openSDKDB(StringRef filePath) {
+  auto bufferOrErr = loadFile(filePath);
+  if (!bufferOrErr)
+    return bufferOrErr.takeError();
+  auto stream = std::make_unique<SDKDBStream>(std::move(*bufferOrErr));
+  if (auto err = stream->start())
+    return std::move(err);
+  return std::move(stream);
+}
+
+static std::string describeAPI(const API &api) {
+  return api.getInstallName().value_or(api.getProjectName()).str();
+}
+
+/// Compare the APIs of two complete SDKDBs one pair at a time. Both inputs
+/// must list the targets and their APIs in the order the SDKDB serializer
+/// writes them. Returns the path of the first difference, or None if the
+/// inputs are equal.
+Expected<Optional<std::string>> streamFullSDKDBEquality(StringRef lhsPath,
+                                                        StringRef rhsPath) {
+  auto lhs = openSDKDB(lhsPath);
+  if (!lhs) {
+    errs() << lhsPath << ": ";
+    return lhs.takeError();
+  }
+  auto rhs = openSDKDB(rhsPath);
+  if (!rhs) {
+    errs() << rhsPath << ": ";
+    return rhs.takeError();
+  }
+
+  if ((*lhs)->isPublicOnly() != (*rhs)->isPublicOnly())
+    return std::string("public");
+
+  while (true) {
+    auto lhsKey = (*lhs)->nextEntry();
+    if (!lhsKey)
+      return lhsKey.takeError();
+    auto rhsKey = (*rhs)->nextEntry();
+    if (!rhsKey)
+      return rhsKey.takeError();
+
+    if (!*lhsKey && !*rhsKey)
+      return None;
+    if (!*lhsKey || !*rhsKey || **lhsKey != **rhsKey) {
+      // Report the entry that only one side has.
+      if (!*rhsKey || (*lhsKey && **lhsKey < **rhsKey))
+        return **lhsKey;
+      return **rhsKey;
+    }
+
+    StringRef key = **lhsKey;
+    if (key == "public" || key == "projectWithError") {
+      auto lhsValue = (*lhs)->parseEntry();
+      if (!lhsValue)
+        return lhsValue.takeError();
+      auto rhsValue = (*rhs)->parseEntry();
+      if (!rhsValue)
+        return rhsValue.takeError();
+      if (*lhsValue != *rhsValue)
+        return key.str();
+      continue;
+    }
+
+    if (auto err = (*lhs)->startAPIs())
+      return std::move(err);
+    if (auto err = (*rhs)->startAPIs())
+      return std::move(err);
+
+    Triple triple(key);
+    std::unique_ptr<API> lhsPrevious, rhsPrevious;
+    for (unsigned index = 0;; ++index) {
+      auto lhsAPI = (*lhs)->nextAPI(triple);
+      if (!lhsAPI)
+        return lhsAPI.takeError();
+      auto rhsAPI = (*rhs)->nextAPI(triple);
+      if (!rhsAPI)
+        return rhsAPI.takeError();
+
+      if (!*lhsAPI && !*rhsAPI)
+        break;
+      if (!*lhsAPI || !*rhsAPI) {
+        const auto &extra = *lhsAPI ? **lhsAPI : **rhsAPI;
+        return formatv("{0}[{1}] {2}", key, index, describeAPI(extra)).str();
+      }
+
+      // Out of order APIs would be reported as differences.
+      if ((lhsPrevious && **lhsAPI < *lhsPrevious) ||
+          (rhsPrevious && **rhsAPI < *rhsPrevious))
+        return make_error<APIJSONError>(
+            "APIs are not in canonical order; compare without -stream");
+
+      if (auto diff = (*lhsAPI)->findFirstDifference(**rhsAPI))
+        return formatv("{0}[{1}] {2}: {3}", key, index,
+                       describeAPI(**lhsAPI), *diff)
+            .str();
+      lhsPrevious = std::move(*lhsAPI);
+      rhsPrevious = std::move(*rhsAPI);
+    }
+  }
+}
+
 template <typename ApiT>
 std::unique_ptr<const ApiT>
 handleInput(const StringRef fileName,
@@ -224,6 +426,18 @@ Status loadAndCompareFullSDKDB() {
   return Status::Inequal;
 }
 
+Status streamAndCompareFullSDKDB() {
+  auto result = streamFullSDKDBEquality(lhsInputFilename, rhsInputFilename);
+  if (auto error = result.takeError()) {
+    errs() << toString(std::move(error)) << "\n";
+    return Status::InputError;
+  }
+  if (!*result)
+    return Status::Equal;
+  outs() << "first difference: " << **result << "\n";
+  return Status::Inequal;
+}
+
 Status loadAndCompareAPI() {
   // Handle basic API as JSON input.
   auto lhsAPI =
@@ -260,11 +474,17 @@ int main(int argc, const char *argv[]) {
     return 0;
   }
 
+  if (streamInputs && (!isFullSDKDB || isPartialSDKDB)) {
+    errs() << "error: -stream requires -sdkdb\n";
+    return 1;
+  }
+
   if (isPartialSDKDB)
     return loadAndComparePartialSDKDB();
 
   if (isFullSDKDB)
-    return loadAndCompareFullSDKDB();
+    return streamInputs ? streamAndCompareFullSDKDB()
+                        : loadAndCompareFullSDKDB();
 
   return loadAndCompareAPI();
 }
@@ -18,11 +18,13 @@
 #include "tapi/Core/HeaderFile.h"
 #include "tapi/Diagnostics/Diagnostics.h"
 #include "tapi/Frontend/Frontend.h"
+#include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Process.h"
@@ -141,29 +143,61 @@ int main(int argc, const char *argv[]) {
     return 0;
   }
 
-  std::vector<FrontendContext> results;
   HeaderSeq headers;
   SmallString<PATH_MAX> fullPath(inputFilename);
   clang::FileManager fm((clang::FileSystemOptions()));
   fm.makeAbsolutePath(fullPath);
   headers.emplace_back(inputFilename, HeaderType::Public);
-  for (const auto &target : targets) {
-    FrontendJob job;
-    job.target = Triple(target);
+  auto clangResourcePath = getClangResourcesPath(fm);
+  std::vector<FrontendJob> jobs(targets.size());
+  for (size_t i = 0, e = targets.size(); i != e; ++i) {
+    auto &job = jobs[i];
+    job.target = Triple(targets[i]);
     job.isysroot = isysroot;
     job.language_std = language_std;
     job.verbose = verbose;
     job.clangExtraArgs = xparser;
     job.headerFiles = headers;
-    job.clangResourcePath = getClangResourcesPath(fm);
-    auto contextOrError = runFrontend(job, inputFilename);
-    if (auto err = contextOrError.takeError()) {
-      if (canIgnoreFrontendError(err))
-        continue;
-      return -1;
+    job.clangResourcePath = clangResourcePath;
+  }
+
+  // Run the frontend for all targets concurrently. The diagnostics of each
+  // target are buffered and printed in the order of the targets. The verbose
+  // output of clang, like the header search list, and the header dump go
+  // straight to the standard streams, so run the targets one by one with -v.
+  std::vector<Optional<Expected<FrontendContext>>> contexts(jobs.size());
+  std::vector<std::string> diagnostics(jobs.size());
+  if (jobs.size() == 1 || verbose) {
+    for (size_t i = 0, e = jobs.size(); i != e; ++i)
+      contexts[i].emplace(runFrontend(jobs[i], inputFilename));
+  } else {
+    parallelFor(0, jobs.size(), [&](size_t i) {
+      raw_string_ostream diagStream(diagnostics[i]);
+      jobs[i].diagnosticStream = &diagStream;
+      contexts[i].emplace(runFrontend(jobs[i], inputFilename));
+      jobs[i].diagnosticStream = nullptr;
+    });
+  }
+
+  std::vector<FrontendContext> results;
+  bool hasError = false;
+  for (size_t i = 0, e = jobs.size(); i != e; ++i) {
+    auto &contextOrError = *contexts[i];
+    auto err = contextOrError.takeError();
+    // Stop at the first target that failed, like running them one by one.
+    if (hasError) {
+      consumeError(std::move(err));
+      continue;
+    }
+    errs() << diagnostics[i];
+    if (err) {
+      hasError = !canIgnoreFrontendError(err);
+      continue;
     }
     results.emplace_back(std::move(*contextOrError));
   }
+  if (hasError)
+    return -1;
 
   if (verify) {
     if (results.size() != 2) {
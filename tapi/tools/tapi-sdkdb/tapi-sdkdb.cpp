@@ -247,13 +247,20 @@ int main(int argc, const char *argv[]) {
       option.targets.push_back(Triple(tt));
     for (auto &name : apiNames)
       option.installNames.insert(name);
+    // Printing only reads the SDKDB, so stream it from a view instead of
+    // materializing the whole SDKDB.
+    auto viewOrError = SDKDBBitcodeView::get((*file)->getMemBufferRef());
+    if (!viewOrError) {
+      errs() << "cannot read SDKDB: " << toString(viewOrError.takeError())
+             << "\n";
+      return 1;
+    }
     DiagnosticsEngine diag(errs());
-    SDKDBBuilder builder(diag);
-    if (auto err = reader->materialize(builder)) {
+    if (auto err = (*viewOrError)->serialize(outs(), /*compact*/ false,
+                                             option, diag)) {
       errs() << "cannot read SDKDB: " << toString(std::move(err)) << "\n";
       return 1;
     }
-    builder.serialize(outs(), /*compact*/ false);
     break;
   }
   case Compare: {
@@ -281,22 +288,12 @@ int main(int argc, const char *argv[]) {
     }
     auto *base = baseOrError->get();
 
-    // materialize SDKDBs.
     DiagnosticsEngine diag(errs());
     if (!diagOut.empty())
       diag.setupDiagnosticsFile(diagOut);
 
+    // The SDKDBs are materialized one target at a time while comparing.
     SDKDBBuilder builder(diag);
-    if (auto err = reader->materialize(builder)) {
-      errs() << "cannot read SDKDB: " << toString(std::move(err)) << "\n";
-      return 1;
-    }
-    SDKDBBuilder baseline(diag);
-    if (auto err = base->materialize(baseline)) {
-      errs() << "cannot read baseline SDKDB: " << toString(std::move(err))
-             << "\n";
-      return 1;
-    }
 
     // Read config file if provided
     if (!compareConfigFile.empty()) {
@@ -319,7 +316,15 @@ int main(int argc, const char *argv[]) {
     builder.setNoNewAPI(noNewAPI);
     builder.setReportNewAPIasError(newAPIAsError);
     builder.setDiagnoseFrontendAPI(compareFrontendAPI);
-    if (!builder.diagnoseDifferences(baseline))
+    bool baselineFailed;
+    auto result = builder.diagnoseDifferences(*reader, *base, baselineFailed);
+    if (!result) {
+      errs() << (baselineFailed ? "cannot read baseline SDKDB: "
+                                : "cannot read SDKDB: ")
+             << toString(result.takeError()) << "\n";
+      return 1;
+    }
+    if (!*result)
       return 1;
 
     break;
@@ -59,4 +59,29 @@ TEST(JSON, Serializer2) {
   EXPECT_STREQ((*inputBuf)->getBuffer().str().c_str(), os.str().c_str());
 }
 
+// Round trip an API object without format version and target, as it is
+// written into an SDKDB.
+TEST(JSON, SerializeObject) {
+  SmallVector<char, PATH_MAX> inputPath;
+  llvm::sys::path::append(inputPath, INPUT_PATH, "frontend.json");
+  auto inputBuf = MemoryBuffer::getFile(inputPath);
+  EXPECT_TRUE(inputBuf);
+
+  auto api = APIJSONSerializer::parse((*inputBuf)->getBuffer());
+  EXPECT_FALSE(!api);
+
+  std::string output;
+  raw_string_ostream os(output);
+  APIJSONOption options{};
+  options.noTarget = true;
+  json::OStream out(os);
+  APIJSONSerializer(*api, options).serialize(out);
+
+  auto triple = api->getTriple();
+  auto result = APIJSONSerializer::parseObject(os.str(), false, &triple);
+  EXPECT_FALSE(!result);
+  EXPECT_TRUE(*api == *result);
+  EXPECT_EQ(std::string::npos, os.str().find("api_json_version"));
+}
+
 } // end anonymous namespace.
@@ -0,0 +1,133 @@
+//===- unittests/JSON/JSONStreamReader.cpp - JSON Stream Reader Test ------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "tapi/Core/JSONStreamReader.h"
+
+#include "llvm/ADT/StringRef.h"
+#include "gtest/gtest.h"
+#include <string>
+#define DEBUG_TYPE "json-stream-reader-test"
+
+using namespace llvm;
+using namespace tapi::internal;
+
+namespace {
+
+using Token = JSONStreamReader::Token;
+
+// Read all tokens and render them back into compact JSON.
+static std::string render(StringRef input) {
+  JSONStreamReader reader(input);
+  std::string output;
+  bool needsComma = false;
+  while (true) {
+    auto token = reader.next();
+    if (!token)
+      return "error: " + toString(token.takeError());
+
+    if (needsComma && *token != Token::ObjectEnd &&
+        *token != Token::ArrayEnd && *token != Token::EndOfInput)
+      output += ",";
+    needsComma = true;
+    switch (*token) {
+    case Token::ObjectBegin:
+      output += "{";
+      needsComma = false;
+      break;
+    case Token::ObjectEnd:
+      output += "}";
+      break;
+    case Token::ArrayBegin:
+      output += "[";
+      needsComma = false;
+      break;
+    case Token::ArrayEnd:
+      output += "]";
+      break;
+    case Token::Key:
+      output += "\"" + reader.getValue().str() + "\":";
+      needsComma = false;
+      break;
+    case Token::String:
+      output += "\"" + reader.getValue().str() + "\"";
+      break;
+    case Token::Number:
+    case Token::Boolean:
+      output += reader.getValue().str();
+      break;
+    case Token::Null:
+      output += "null";
+      break;
+    case Token::EndOfInput:
+      return output;
+    }
+  }
+}
+
+TEST(JSONStreamReader, Tokens) {
+  EXPECT_EQ(R"({"a":[1,-2.5e+3,true,false,null],"b":{},"c":[]})",
+            render(R"( { "a" : [ 1, -2.5e+3, true, false, null ],
+                        "b" : { }, "c" : [ ] } )"));
+  EXPECT_EQ(R"("text")", render(R"("text")"));
+  EXPECT_EQ("42", render("42"));
+}
+
+TEST(JSONStreamReader, Escapes) {
+  JSONStreamReader reader(R"(["a\"b\\c\/\n", "é😀", "\ud800"])");
+  ASSERT_EQ(Token::ArrayBegin, *reader.next());
+  ASSERT_EQ(Token::String, *reader.next());
+  EXPECT_EQ("a\"b\\c/\n", reader.getValue());
+  ASSERT_EQ(Token::String, *reader.next());
+  EXPECT_EQ("\xc3\xa9\xf0\x9f\x98\x80", reader.getValue());
+  ASSERT_EQ(Token::String, *reader.next());
+  EXPECT_EQ("\xef\xbf\xbd", reader.getValue());
+  ASSERT_EQ(Token::ArrayEnd, *reader.next());
+  ASSERT_EQ(Token::EndOfInput, *reader.next());
+}
+
+TEST(JSONStreamReader, Errors) {
+  EXPECT_EQ("error: [1:6, byte=6]: Expected , or ] after array element",
+            render("[1, 2 3]"));
+  EXPECT_EQ("error: [1:1, byte=1]: Expected object key", render("{1: 2}"));
+  EXPECT_EQ("error: [2:1, byte=4]: Text after end of document",
+            render("{}\n 1"));
+  EXPECT_EQ("error: [1:7, byte=7]: Unterminated string", render("[\"abc\\n"));
+  EXPECT_EQ("error: [1:1, byte=1]: Invalid JSON value", render("[tru]"));
+}
+
+TEST(JSONStreamReader, SkipAndParseValues) {
+  JSONStreamReader reader(
+      R"({"skip": {"a": [1, {"b": 2}]}, "parse": [{"c": "d"}, 3], "e": 4})");
+  ASSERT_EQ(Token::ObjectBegin, *reader.next());
+
+  ASSERT_EQ(Token::Key, *reader.next());
+  EXPECT_EQ("skip", reader.getValue());
+  ASSERT_EQ(Token::ObjectBegin, *reader.next());
+  EXPECT_FALSE(reader.skipValue());
+
+  ASSERT_EQ(Token::Key, *reader.next());
+  EXPECT_EQ("parse", reader.getValue());
+  ASSERT_EQ(Token::ArrayBegin, *reader.next());
+  ASSERT_EQ(Token::ObjectBegin, *reader.next());
+  auto value = reader.parseValue();
+  ASSERT_TRUE(!!value);
+  EXPECT_EQ(json::Value(json::Object{{"c", "d"}}), *value);
+  ASSERT_EQ(Token::Number, *reader.next());
+  value = reader.parseValue();
+  ASSERT_TRUE(!!value);
+  EXPECT_EQ(json::Value(3), *value);
+  ASSERT_EQ(Token::ArrayEnd, *reader.next());
+
+  ASSERT_EQ(Token::Key, *reader.next());
+  EXPECT_EQ("e", reader.getValue());
+  ASSERT_EQ(Token::Number, *reader.next());
+  ASSERT_EQ(Token::ObjectEnd, *reader.next());
+  ASSERT_EQ(Token::EndOfInput, *reader.next());
+}
+
+} // end anonymous namespace.
@@ -0,0 +1,136 @@
+//===- unittests/TapiCore/API2SymbolConverter.cpp - Converter Tests -------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+#include "tapi/Core/API2SymbolConverter.h"
+#include "tapi/Core/API.h"
+#include "llvm/ADT/Triple.h"
+#include "gtest/gtest.h"
+#include <memory>
+#include <vector>
+#define DEBUG_TYPE "api2symbolconverter-test"
+
+using namespace llvm;
+using namespace llvm::MachO;
+using namespace tapi::internal;
+
+namespace {
+struct TargetInput {
+  Triple triple;
+  /// Records the undefined symbols, like a flat namespace library.
+  bool recordUndefs;
+  SymbolFlags fooFlags;
+  bool hasBar;
+};
+} // end anonymous namespace.
+
+static std::unique_ptr<API> createAPI(const TargetInput &input) {
+  auto api = std::make_unique<API>(input.triple);
+  api->addGlobal("_foo", input.fooFlags, APILoc(), AvailabilityInfo(),
+                 APIAccess::Public, nullptr, GVKind::Function,
+                 APILinkage::Exported);
+  if (input.hasBar)
+    api->addGlobal("_bar", SymbolFlags::Data, APILoc(), AvailabilityInfo(),
+                   APIAccess::Public, nullptr, GVKind::Variable,
+                   APILinkage::Exported);
+  api->addGlobal("_undef", SymbolFlags::Text, APILoc(), AvailabilityInfo(),
+                 APIAccess::Public, nullptr, GVKind::Function,
+                 APILinkage::External);
+
+  auto *interface = api->addObjCInterface(
+      "Foo", APILoc(), AvailabilityInfo(), APIAccess::Public,
+      APILinkage::Exported, "NSObject", nullptr);
+  interface->hasExceptionAttribute = true;
+  auto *category = api->addObjCCategory("Foo", "Cat", APILoc(),
+                                        AvailabilityInfo(), APIAccess::Public,
+                                        nullptr);
+  api->addObjCInstanceVariable(category, "_catIvar", APILoc(),
+                               AvailabilityInfo(), APIAccess::Public,
+                               clang::ObjCIvarDecl::Public,
+                               APILinkage::Exported, nullptr);
+  return api;
+}
+
+static const std::vector<TargetInput> inputs = {
+    {Triple("x86_64-apple-macos10.15"), /*recordUndefs=*/true,
+     SymbolFlags::Text | SymbolFlags::WeakDefined, /*hasBar=*/false},
+    {Triple("arm64-apple-macos11"), /*recordUndefs=*/false, SymbolFlags::Text,
+     /*hasBar=*/true},
+};
+
+TEST(API2SymbolConverter, merge_targets) {
+  SymbolSet symbols;
+  API2SymbolConverter converter(&symbols);
+  for (const auto &input : inputs) {
+    auto api = createAPI(input);
+    converter.setTarget(Target(input.triple), input.recordUndefs);
+    api->visit(converter);
+  }
+  converter.finish();
+
+  Target first(inputs[0].triple);
+  Target second(inputs[1].triple);
+
+  // The flags of the first target win.
+  auto *foo = symbols.findSymbol(SymbolKind::GlobalSymbol, "_foo");
+  ASSERT_NE(foo, nullptr);
+  EXPECT_TRUE(foo->isWeakDefined());
+  EXPECT_TRUE(foo->hasTarget(first));
+  EXPECT_TRUE(foo->hasTarget(second));
+
+  auto *bar = symbols.findSymbol(SymbolKind::GlobalSymbol, "_bar");
+  ASSERT_NE(bar, nullptr);
+  EXPECT_FALSE(bar->hasTarget(first));
+  EXPECT_TRUE(bar->hasTarget(second));
+
+  // Undefined symbols are only recorded for the flat namespace target.
+  auto *undef = symbols.findSymbol(SymbolKind::GlobalSymbol, "_undef");
+  ASSERT_NE(undef, nullptr);
+  EXPECT_TRUE(undef->isUndefined());
+  EXPECT_TRUE(undef->hasTarget(first));
+  EXPECT_FALSE(undef->hasTarget(second));
+
+  for (auto kind :
+       {SymbolKind::ObjectiveCClass, SymbolKind::ObjectiveCClassEHType}) {
+    auto *symbol = symbols.findSymbol(kind, "Foo");
+    ASSERT_NE(symbol, nullptr);
+    EXPECT_TRUE(symbol->hasTarget(first));
+    EXPECT_TRUE(symbol->hasTarget(second));
+  }
+
+  // The ivars of categories are recorded with the name of their class.
+  auto *ivar = symbols.findSymbol(SymbolKind::ObjectiveCInstanceVariable,
+                                  "Foo._catIvar");
+  ASSERT_NE(ivar, nullptr);
+  EXPECT_TRUE(ivar->hasTarget(first));
+  EXPECT_TRUE(ivar->hasTarget(second));
+}
+
+TEST(API2SymbolConverter, merge_targets_matches_single_target) {
+  SymbolSet merged;
+  API2SymbolConverter converter(&merged);
+  for (const auto &input : inputs) {
+    auto api = createAPI(input);
+    converter.setTarget(Target(input.triple), input.recordUndefs);
+    api->visit(converter);
+  }
+  converter.finish();
+
+  SymbolSet expected;
+  for (const auto &input : inputs) {
+    auto api = createAPI(input);
+    API2SymbolConverter singleTarget(&expected, Target(input.triple),
+                                     input.recordUndefs);
+    api->visit(singleTarget);
+  }
+
+  EXPECT_EQ(merged.size(), expected.size());
+  for (const auto *symbol : expected.symbols()) {
+    auto *result = merged.findSymbol(symbol->getKind(), symbol->getName());
+    ASSERT_NE(result, nullptr) << symbol->getName().str();
+    EXPECT_EQ(*symbol, *result) << symbol->getName().str();
+  }
+}
@@ -45,3 +45,22 @@ TEST(FileSystem, make_relative) {
   make_relative(src, dst, result);
   EXPECT_STREQ(result.c_str(), "path2/bar");
 }
+
+TEST(FileSystem, DirectoryPrefixSet) {
+  DirectoryPrefixSet set;
+  EXPECT_TRUE(set.empty());
+  EXPECT_FALSE(set.contains("/some/path"));
+
+  set.insert("/some/path/Foo.framework");
+  set.insert("/other/path/");
+  EXPECT_FALSE(set.empty());
+
+  EXPECT_TRUE(set.contains("/some/path/Foo.framework"));
+  EXPECT_TRUE(set.contains("/some/path/Foo.framework/Headers/Foo.h"));
+  EXPECT_TRUE(set.contains("/other/path"));
+  EXPECT_TRUE(set.contains("/other/path/file"));
+  EXPECT_FALSE(set.contains("/some/path"));
+  EXPECT_FALSE(set.contains("/some/path/FooKit.framework/FooKit"));
+  EXPECT_FALSE(set.contains("/other"));
+  EXPECT_FALSE(set.contains("some/path/Foo.framework"));
+}
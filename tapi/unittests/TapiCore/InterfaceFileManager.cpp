@@ -0,0 +1,68 @@
+//===- unittests/TapiCore/InterfaceFileManager.cpp - Manager Tests --------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+#include "tapi/Core/InterfaceFileManager.h"
+#include "tapi/Core/FileManager.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+#define DEBUG_TYPE "interface-file-manager-test"
+
+using namespace llvm;
+using namespace tapi::internal;
+
+static void writeStub(StringRef path, StringRef symbols) {
+  std::error_code ec;
+  raw_fd_ostream os(path, ec);
+  ASSERT_FALSE(ec);
+  os << "--- !tapi-tbd\n"
+        "tbd-version: 4\n"
+        "targets: [ x86_64-macos ]\n"
+        "install-name: /usr/lib/libfoo.dylib\n"
+        "exports:\n"
+        "  - targets: [ x86_64-macos ]\n"
+        "    symbols: [ "
+     << symbols << " ]\n...\n";
+}
+
+TEST(InterfaceFileManager, reuse_unchanged_files) {
+  SmallString<PATH_MAX> directory;
+  ASSERT_FALSE(
+      sys::fs::createUniqueDirectory("interface-file-manager", directory));
+  SmallString<PATH_MAX> path(directory);
+  sys::path::append(path, "libfoo.tbd");
+  writeStub(path, "_foo");
+
+  IntrusiveRefCntPtr<FileManager> fm(
+      new FileManager(clang::FileSystemOptions()));
+  InterfaceFileManager manager(*fm, /*isVolatile=*/true);
+  auto first = manager.readFile(std::string(path));
+  ASSERT_TRUE(!!first);
+  auto api = *first->begin();
+
+  // An unchanged file isn't read again, even with the file manager of the
+  // next command.
+  IntrusiveRefCntPtr<FileManager> nextFM(
+      new FileManager(clang::FileSystemOptions()));
+  manager.setFileManager(*nextFM, /*isVolatile=*/true);
+  auto second = manager.readFile(std::string(path));
+  ASSERT_TRUE(!!second);
+  EXPECT_EQ(api, *second->begin());
+
+  // A changed file is read again.
+  writeStub(path, "_foo, _bar");
+  IntrusiveRefCntPtr<FileManager> lastFM(
+      new FileManager(clang::FileSystemOptions()));
+  manager.setFileManager(*lastFM, /*isVolatile=*/true);
+  auto third = manager.readFile(std::string(path));
+  ASSERT_TRUE(!!third);
+  EXPECT_NE(api, *third->begin());
+
+  sys::fs::remove_directories(directory);
+}
@@ -6,7 +6,10 @@
 //
 //===----------------------------------------------------------------------===//
 #include "tapi/Core/Utils.h"
+#include "tapi/Core/FileManager.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/VirtualFileSystem.h"
 #include "gtest/gtest.h"
 #define DEBUG_TYPE "utils-test"
 
@@ -116,3 +119,37 @@ TEST(Utils, isWithinPublicLocation) {
   for (const char *path : nonPublicSDKPaths)
     EXPECT_FALSE(isWithinPublicLocation(path));
 }
+
+TEST(Utils, findLibrary) {
+  IntrusiveRefCntPtr<vfs::InMemoryFileSystem> fs(new vfs::InMemoryFileSystem);
+  auto addFile = [&](StringRef path) {
+    fs->addFile(path, /*ModificationTime=*/0, MemoryBuffer::getMemBuffer(""));
+  };
+  addFile("/SDK/Frameworks/Foo.framework/Foo");
+  addFile("/SDK/usr/lib/libbar.tbd");
+  addFile("/SDK/usr/lib/libbaz.dylib");
+  FileManager fm(clang::FileSystemOptions(), fs);
+
+  EXPECT_EQ("/SDK/Frameworks/Foo.framework/Foo",
+            findLibrary("/System/Library/Frameworks/Foo.framework/Foo", fm,
+                        {"/SDK/Missing", "/SDK/Frameworks"}, {}, {}));
+  EXPECT_EQ("/SDK/usr/lib/libbar.tbd",
+            findLibrary("/usr/lib/libbar.dylib", fm, {}, {"/SDK/usr/lib"}, {}));
+  EXPECT_EQ("/SDK/usr/lib/libbaz.dylib",
+            findLibrary("/usr/lib/libbaz.dylib", fm, {}, {}, {"/SDK"}));
+  EXPECT_TRUE(
+      findLibrary("/usr/lib/libqux.dylib", fm, {}, {"/SDK/usr/lib"}, {"/SDK"})
+          .empty());
+
+  // Files created after a directory was listed are only found once the
+  // listing is invalidated.
+  addFile("/SDK/Frameworks/Foo.framework/Foo.tbd");
+  addFile("/SDK/usr/lib/libqux.dylib");
+  fm.invalidateDirectoryListings("/SDK/Frameworks/Foo.framework/Foo.tbd");
+  fm.invalidateDirectoryListings("/SDK/usr/lib/libqux.dylib");
+  EXPECT_EQ("/SDK/Frameworks/Foo.framework/Foo.tbd",
+            findLibrary("/System/Library/Frameworks/Foo.framework/Foo", fm,
+                        {"/SDK/Frameworks"}, {}, {}));
+  EXPECT_EQ("/SDK/usr/lib/libqux.dylib",
+            findLibrary("/usr/lib/libqux.dylib", fm, {}, {"/SDK/usr/lib"}, {}));
+}
@@ -32,3 +32,41 @@ TEST(HeaderGlob, matchGlob) {
   EXPECT_FALSE(glob.get()->match({"/bar.c", HeaderType::Public}));
   EXPECT_FALSE(glob.get()->match({"/baz/bar.hpp", HeaderType::Public}));
 }
+
+TEST(HeaderGlob, matchSingleCharacter) {
+  auto glob = HeaderGlob::create("*.h", HeaderType::Public);
+  EXPECT_TRUE(!!glob);
+  EXPECT_FALSE(glob.get()->match({"fooh", HeaderType::Public}));
+  glob = HeaderGlob::create("/foo/**/bar?.h", HeaderType::Public);
+  EXPECT_TRUE(!!glob);
+  EXPECT_TRUE(glob.get()->match({"/foo/bar1.h", HeaderType::Public}));
+  EXPECT_TRUE(glob.get()->match({"/foo/baz/bar2.h", HeaderType::Public}));
+  EXPECT_FALSE(glob.get()->match({"/foo/bar.h", HeaderType::Public}));
+}
+
+TEST(HeaderGlob, matchGlobSet) {
+  HeaderGlobSet globs;
+  EXPECT_FALSE(globs.add("*.h", HeaderType::Public));
+  EXPECT_FALSE(globs.add("**/Internal/*.h", HeaderType::Public));
+  EXPECT_FALSE(globs.add("/baz/**", HeaderType::Private));
+  EXPECT_FALSE(globs.add("/qux/*.h", HeaderType::Private));
+  auto err = globs.add("/baz/bar.h", HeaderType::Public);
+  EXPECT_TRUE(!!err);
+  consumeError(std::move(err));
+
+  EXPECT_TRUE(globs.match({"foo.h", HeaderType::Public}));
+  EXPECT_FALSE(globs.match({"foo.h", HeaderType::Project}));
+  EXPECT_FALSE(globs.match({"/baz/bar.h", HeaderType::Public}));
+  EXPECT_TRUE(globs.match({"/baz/bar.h", HeaderType::Private}));
+  EXPECT_TRUE(globs.match({"/baz/bar/foo.h", HeaderType::Private}));
+
+  auto unmatched = globs.getUnmatchedGlobs();
+  ASSERT_EQ(2U, unmatched.size());
+  EXPECT_EQ("**/Internal/*.h", unmatched[0]);
+  EXPECT_EQ("/qux/*.h", unmatched[1]);
+
+  EXPECT_TRUE(globs.match({"/foo/Internal/foo.h", HeaderType::Public}));
+  unmatched = globs.getUnmatchedGlobs();
+  ASSERT_EQ(1U, unmatched.size());
+  EXPECT_EQ("/qux/*.h", unmatched[0]);
+}